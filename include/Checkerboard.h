@@ -0,0 +1,24 @@
+#ifndef CHECKERBOARD_H
+#define CHECKERBOARD_H
+
+#include <QBrush>
+#include <QRect>
+
+class QPainter;
+
+// Transparency checkerboard shared by every widget that shows alpha.
+//
+// The pattern is one 2x2-cell tile, rendered once per cell size and device
+// pixel ratio and then used as a tiled brush, so filling any area is a
+// single fillRect.
+class Checkerboard {
+public:
+    // Tiled brush of white and light gray cells of cellSize logical pixels
+    static QBrush brush(int cellSize, qreal devicePixelRatio = 1.0);
+
+    // Fills rect with the checkerboard, starting with a gray cell at its
+    // top-left corner, at the painter's device pixel ratio
+    static void paint(QPainter *painter, const QRect &rect, int cellSize);
+};
+
+#endif // CHECKERBOARD_H
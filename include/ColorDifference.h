@@ -0,0 +1,81 @@
+#ifndef COLORDIFFERENCE_H
+#define COLORDIFFERENCE_H
+
+#include "ColorSpace.h"
+#include <QColor>
+#include <QVector>
+
+// Batch color difference (Delta E) engine.
+//
+// Colors are first converted into a perceptual space, then compared with one
+// of the CIE metrics. OKLab coordinates are scaled by 100 so that distances in
+// both spaces share the same order of magnitude (a Delta E of ~2 is a just
+// noticeable difference in either space).
+class ColorDifference {
+public:
+    enum Metric {
+        CIE76,
+        CIE94,
+        CIEDE2000
+    };
+
+    enum Space {
+        CIELab,
+        OKLab
+    };
+
+    using Lab = ColorSpace::Lab;
+
+    // Convert colors into the coordinates used by the distance functions
+    static Lab toSpace(const QColor &color, Space space);
+    static QVector<Lab> toSpace(const QVector<QColor> &colors, Space space);
+
+    // Single pair
+    static float deltaE(const Lab &reference, const Lab &sample, Metric metric);
+    static float deltaE(const QColor &reference, const QColor &sample,
+                        Metric metric = CIEDE2000, Space space = CIELab);
+
+    // One-to-many: result[i] = deltaE(reference, samples[i])
+    static QVector<float> distances(const Lab &reference, const QVector<Lab> &samples,
+                                    Metric metric);
+
+    // Many-to-many: row-major matrix with rows.size() x columns.size() entries,
+    // result[r * columns.size() + c] = deltaE(rows[r], columns[c]).
+    // Large matrices are computed in parallel over row bands.
+    static QVector<float> distanceMatrix(const QVector<Lab> &rows, const QVector<Lab> &columns,
+                                         Metric metric);
+    static void distanceMatrix(const QVector<Lab> &rows, const QVector<Lab> &columns,
+                               Metric metric, float *result);
+
+    // Symmetric palette distance: mean distance of every color to its nearest
+    // counterpart in the other palette
+    static float paletteDistance(const QVector<QColor> &first, const QVector<QColor> &second,
+                                 Metric metric = CIEDE2000, Space space = CIELab);
+
+    // Keep the first occurrence of every group of colors closer than threshold
+    static QVector<QColor> removeNearDuplicates(const QVector<QColor> &colors, float threshold,
+                                                Metric metric = CIEDE2000, Space space = CIELab);
+
+private:
+    // Structure-of-arrays copy of a Lab list for the row kernels
+    struct LabColumns {
+        QVector<float> L;
+        QVector<float> a;
+        QVector<float> b;
+        QVector<float> C; // chroma, used by CIE94
+        int count = 0;
+    };
+
+    static LabColumns toColumns(const QVector<Lab> &colors);
+    static void computeRow(const Lab &reference, const LabColumns &columns, Metric metric,
+                           float *result);
+
+    static void rowCie76(const Lab &reference, const LabColumns &columns, float *result);
+    static void rowCie94(const Lab &reference, const LabColumns &columns, float *result);
+    static void rowCiede2000(const Lab &reference, const LabColumns &columns, float *result);
+
+    static float cie94(const Lab &reference, const Lab &sample);
+    static float ciede2000(const Lab &reference, const Lab &sample);
+};
+
+#endif // COLORDIFFERENCE_H
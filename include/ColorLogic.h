@@ -1,8 +1,14 @@
 #ifndef COLORLOGIC_H
 #define COLORLOGIC_H
 
+#include <QByteArrayView>
 #include <QString>
 #include <QColor>
+#include <QtGui/qrgbafloat.h>
+
+// Compact high-precision color: four half floats (8 bytes). Channels may leave
+// the 0..1 range so extended/wide-gamut sRGB values survive storage.
+using PackedColor = QRgbaFloat16;
 
 class ColorLogic {
 public:
@@ -34,6 +40,38 @@ public:
     static QString colorToCmykString(const QColor &color);
     static QColor cmykStringToColor(const QString &cmykString);
 
+    // The formats above by name: hex, rgb, rgba, hsl, hsla, hsv, cmyk
+    static QStringList formatNames();
+    // Unknown names format as HEX
+    static QString colorToString(const QColor &color, const QString &format);
+    // Tries every format in turn; format receives the name of the one that
+    // matched
+    static QColor stringToColor(const QString &text, QString *format = nullptr);
+
+    // Storage format: 8-bit colors are written as HEX, anything finer as
+    // CSS Color 4 "color(srgb r g b / a)" so no precision is lost
+    static QString colorToStorageString(const QColor &color);
+    static QString packedToStorageString(const PackedColor &packed);
+    static QColor storageStringToColor(const QString &text);
+
+    // Packed representation
+    static PackedColor toPacked(const QColor &color);
+    static PackedColor packedFromRgbF(float r, float g, float b, float a = 1.0f);
+    // Parses #rgb, #rrggbb and their alpha forms straight into a packed color.
+    // Eight digits are #aarrggbb as written by colorToHex, or CSS #rrggbbaa
+    // when alphaLast is set.
+    static bool hexToPacked(QByteArrayView hex, PackedColor *packed, bool alphaLast = false);
+    static QColor fromPacked(const PackedColor &packed);
+    static quint64 packedKey(const PackedColor &packed);
+    static bool isEightBit(const PackedColor &packed);
+
+    // WCAG 2 relative luminance and contrast ratio (1 to 21)
+    static double relativeLuminance(const QColor &color);
+    static double contrastRatio(const QColor &first, const QColor &second);
+
+    // Closest SVG color name, measured in OKLab
+    static QString nearestColorName(const QColor &color);
+
     // Utility
     static QColor randomColor();
 };
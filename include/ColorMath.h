@@ -0,0 +1,22 @@
+#ifndef COLORMATH_H
+#define COLORMATH_H
+
+// Internal definitions shared by the color conversion and rendering code;
+// not part of any class interface.
+
+// SSE2 is part of every x86-64 target; 32-bit x86 builds use it when the
+// compiler is told to
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COLORSMITH_HAVE_SSE2
+#endif
+
+namespace ColorMath {
+
+// Conversions overshoot 0..1 slightly at the gamut boundary; channels only
+// count as out of gamut beyond this
+constexpr float GAMUT_EPSILON = 1.0f / 1024.0f;
+
+} // namespace ColorMath
+
+#endif // COLORMATH_H
@@ -0,0 +1,65 @@
+#ifndef COLORRASTER_H
+#define COLORRASTER_H
+
+#include <QImage>
+#include <QVector>
+
+// Scanline rasterizers for the color plane widgets.
+//
+// An HSV plane is separable: hue only varies along x and saturation only
+// along y. Each column's fully saturated hue is computed once into a ramp,
+// after which every pixel of a row is one multiply-add per channel,
+//
+//     channel = value * (1 - sat) + value * sat * ramp[x]
+//
+// HSL rows take the same form with a different offset and scale. Ramps are
+// kept as separate float arrays so a row is converted four pixels at a
+// time with SSE2, straight into the QImage scanline.
+//
+// The perceptual planes convert whole rows through ColorSpace into linear
+// RGB and encode them with a lookup table; colors outside sRGB are masked.
+class ColorRaster {
+public:
+    // Fully saturated, full-value color of each column's hue, 0..255
+    struct HueRamp {
+        QVector<float> red;
+        QVector<float> green;
+        QVector<float> blue;
+
+        int width() const { return red.size(); }
+    };
+
+    // Hue (degrees) runs linearly from hueLeft at x = 0 towards hueRight
+    // at x = width
+    static HueRamp hueRamp(int width, float hueLeft, float hueRight);
+
+    // One Format_RGB32 row of offset + scale * ramp per channel (0..255)
+    static void hueRampRow(QRgb *line, const HueRamp &ramp, float offset,
+                           float scale);
+    // Saturation, value and lightness in 0..1
+    static void hsvRow(QRgb *line, const HueRamp &ramp, float saturation,
+                       float value);
+    static void hslRow(QRgb *line, const HueRamp &ramp, float saturation,
+                       float lightness);
+
+    // The planes fill a Format_RGB32 image; each axis runs linearly from
+    // its first value at x or y = 0 towards its second at the far edge.
+    // Large images are split into row bands filled on the global thread
+    // pool.
+
+    // Hue along x (image as wide as the ramp), saturation along y
+    static void hsvPlane(QImage *image, const HueRamp &ramp, float satTop,
+                         float satBottom, float value);
+    static void hslPlane(QImage *image, const HueRamp &ramp, float satTop,
+                         float satBottom, float lightness);
+
+    // OKLCH hue (degrees) along x, chroma along y, L in 0..1
+    static void oklchPlane(QImage *image, float hueLeft, float hueRight,
+                           float chromaTop, float chromaBottom, float lightness,
+                           QRgb outOfGamut);
+    // CIELAB a along x, b along y, L in 0..100
+    static void labPlane(QImage *image, float aLeft, float aRight, float bTop,
+                         float bBottom, float lightness, QRgb outOfGamut);
+};
+
+#endif // COLORRASTER_H
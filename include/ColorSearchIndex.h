@@ -0,0 +1,81 @@
+#ifndef COLORSEARCHINDEX_H
+#define COLORSEARCHINDEX_H
+
+#include "ColorDifference.h"
+#include "Palette.h"
+#include <QHash>
+#include <QVector>
+
+// Spatial index over the colors of many palettes.
+//
+// Colors are bucketed in a uniform 3D grid over OKLab (scaled by 100, as in
+// ColorDifference, so distances are OKLab Delta E). Queries only visit the
+// cells that can hold a match. Whole palettes are re-indexed individually when
+// their colors are replaced, and single-color edits only touch the colors
+// they add or remove.
+class ColorSearchIndex {
+public:
+    struct Match {
+        PaletteHandle palette;
+        int index;      // position of the color in the palette
+        float distance; // OKLab Delta E to the query color
+    };
+
+    // Edge length of a grid cell in Delta E units
+    static constexpr float CELL_SIZE = 2.0f;
+
+    ColorSearchIndex();
+
+    // Replaces everything indexed for the palette
+    void setPaletteColors(PaletteHandle palette, const QVector<PackedColor> &colors);
+    void removePalette(PaletteHandle palette);
+
+    // Single-color edits, with indices as in Palette. insertColors indexes
+    // colors[index, index + count) of the palette's new colors; the colors
+    // after them are renumbered, without converting them again.
+    void insertColors(PaletteHandle palette, const QVector<PackedColor> &colors, int index, int count);
+    void removeColors(PaletteHandle palette, int index, int count);
+    void moveColor(PaletteHandle palette, int from, int to);
+    void clear();
+
+    int size() const { return m_size; }
+
+    // All colors within radius, nearest first
+    QVector<Match> withinRadius(const QColor &color, float radius) const;
+    // The k nearest colors, nearest first
+    QVector<Match> nearest(const QColor &color, int k) const;
+
+private:
+    struct Point {
+        float L;
+        float a;
+        float b;
+        PaletteHandle palette;
+        int index;
+    };
+
+    struct CellCoord {
+        int x;
+        int y;
+        int z;
+    };
+
+    CellCoord cellOf(float L, float a, float b) const;
+    // Adds one color and keeps touched (sorted, unique) in step
+    void addPoint(PaletteHandle palette, const PackedColor &color, int index, QVector<int> *touched);
+    int cellIndex(int x, int y, int z) const { return (x * DIM_A + y) * DIM_B + z; }
+
+    // Grid extent; colors outside it are clamped into the border cells
+    static constexpr float MIN_L = 0.0f;
+    static constexpr float MIN_A = -40.0f;
+    static constexpr float MIN_B = -40.0f;
+    static constexpr int DIM_L = 50;
+    static constexpr int DIM_A = 40;
+    static constexpr int DIM_B = 40;
+
+    QVector<QVector<Point>> m_cells;
+    QHash<PaletteHandle, QVector<int>> m_cellsByPalette; // cells holding a palette's colors
+    int m_size;
+};
+
+#endif // COLORSEARCHINDEX_H
@@ -0,0 +1,44 @@
+#ifndef COLORSPACE_H
+#define COLORSPACE_H
+
+#include <QColor>
+
+// Conversions between sRGB and perceptual color spaces.
+// All conversions assume sRGB primaries with a D65 white point.
+class ColorSpace {
+public:
+    struct Lab {
+        float L;
+        float a;
+        float b;
+    };
+
+    struct Rgb {
+        float r;
+        float g;
+        float b;
+    };
+
+    // sRGB transfer function
+    static float srgbToLinear(float c);
+    static float linearToSrgb(float c);
+
+    // Linear sRGB to CIELAB (L in 0..100)
+    static Lab linearRgbToLab(float r, float g, float b);
+    // CIELAB to linear sRGB; colors outside sRGB are not clipped
+    static Rgb labToLinearRgb(const Lab &lab);
+
+    // Linear sRGB to OKLab (L in 0..1)
+    static Lab linearRgbToOklab(float r, float g, float b);
+    // OKLab to linear sRGB; colors outside sRGB are not clipped
+    static Rgb oklabToLinearRgb(const Lab &lab);
+    // The same for count colors of one lightness, four at a time with SSE2
+    static void oklabToLinearRgb(float L, const float *a, const float *b, int count,
+                                 float *red, float *green, float *blue);
+
+    // QColor helpers
+    static Lab toLab(const QColor &color);
+    static Lab toOklab(const QColor &color);
+};
+
+#endif // COLORSPACE_H
@@ -0,0 +1,28 @@
+#ifndef COMMANDLINETOOL_H
+#define COMMANDLINETOOL_H
+
+#include <QStringList>
+
+// Headless subcommands, run instead of the main window:
+//
+//   colorsmith export [--format gpl] [--output dir] [--palette name]...
+//       writes every user palette (or the named ones) to one file each
+//
+//   colorsmith convert [--to hsl] [--contrast color] [--name] < colors
+//       converts colors read one per line, in any supported format
+//
+//   colorsmith search [--count 10 | --radius 2] color...
+//       lists the palette colors closest to each color, nearest first
+class CommandLineTool {
+public:
+    // True when the first argument names a subcommand
+    static bool isCommand(int argc, char *argv[]);
+    static int run(int argc, char *argv[]);
+
+private:
+    static int runExport(const QStringList &arguments);
+    static int runConvert(const QStringList &arguments);
+    static int runSearch(const QStringList &arguments);
+};
+
+#endif // COMMANDLINETOOL_H
@@ -0,0 +1,34 @@
+#ifndef GRADIENTSTRIP_H
+#define GRADIENTSTRIP_H
+
+#include <QColor>
+#include <QPixmap>
+#include <QSize>
+
+// Color ramps drawn as slider tracks.
+//
+// A strip is computed per device pixel along its axis and kept in a shared,
+// bounded cache keyed by type, orientation, size, pixel ratio and only the
+// color components the type depends on. Every hue strip of a size is the
+// same pixmap, and a saturation strip is reused however the base color's
+// saturation changes.
+class GradientStrip {
+public:
+    // Each runs from the left or top of the strip
+    enum Type {
+        Hue,        // HSV hue 0..359 at full saturation and value
+        Saturation, // HSL saturation 0..255 at the color's hue and lightness
+        Lightness,  // HSL lightness 0..255 at the color's hue and saturation
+        Value       // HSV value 255..0 at the color's hue and saturation
+    };
+
+    // Equal for two colors exactly when their strips of this type are equal
+    static quint32 dependencyKey(Type type, const QColor &color);
+
+    // Opaque strip of the given logical size at devicePixelRatio
+    static QPixmap pixmap(Type type, const QColor &color, const QSize &size,
+                          Qt::Orientation orientation,
+                          qreal devicePixelRatio = 1.0);
+};
+
+#endif // GRADIENTSTRIP_H
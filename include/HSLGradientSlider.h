@@ -1,8 +1,10 @@
 #ifndef GRADIENTSLIDER_H
 #define GRADIENTSLIDER_H
 
+#include "GradientStrip.h"
 #include <QSlider>
 #include <QColor>
+#include <QPixmap>
 
 class HSLGradientSlider : public QSlider {
     Q_OBJECT
@@ -21,14 +23,19 @@ public:
 
 protected:
     void paintEvent(QPaintEvent *event) override;
+    void changeEvent(QEvent *event) override;
 
 private:
     GradientType m_gradientType;
     QColor m_baseColor;
 
-    QLinearGradient createHueGradient(const QRect &rect) const;
-    QLinearGradient createSaturationGradient(const QRect &rect) const;
-    QLinearGradient createLightnessGradient(const QRect &rect) const;
+    // Groove with gradient and border at device resolution, drawn with a
+    // one pixel margin for the border; null when it must be re-rendered
+    QPixmap m_track;
+    QSize m_trackSize;
+
+    GradientStrip::Type stripType() const;
+    QPixmap renderTrack(const QSize &size, qreal devicePixelRatio) const;
 };
 
 #endif // GRADIENTSLIDER_H
@@ -3,9 +3,11 @@
 
 #include <QMainWindow>
 #include <QColor>
+#include <QElapsedTimer>
 
 class QSpinBox;
 class QSplitter;
+class QTimer;
 
 namespace Ui {
 class MainWindow;
@@ -24,15 +26,21 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow() override;
 
+signals:
+    // Emitted once the first frame has been painted and flushed, before the
+    // work deferred past it starts
+    void firstFramePresented();
+
 protected:
     void closeEvent(QCloseEvent *event) override;
+    void showEvent(QShowEvent *event) override;
     bool eventFilter(QObject *obj, QEvent *event) override;
 
 private slots:
     void onRgbInputChanged();
     void onOutputModeChanged() const;
     void onOutputTextChanged();
-    void onCopyClicked() const;
+    void onCopyClicked();
     void onPickColorClicked() const;
     void onRandomColorClicked();
     void onAboutClicked();
@@ -53,9 +61,23 @@ private slots:
     // Connected to QtHsvRectPicker
     void onColorPlaneColorChanged(const QColor &color);
 
+    // Runs once the first frame is out
+    void loadDeferred();
+
 private:
+    // Widgets still showing an older color than m_currentColor
+    enum PendingUpdate : unsigned {
+        PendingPreview = 0x01,
+        PendingPlane = 0x02,
+        PendingChannels = 0x04,
+        PendingBrightness = 0x08, // Brightness slider and last color preview
+        PendingOutput = 0x10
+    };
+
     void updateColor(const QColor &color, bool updateOutput = true, bool skipBrightnessReset = false, bool addToRecent = false);
     void updateOutput() const;
+    void scheduleColorUpdate(unsigned updates);
+    void flushColorUpdates();
     void loadSettings();
     void saveSettings() const;
     static bool handleSpinBoxKeyPress(QSpinBox* spinBox, const QKeyEvent* event);
@@ -72,6 +94,12 @@ private:
     QColor m_currentColor;
     QColor m_baseColorForBrightness;
     bool m_programmaticChange;
+    bool m_firstFrameWatched; // event filter on the window handle installed
+
+    // Color changes are pushed to the widgets at most once per frame
+    unsigned m_pendingUpdates;
+    QTimer *m_updateTimer;
+    QElapsedTimer m_sinceFlush;
 };
 
 #endif // MAINWINDOW_H
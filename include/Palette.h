@@ -1,35 +1,73 @@
 #ifndef PALETTE_H
 #define PALETTE_H
 
+#include "ColorLogic.h"
 #include <QColor>
 #include <QString>
+#include <QStringView>
 #include <QVector>
 #include <QUuid>
 
+// Stable integer handle assigned by PaletteManager, 0 means "no palette"
+using PaletteHandle = quint32;
+
 class Palette {
 public:
     explicit Palette(const QString &name = "Untitled Palette", const QString &id = QString(), bool isReadOnly = false);
 
     QString id() const { return m_id; }
+    PaletteHandle handle() const { return m_handle; }
     QString name() const { return m_name; }
     void setName(const QString &name) { m_name = name; }
 
     bool isReadOnly() const { return m_isReadOnly; }
     void setReadOnly(bool readOnly) { m_isReadOnly = readOnly; }
 
-    QVector<QColor> colors() const { return m_colors; }
-    void setColors(const QVector<QColor> &colors);
+    // False while the colors are still in the palette library; metadata and
+    // the preview are available either way
+    bool isLoaded() const { return m_libraryIndex < 0; }
+    QVector<PackedColor> preview() const;
+
+    // Colors are stored packed (4 x half float) to keep full precision and
+    // are read in place through packedColors(). Names are optional: they
+    // share one string pool, and the per-color reference table only exists
+    // once some color has a name, so it cannot drift out of step.
+    const QVector<PackedColor> &packedColors() const { return m_colors; }
+    QColor colorAt(int index) const;
+    void setPackedColors(const QVector<PackedColor> &colors);
     void addColor(const QColor &color, const QString &colorName = QString());
+    void addPackedColor(const PackedColor &color, const QString &colorName = QString());
+    void insertPackedColor(int index, const PackedColor &color, const QString &colorName = QString());
+    void moveColor(int from, int to);
+    bool containsColor(const QColor &color) const;
     void removeColor(int index);
     void clearColors();
-    int colorCount() const { return m_colors.size(); }
-    QString colorName(int index) const;
+    // Taken from the library directory while the palette is not loaded, so it
+    // is known before packedColors() is filled in
+    int colorCount() const { return isLoaded() ? m_colors.size() : m_libraryColorCount; }
+    // Valid until the palette is modified
+    QStringView colorName(int index) const;
 
 private:
+    friend class PaletteManager;
+
+    struct NameRef {
+        quint32 offset = 0;
+        quint32 length = 0;
+    };
+
+    NameRef storeName(QStringView name);
+    void insertName(int index, QStringView name);
+
     QString m_id;
+    PaletteHandle m_handle = 0;
+    int m_libraryIndex = -1; // directory index while colors are still in the mapped library
+    int m_libraryColorCount = 0; // only kept while not loaded
+    QVector<PackedColor> m_preview; // only kept while not loaded
     QString m_name;
-    QVector<QColor> m_colors;
-    QVector<QString> m_colorNames;
+    QVector<PackedColor> m_colors;
+    QVector<NameRef> m_nameRefs; // empty, or one entry per color
+    QString m_namePool;
     bool m_isReadOnly;
 };
 
@@ -0,0 +1,45 @@
+#ifndef PALETTEEXPORTER_H
+#define PALETTEEXPORTER_H
+
+#include "ColorLogic.h"
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+// Writes palettes in formats other applications understand.
+//
+// Each format renders the complete file into one buffer reserved up front
+// from the color count, which is then written with a single write. Formats
+// are described by a table in PaletteExporter.cpp (name, suffix, size hint,
+// renderer); adding one means adding an enum value and a table row.
+class PaletteExporter {
+public:
+    enum Format {
+        PlainText, // one color per line, read back by Import Palette
+        Gpl,       // GIMP/Inkscape palette (8-bit, no alpha)
+        Ase,       // Adobe Swatch Exchange (RGB floats, no alpha)
+        Css,       // :root custom properties
+        Scss,      // SCSS variables
+        Tailwind,  // tailwind.config.js theme colors
+        Json,      // {"name": ..., "colors": [...]}
+        Png        // swatch sheet, 16 bits per channel
+    };
+
+    static QVector<Format> formats();
+    // Short name used on the command line, e.g. "gpl"
+    static QString formatName(Format format);
+    static QString fileSuffix(Format format);
+    // Accepts format names and file suffixes
+    static bool formatFromName(const QString &name, Format *format);
+
+    // Lowercase ASCII identifier for a palette name, used for CSS variable
+    // and file names
+    static QString identifier(const QString &paletteName);
+
+    static QByteArray render(const QString &name, const QVector<PackedColor> &colors,
+                             Format format);
+    static bool exportFile(const QString &path, const QString &name,
+                           const QVector<PackedColor> &colors, Format format);
+};
+
+#endif // PALETTEEXPORTER_H
@@ -0,0 +1,52 @@
+#ifndef PALETTEIMPORTER_H
+#define PALETTEIMPORTER_H
+
+#include "ColorLogic.h"
+#include <QString>
+#include <QVector>
+#include <functional>
+
+class QIODevice;
+
+// Reads palette files from other applications.
+//
+// Every format is parsed from the device in bounded pieces (lines, binary
+// blocks or fixed-size chunks), so the memory used beyond the resulting colors
+// does not grow with the file. Colors are converted straight to PackedColor.
+//
+// Supported formats:
+//   PlainText   one color per line, as written by Export Palette
+//   Gpl         GIMP/Inkscape .gpl
+//   Ase         Adobe Swatch Exchange (RGB, CMYK, LAB and Gray swatches)
+//   Aco         Photoshop color swatches, versions 1 and 2
+//   Css         CSS custom properties (--name: value) and SCSS variables
+class PaletteImporter {
+public:
+    enum Format {
+        PlainText,
+        Gpl,
+        Ase,
+        Aco,
+        Css
+    };
+
+    struct Result {
+        QString name; // palette name stored in the file, if any
+        QVector<PackedColor> colors;
+        int skipped = 0; // entries that held no usable color
+    };
+
+    // Called with bytes read so far and the device size (0 if unknown);
+    // returning false cancels the import
+    using ProgressCallback = std::function<bool(qint64 done, qint64 total)>;
+
+    // Picks the format from the file contents, then the extension
+    static Format detectFormat(QIODevice *device, const QString &fileName);
+
+    static bool import(QIODevice *device, Format format, Result *result,
+                       const ProgressCallback &progress = {});
+    static bool importFile(const QString &path, Result *result,
+                           const ProgressCallback &progress = {});
+};
+
+#endif // PALETTEIMPORTER_H
@@ -0,0 +1,87 @@
+#ifndef PALETTEJOURNAL_H
+#define PALETTEJOURNAL_H
+
+#include "ColorLogic.h"
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+// Append-only log of palette edits stored as JSON lines next to the palette
+// snapshot. Every entry carries a sequence number; the snapshot records the
+// last sequence it contains so replay can skip entries that are already part
+// of it.
+//
+// Sequence numbers are handed out on the GUI thread; the file itself is only
+// touched by PaletteManager's writer thread once it has been opened.
+class PaletteJournal {
+public:
+    enum Operation {
+        CreatePalette,
+        DeletePalette,
+        RenamePalette,
+        AddColor,
+        RemoveColor,
+        MoveColor,
+        SetColors,
+        SelectPalette
+    };
+
+    struct Entry {
+        quint64 sequence = 0;
+        Operation operation = AddColor;
+        QString paletteId;
+        QString name;           // CreatePalette, RenamePalette
+        int index = -1;         // AddColor, RemoveColor, MoveColor (source)
+        int toIndex = -1;       // MoveColor (destination)
+        QVector<PackedColor> colors; // AddColor (one color), SetColors
+    };
+
+    PaletteJournal() = default;
+    PaletteJournal(const PaletteJournal&) = delete;
+    PaletteJournal& operator=(const PaletteJournal&) = delete;
+
+    bool open(const QString &path);
+    void close();
+
+    // Entries of the rotated journal (if any) followed by the active one at
+    // path; reading does not need the journal to be open
+    static QVector<Entry> readEntries(const QString &path);
+
+    // Numbers entries in the order the edits were made
+    quint64 nextSequence() { return ++m_lastSequence; }
+
+    // Writes entries that already carry their sequence numbers; false if
+    // they could not be written, in which case the caller has to save them
+    // some other way
+    bool append(const QVector<Entry> &entries);
+
+    // Bytes in the active journal; safe to read from any thread
+    qint64 size() const { return m_size; }
+    quint64 lastSequence() const { return m_lastSequence; }
+    void setLastSequence(quint64 sequence) { m_lastSequence = sequence; }
+
+    // Compaction support: the active journal is moved aside while a snapshot is
+    // written, and removed once the snapshot is committed. If a rotated
+    // journal is still there because that snapshot failed, the active entries
+    // are appended to it instead.
+    bool rotate();
+    bool hasRotated() const;
+    void removeRotated();
+
+    // Drops all entries, used after a synchronous full snapshot
+    void clear();
+
+private:
+    static QByteArray serialize(const Entry &entry);
+    static bool parse(const QByteArray &line, Entry *entry);
+    static QString rotatedPath(const QString &path);
+    QString rotatedPath() const { return rotatedPath(m_file.fileName()); }
+
+    QFile m_file;
+    std::atomic<qint64> m_size{0};
+    bool m_partialLine = false; // a failed write may have left half a line
+    quint64 m_lastSequence = 0;
+};
+
+#endif // PALETTEJOURNAL_H
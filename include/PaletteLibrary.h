@@ -0,0 +1,86 @@
+#ifndef PALETTELIBRARY_H
+#define PALETTELIBRARY_H
+
+#include "ColorLogic.h"
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+// Binary palette library (palettes.lib), read through a memory map.
+//
+// Layout, all integers little-endian:
+//   header      56 bytes: magic "CSPL", version, palette count, directory,
+//               preview and string table location, journal sequence,
+//               current palette id
+//   directory   32 bytes per palette: id/name as (offset, length) into the
+//               string table, color array offset and count
+//   previews    PREVIEW_SIZE packed colors per palette (version 2)
+//   colors      packed 4 x half float RGBA arrays, 8-byte aligned
+//   strings     UTF-8 ids and names
+//
+// Everything needed to list palettes (ids, names, counts, previews) sits at
+// the front of the file, so startup touches only those pages. Color arrays
+// are read on demand. JSON is kept for interchange and for migrating
+// palettes.json.
+class PaletteLibrary {
+public:
+    static constexpr quint16 FORMAT_VERSION = 2;
+    static constexpr int PREVIEW_SIZE = 8;
+
+    struct PaletteData {
+        QString id;
+        QString name;
+        QVector<PackedColor> colors;
+    };
+
+    struct Snapshot {
+        QVector<PaletteData> palettes;
+        QString currentPaletteId;
+        quint64 journalSequence = 0; // last journal entry contained in the snapshot
+    };
+
+    PaletteLibrary() = default;
+    ~PaletteLibrary();
+    PaletteLibrary(const PaletteLibrary&) = delete;
+    PaletteLibrary& operator=(const PaletteLibrary&) = delete;
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    int paletteCount() const { return m_paletteCount; }
+    QString paletteId(int index) const;
+    QString paletteName(int index) const;
+    int colorCount(int index) const;
+    // Copies the color array of one palette out of the map; safe to call
+    // from worker threads while the library stays open
+    QVector<PackedColor> colors(int index) const;
+    QVector<PackedColor> preview(int index) const;
+
+    // Up to PREVIEW_SIZE colors spread evenly over the palette
+    static QVector<PackedColor> samplePreview(const QVector<PackedColor> &colors);
+
+    QString currentPaletteId() const;
+    quint64 journalSequence() const;
+
+    static bool write(const Snapshot &snapshot, const QString &path);
+
+    static bool readJson(const QString &path, Snapshot *snapshot);
+    static bool writeJson(const Snapshot &snapshot, const QString &path);
+
+private:
+    const uchar *directoryEntry(int index) const;
+    QString string(quint32 offset, quint32 length) const;
+    bool validate() const;
+
+    QFile m_file;
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    int m_paletteCount = 0;
+    quint32 m_directoryOffset = 0;
+    quint32 m_previewOffset = 0; // 0 for version 1 files without previews
+    quint32 m_stringTableOffset = 0;
+    quint32 m_stringTableSize = 0;
+};
+
+#endif // PALETTELIBRARY_H
@@ -1,9 +1,21 @@
 #ifndef PALETTEMANAGER_H
 #define PALETTEMANAGER_H
 
+#include "ColorSearchIndex.h"
 #include "Palette.h"
+#include "PaletteJournal.h"
+#include "PaletteLibrary.h"
+#include "RecentColorsStore.h"
+#include <QHash>
 #include <QObject>
+#include <QSet>
 #include <QVector>
+#include <atomic>
+#include <memory>
+
+class QThreadPool;
+class QTimer;
+template <typename T> class QFutureWatcher;
 
 class PaletteManager : public QObject {
     Q_OBJECT
@@ -16,7 +28,9 @@ public:
 
     Palette* createPalette(const QString &name = "Untitled Palette");
     Palette* getPalette(const QString &id) const;
+    Palette* getPalette(PaletteHandle handle) const;
     Palette* currentPalette() const { return m_currentPalette; }
+    Palette* recentPalette() const { return m_recentPalette; }
     void setCurrentPalette(const QString &id);
     void setCurrentPalette(Palette *palette);
 
@@ -24,18 +38,79 @@ public:
     bool deletePalette(const QString &id);
     bool renamePalette(const QString &id, const QString &newName);
 
-    void loadPalettes();
+    // Color edits; each one is appended to the journal. Single-color edits
+    // are announced through the fine-grained signals, replacements through
+    // paletteColorsChanged.
+    void addColor(Palette *palette, const QColor &color);
+    void removeColor(Palette *palette, int index);
+    void moveColor(Palette *palette, int from, int to);
+    void setColors(Palette *palette, const QVector<QColor> &colors);
+    void setPackedColors(Palette *palette, const QVector<PackedColor> &colors);
+    void clearColors(Palette *palette);
+
+    // ReadOnly opens the library and replays the journal in memory only:
+    // nothing is written or migrated, no colors are loaded in the
+    // background, and later edits are not journaled. The headless export
+    // uses it, as it may run next to the GUI.
+    enum class LoadMode { ReadWrite, ReadOnly };
+    void loadPalettes(LoadMode mode = LoadMode::ReadWrite);
+    // Fills palettes left empty by loadPalettes because the first frame does
+    // not need them; paletteColorsChanged is emitted for each
+    void loadDeferredPalettes();
+
+    // Loads the colors of a palette still backed by the library on a worker
+    // thread; paletteColorsChanged is emitted once they are in place
+    void loadColorsAsync(Palette *palette);
+
+    // Hands the last queued journal entries to the writer thread and waits
+    // until they are written; called on close. Snapshots are written by
+    // compaction in the background, and here only if the journal failed.
     void savePalettes();
 
+    // The palette's colors, copied out of the mapped library without loading
+    // the palette if it is still there
+    QVector<PackedColor> paletteColors(const Palette *palette) const;
+
+    // Ids, names and colors of every user palette; palettes still in the
+    // mapped library are read from it without being loaded
+    PaletteLibrary::Snapshot captureSnapshot() const;
+
+    // JSON interchange; imported palettes get fresh ids
+    bool exportLibraryJson(const QString &path);
+    int importLibraryJson(const QString &path);
+
     void addToRecentColors(const QColor &color);
 
+    // Cross-palette color search (OKLab Delta E). The index is built on first
+    // use and then kept up to date as palettes change.
+    QVector<ColorSearchIndex::Match> findSimilarColors(const QColor &color, float radius);
+    QVector<ColorSearchIndex::Match> findNearestColors(const QColor &color, int count);
+
 signals:
     void paletteAdded(Palette *palette);
-    void paletteRemoved(const QString &id);
-    void paletteRenamed(const QString &id);
+    void paletteRemoved(PaletteHandle handle);
+    void paletteRenamed(PaletteHandle handle);
     void currentPaletteChanged(Palette *palette);
+    // The palette's colors were replaced as a whole (loaded, imported,
+    // cleared); views should re-read all of them
     void paletteColorsChanged(Palette *palette);
 
+    // Single-color edits, announced before and after they are applied so item
+    // models can bracket them with beginInsertRows()/endInsertRows() and
+    // friends. Indices follow Palette::moveColor: the moved color ends up at
+    // index to.
+    void colorsAboutToBeInserted(Palette *palette, int index, int count);
+    void colorsInserted(Palette *palette, int index, int count);
+    void colorsAboutToBeRemoved(Palette *palette, int index, int count);
+    void colorsRemoved(Palette *palette, int index, int count);
+    void colorAboutToBeMoved(Palette *palette, int from, int to);
+    void colorMoved(Palette *palette, int from, int to);
+
+private slots:
+    void onSaveTimeout();
+    void onJournalWriteFailed();
+    void onCompactionFinished();
+
 private:
     PaletteManager();
     ~PaletteManager();
@@ -43,10 +118,71 @@ private:
     PaletteManager& operator=(const PaletteManager&) = delete;
 
     void loadStandardHtmlColorsPalette();
+    void loadStandardHtmlColors();
     void loadRecentlyPickedColorsPalette();
 
+    void insertPalette(Palette *palette);
+    Palette* takePalette(int slot);
+    void reindexFrom(int slot);
+
+    // Numbers the entry and queues it; queued entries are coalesced and
+    // written by the writer thread
+    void journal(PaletteJournal::Entry entry);
+    void scheduleSave();
+    void writeJournal();
+    void applyEntry(const PaletteJournal::Entry &entry);
+    void compactJournal();
+
+    // Loads colors of a palette that is still backed by the mapped library
+    // and announces them through paletteColorsChanged
+    void materialize(Palette *palette);
+    void detachFromLibrary(Palette *palette);
+    // Moves a snapshot written to snapshotFilePath() over palettes.lib and
+    // maps it, pointing palettes that are still unloaded at their entries in
+    // the new file. Leaves the old library mapped and returns false if the
+    // snapshot cannot be opened or moved.
+    bool replaceLibrary(const QString &snapshotPath);
+
+    // Like captureSnapshot(), but the colors of palettes still in the library
+    // are left out and their directory indices returned instead, so they can
+    // be copied on the writer thread
+    PaletteLibrary::Snapshot captureSnapshot(QVector<int> *libraryIndices) const;
+
+    ColorSearchIndex &searchIndex();
+
+    static QString palettesFilePath();
+    static QString snapshotFilePath();
+    static QString legacyPalettesFilePath();
+    static QString journalFilePath();
+
     QVector<Palette*> m_palettes;
+    QHash<QString, int> m_slotById;
+    QHash<PaletteHandle, Palette*> m_paletteByHandle;
+    PaletteHandle m_nextHandle;
     Palette *m_currentPalette;
+    Palette *m_recentPalette;
+    Palette *m_standardPalette; // empty until loadDeferredPalettes
+
+    PaletteLibrary m_library;
+    PaletteJournal m_journal;
+    RecentColorsStore m_recentColors;
+    std::unique_ptr<ColorSearchIndex> m_searchIndex;
+    QVector<PaletteJournal::Entry> m_unwrittenEntries;
+    QTimer *m_saveTimer;
+    bool m_readOnly; // loaded with LoadMode::ReadOnly
+    QThreadPool *m_saveThreadPool;
+    QThreadPool *m_loadThreadPool;
+    QSet<PaletteHandle> m_pendingLoads;
+
+    QFutureWatcher<bool> *m_compactionWatcher;
+    QTimer *m_compactionRetryTimer;
+    bool m_compacting;        // until onCompactionFinished has handled the result
+    bool m_compactionPending; // requested while one was running or waiting to retry
+    quint64 m_compactionSequence; // journal sequence of the snapshot being written
+    quint64 m_savedSequence;      // journal sequence of the last committed snapshot
+    // Last sequence the writer failed to get into the journal; those edits
+    // are safe only once a snapshot past it is committed
+    std::atomic<quint64> m_lostSequence;
 };
 
 #endif // PALETTEMANAGER_H
@@ -0,0 +1,34 @@
+#ifndef PALETTEMODEL_H
+#define PALETTEMODEL_H
+
+#include <QAbstractListModel>
+
+class Palette;
+
+// List model over the colors of one palette. Rows are read straight from the
+// palette's packed storage when a view asks for them, so the model itself
+// holds no per-color state. Edits made through PaletteManager arrive as row
+// inserts, removals and moves.
+class PaletteModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    enum Roles {
+        ColorNameRole = Qt::UserRole + 1
+    };
+
+    explicit PaletteModel(QObject *parent = nullptr);
+
+    Palette* palette() const { return m_palette; }
+    // Shows the palette, re-reading all rows even if it is already shown
+    void setPalette(Palette *palette);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    // DecorationRole is the QColor, DisplayRole its storage string
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    Palette *m_palette;
+};
+
+#endif // PALETTEMODEL_H
@@ -3,39 +3,31 @@
 
 #include <QWidget>
 #include <QColor>
-#include <QVector>
+#include <QStyledItemDelegate>
 
-class QGridLayout;
 class QAction;
 class QToolButton;
 class QLabel;
 class QFrame;
-class QScrollArea;
+class QListView;
 class QComboBox;
 class QStatusBar;
 class Palette;
+class PaletteModel;
 
-class ColorSwatch : public QWidget {
+// Paints one palette color in the swatch view. Views only ask delegates to
+// paint visible rows, so palette size does not affect repaint cost.
+class SwatchDelegate : public QStyledItemDelegate {
     Q_OBJECT
 
 public:
-    explicit ColorSwatch(const QColor& color, QWidget* parent = nullptr, bool readOnly = false, const QString& colorName = QString());
-    QColor color() const { return m_color; }
-    bool isReadOnly() const { return m_readOnly; }
+    explicit SwatchDelegate(QObject* parent = nullptr);
 
-signals:
-    void clicked();
-    void removeRequested();
-
-protected:
-    void paintEvent(QPaintEvent* event) override;
-    void mousePressEvent(QMouseEvent* event) override;
-    void contextMenuEvent(QContextMenuEvent* event) override;
+    void paint(QPainter* painter, const QStyleOptionViewItem& option,
+               const QModelIndex& index) const override;
+    QSize sizeHint(const QStyleOptionViewItem& option,
+                   const QModelIndex& index) const override;
 
-private:
-    QColor m_color;
-    QString m_colorName;
-    bool m_readOnly;
     static constexpr int SWATCH_SIZE = 40;
 };
 
@@ -69,6 +61,7 @@ public:
     void setPalette(Palette* palette);
     Palette* currentPalette() const { return m_currentPalette; }
     void refreshColors();
+    void scrollToColor(int index);
 
 signals:
     void colorSelected(const QColor& color);
@@ -76,11 +69,15 @@ signals:
 
 private slots:
     void onClearPalette();
+    void onRemoveNearDuplicates();
+    void onComparePalette();
     void onExportPalette();
     void onImportPalette();
+    void onExportLibrary();
+    void onImportLibrary();
     void onAddColorClicked();
-    void onSwatchClicked();
-    void onSwatchRemoveRequested();
+    void onSwatchClicked(const QModelIndex& index);
+    void onSwatchContextMenu(const QPoint& pos);
     void onPaletteSelected(int index);
     void onNewPalette();
     void onRenamePalette();
@@ -89,8 +86,7 @@ private slots:
 
 private:
     void setupUI();
-    void updateLayout();
-    void addColorToUI(const QColor& color, const QString& colorName = QString());
+    void updateEmptyState();
     void updatePaletteCombo();
     QStatusBar* statusBar();
 
@@ -100,24 +96,22 @@ private:
     QToolButton* m_addButton;
     QToolButton* m_menuButton;
     QWidget* m_contentWidget;
-    QScrollArea* m_scrollArea;
-    QWidget* m_gridWidget;
-    QGridLayout* m_gridLayout;
+    QListView* m_swatchView;
+    PaletteModel* m_model;
     QLabel* m_emptyStateLabel;
 
     Palette* m_currentPalette;
-    QVector<ColorSwatch*> m_swatches;
 
     QAction* m_newPaletteAction;
     QAction* m_renamePaletteAction;
     QAction* m_deletePaletteAction;
     QAction* m_generateFromImageAction;
     QAction* m_clearPaletteAction;
+    QAction* m_removeDuplicatesAction;
+    QAction* m_comparePaletteAction;
     QAction* m_exportPaletteAction;
     QAction* m_importPaletteAction;
 
-    static constexpr int MAX_COLUMNS = 6;
-    static constexpr int SWATCH_SIZE = 40;
     static constexpr int SPACING = 8;
 };
 
@@ -0,0 +1,53 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QString>
+#include <QtGlobal>
+
+// Opt-in timing of the interactive hot paths.
+//
+// Setting COLORSMITH_TRACE to a file name enables it at startup; on exit the
+// samples are written there in Chrome's trace event format, for
+// chrome://tracing or Perfetto. Samples go to a fixed-size ring buffer that
+// any thread appends to without locking; only the most recent are kept.
+//
+// While disabled, a Scope costs one test of a flag.
+class Profiler {
+public:
+    // Times the enclosing block; name must outlive the program, such as a
+    // string literal
+    class Scope {
+    public:
+        explicit Scope(const char *name)
+            : m_name(s_enabled ? name : nullptr), m_start(m_name ? now() : 0) {}
+        ~Scope() {
+            if (m_name)
+                record(m_name, m_start, now() - m_start);
+        }
+
+    private:
+        Q_DISABLE_COPY(Scope)
+
+        const char *m_name;
+        qint64 m_start;
+    };
+
+    static bool isEnabled() { return s_enabled; }
+
+    // Enables recording if COLORSMITH_TRACE is set. Must run before any
+    // other thread is started.
+    static void startFromEnvironment();
+    // Writes the trace to the COLORSMITH_TRACE file if enabled
+    static bool finish();
+
+    // Nanoseconds since recording started
+    static qint64 now();
+    static void record(const char *name, qint64 start, qint64 duration);
+
+    static bool writeChromeTrace(const QString &path);
+
+private:
+    static bool s_enabled;
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,83 @@
+#ifndef RECENTCOLORSSTORE_H
+#define RECENTCOLORSSTORE_H
+
+#include "ColorLogic.h"
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+// Fixed-capacity most-recently-used set of picked colors.
+//
+// Colors live in a slot array threaded by an intrusive doubly linked list
+// (most recent first) and are found through a hash of their packed value, so
+// a pick is O(1) whether it is new, a repeat, or evicts the oldest color.
+// Each slot also carries an in-memory order number counted in a Fenwick
+// tree, which gives a repeat's previous position in O(log n).
+//
+// Each slot is mirrored by a 16-byte record (color + use stamp) in
+// recent-colors.bin; a pick rewrites just the one record it touched. Order is
+// rebuilt from the stamps on load.
+class RecentColorsStore {
+public:
+    static constexpr int DEFAULT_CAPACITY = 64;
+    static constexpr int MAX_CAPACITY = 4096;
+
+    RecentColorsStore() = default;
+    RecentColorsStore(const RecentColorsStore&) = delete;
+    RecentColorsStore& operator=(const RecentColorsStore&) = delete;
+
+    // Loads the store; a file written with another capacity keeps its most
+    // recent colors. recent-colors.json from older versions is migrated.
+    bool open(const QString &path, int capacity, const QString &legacyJsonPath = QString());
+    void close();
+
+    // Moves the color to the front, inserting it (and evicting the least
+    // recently used color when full) if needed. Returns the position it
+    // was moved from, most recent first, or -1 if it was new.
+    int touch(const PackedColor &color);
+
+    int capacity() const { return m_slots.size(); }
+    int count() const { return m_count; }
+
+    // Most recent first
+    QVector<PackedColor> colors() const;
+
+private:
+    struct Slot {
+        PackedColor color;
+        quint64 stamp = 0; // 0 marks an unused slot
+        int prev = -1;
+        int next = -1;
+        int order = -1; // grows with each pick; not persisted
+    };
+
+    void reset(int capacity);
+    void unlink(int slot);
+    void pushFront(int slot);
+    int acquireSlot();
+
+    // Order numbers run up to twice the capacity before the list is
+    // renumbered from 0, so renumbering is amortized over the picks
+    void addOrder(int order, int delta);
+    int countOrdersUpTo(int order) const;
+    void renumberOrders();
+
+    // Restores slots from a file image; false if the file must be rewritten
+    bool load(const QByteArray &data);
+    bool writeAll();
+    void writeRecord(int slot);
+    void loadJson(const QString &path);
+
+    QVector<Slot> m_slots;
+    QHash<quint64, int> m_slotByKey;
+    int m_head = -1;
+    int m_tail = -1;
+    int m_count = 0;
+    quint64 m_nextStamp = 1;
+    QVector<int> m_orderTree; // Fenwick tree of live order numbers, 1-based
+    int m_nextOrder = 0;
+    QFile m_file;
+};
+
+#endif // RECENTCOLORSSTORE_H
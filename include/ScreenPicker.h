@@ -20,6 +20,8 @@ private slots:
     void onPortalResponse(uint response, const QVariantMap &results);
 
 private:
+    static void registerTypes();
+
     QString m_requestPath;
 };
 
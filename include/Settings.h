@@ -16,6 +16,9 @@ namespace Keys {
     constexpr const char* PALETTE_COLORS = "palette-colors";
     constexpr const char* CURRENT_PALETTE_ID = "current-palette-id";
     constexpr const char* SPLITTER_STATE = "splitter-state";
+    constexpr const char* RECENT_COLORS_CAPACITY = "recent-colors-capacity";
+    constexpr const char* PLANE_CACHE_BUDGET = "plane-cache-budget";
+    constexpr const char* PLANE_MODE = "plane-mode";
 }
 
 // Settings manager class
@@ -38,6 +41,19 @@ public:
     QString getCurrentPaletteId() const;
     void setCurrentPaletteId(const QString& id);
 
+    // Defaults come from the owning component, so Settings does not depend
+    // on it
+    int getRecentColorsCapacity(int defaultCapacity) const;
+    void setRecentColorsCapacity(int capacity);
+
+    // Memory for cached color planes, in KiB
+    int getPlaneCacheBudget(int defaultKib) const;
+    void setPlaneCacheBudget(int kib);
+
+    // Color plane mode, by QtHsvRectPicker::PlaneMode key name
+    QString getPlaneMode() const;
+    void setPlaneMode(const QString& mode);
+
 
     // Window settings
     QByteArray getWindowGeometry() const;
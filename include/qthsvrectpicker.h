@@ -14,9 +14,22 @@ class QtHsvRectPicker : public QFrame
     Q_PROPERTY(int maximumSat READ maximumSat WRITE setMaximumSat)
     Q_PROPERTY(int value READ value WRITE setValue)
     Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
+    Q_PROPERTY(PlaneMode planeMode READ planeMode WRITE setPlaneMode NOTIFY planeModeChanged)
     Q_DISABLE_COPY(QtHsvRectPicker)
 
 public:
+    // What the plane shows; value() is the remaining component
+    enum PlaneMode {
+        Hsv,   // hue x saturation at a fixed value
+        Hsl,   // hue x saturation at a fixed lightness
+        Oklch, // hue x chroma at a fixed OKLab lightness
+        Lab    // a x b at a fixed CIELAB lightness
+    };
+    Q_ENUM(PlaneMode)
+
+    // Plane cache budget in KiB
+    static constexpr int DEFAULT_CACHE_BUDGET = 64 * 1024;
+
     explicit QtHsvRectPicker(QWidget *parent = nullptr);
     ~QtHsvRectPicker();
 
@@ -25,12 +38,15 @@ public:
 
     int value() const;
     QColor color() const;
+    PlaneMode planeMode() const;
     int minimumSat() const;
     int maximumSat() const;
     int minimumHue() const;
     int maximumHue() const;
     void setHueRange(int mi, int ma);
     void setSatRange(int mi, int ma);
+    int cacheBudget() const;
+    void setCacheBudget(int kib);
 
 public Q_SLOTS:
     void setValue(int v);
@@ -39,6 +55,7 @@ public Q_SLOTS:
     void setMinimumHue(int h);
     void setMaximumHue(int h);
     void setColor(const QColor &c, bool changeBrightness = false);
+    void setPlaneMode(QtHsvRectPicker::PlaneMode mode);
 
 Q_SIGNALS:
     void valueChanged(int);
@@ -49,6 +66,7 @@ Q_SIGNALS:
     void satRangeChanged(int, int);
     void hueRangeChanged(int, int);
     void colorChanged(const QColor&);
+    void planeModeChanged(QtHsvRectPicker::PlaneMode);
 
 protected:
     virtual void drawCrosshair(QPainter *painter, const QPoint &pt);
@@ -56,6 +74,7 @@ protected:
     void paintEvent(QPaintEvent *pe) override;
     void mousePressEvent(QMouseEvent *e) override;
     void mouseMoveEvent(QMouseEvent *e) override;
+    void contextMenuEvent(QContextMenuEvent *e) override;
     void resizeEvent(QResizeEvent *) override;
 
 private:
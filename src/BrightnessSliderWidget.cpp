@@ -1,4 +1,6 @@
 #include "../include/BrightnessSliderWidget.h"
+#include "../include/GradientStrip.h"
+#include "../include/Profiler.h"
 #include <QPainter>
 #include <QMouseEvent>
 
@@ -31,16 +33,15 @@ void BrightnessSliderWidget::setColor(const QColor &color) {
 }
 
 void BrightnessSliderWidget::paintEvent(QPaintEvent *) {
+    const Profiler::Scope scope("BrightnessSliderWidget::paintEvent");
     QPainter p(this);
     p.setRenderHint(QPainter::Antialiasing, false);
 
-    // Draw brightness gradient
-    QLinearGradient grad(0, 0, 0, height());
-    grad.setColorAt(0.0, QColor::fromHsv(m_hue, m_saturation, 255));
-    grad.setColorAt(1.0, QColor::fromHsv(m_hue, m_saturation, 0));
-
-    p.fillRect(rect(), grad);
-
+    // Draw brightness gradient; only hue and saturation select the strip,
+    // so dragging the value reuses it
+    p.drawPixmap(0, 0, GradientStrip::pixmap(GradientStrip::Value,
+                                             QColor::fromHsv(m_hue, m_saturation, 255),
+                                             size(), Qt::Vertical, devicePixelRatioF()));
 
 
     // Draw indicator - triangle pointing to the current brightness level
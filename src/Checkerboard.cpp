@@ -0,0 +1,59 @@
+#include "../include/Checkerboard.h"
+#include <QCoreApplication>
+#include <QHash>
+#include <QPaintDevice>
+#include <QPainter>
+#include <QPixmap>
+#include <QtMath>
+
+namespace {
+
+// Only used from the GUI thread; a handful of sizes ever exist. Pixmaps must
+// not outlive the application, so the cache is emptied on shutdown.
+QHash<quint64, QBrush> &tileCache() {
+  static QHash<quint64, QBrush> cache = [] {
+    qAddPostRoutine([] { tileCache().clear(); });
+    return QHash<quint64, QBrush>();
+  }();
+  return cache;
+}
+
+} // namespace
+
+QBrush Checkerboard::brush(int cellSize, qreal devicePixelRatio) {
+  QHash<quint64, QBrush> &cache = tileCache();
+
+  cellSize = qMax(1, cellSize);
+  const int ratioKey = qRound(devicePixelRatio * 100);
+  const quint64 key = (quint64(cellSize) << 32) | quint32(ratioKey);
+
+  if (const auto it = cache.constFind(key); it != cache.constEnd())
+    return it.value();
+
+  // The tile is rendered at device resolution so cells stay crisp
+  const int tileSize = qCeil(2 * cellSize * devicePixelRatio);
+  const int half = tileSize / 2;
+  QPixmap tile(tileSize, tileSize);
+  tile.fill(Qt::white);
+  {
+    QPainter painter(&tile);
+    painter.fillRect(0, 0, half, half, QColor(204, 204, 204));
+    painter.fillRect(half, half, tileSize - half, tileSize - half,
+                     QColor(204, 204, 204));
+  }
+  tile.setDevicePixelRatio(devicePixelRatio);
+
+  const QBrush result(tile);
+  cache.insert(key, result);
+  return result;
+}
+
+void Checkerboard::paint(QPainter *painter, const QRect &rect, int cellSize) {
+  const qreal ratio =
+      painter->device() ? painter->device()->devicePixelRatioF() : 1.0;
+
+  const QPointF origin = painter->brushOrigin();
+  painter->setBrushOrigin(rect.topLeft());
+  painter->fillRect(rect, brush(cellSize, ratio));
+  painter->setBrushOrigin(origin);
+}
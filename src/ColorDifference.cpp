@@ -0,0 +1,362 @@
+#include "../include/ColorDifference.h"
+#include "../include/ColorMath.h"
+#include <QPair>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr float DEG_TO_RAD = 3.14159265358979f / 180.0f;
+constexpr float RAD_TO_DEG = 180.0f / 3.14159265358979f;
+
+// CIE94 graphic arts weighting factors
+constexpr float CIE94_K1 = 0.045f;
+constexpr float CIE94_K2 = 0.015f;
+
+// Matrices smaller than this are computed on the calling thread
+constexpr qint64 PARALLEL_THRESHOLD = 64 * 1024;
+constexpr int ROWS_PER_BAND = 32;
+
+// 25^7, used by the CIEDE2000 chroma compensation
+constexpr float POW25_7 = 6103515625.0f;
+
+} // namespace
+
+ColorDifference::Lab ColorDifference::toSpace(const QColor &color, Space space) {
+  if (space == OKLab) {
+    Lab lab = ColorSpace::toOklab(color);
+    return {lab.L * 100.0f, lab.a * 100.0f, lab.b * 100.0f};
+  }
+  return ColorSpace::toLab(color);
+}
+
+QVector<ColorDifference::Lab> ColorDifference::toSpace(const QVector<QColor> &colors,
+                                                       Space space) {
+  QVector<Lab> result;
+  result.reserve(colors.size());
+  for (const QColor &color : colors) {
+    result.append(toSpace(color, space));
+  }
+  return result;
+}
+
+float ColorDifference::deltaE(const Lab &reference, const Lab &sample, Metric metric) {
+  switch (metric) {
+  case CIE76: {
+    const float dL = reference.L - sample.L;
+    const float da = reference.a - sample.a;
+    const float db = reference.b - sample.b;
+    return std::sqrt(dL * dL + da * da + db * db);
+  }
+  case CIE94:
+    return cie94(reference, sample);
+  case CIEDE2000:
+    return ciede2000(reference, sample);
+  }
+  return 0.0f;
+}
+
+float ColorDifference::deltaE(const QColor &reference, const QColor &sample, Metric metric,
+                              Space space) {
+  return deltaE(toSpace(reference, space), toSpace(sample, space), metric);
+}
+
+QVector<float> ColorDifference::distances(const Lab &reference, const QVector<Lab> &samples,
+                                          Metric metric) {
+  QVector<float> result(samples.size());
+  if (!samples.isEmpty()) {
+    computeRow(reference, toColumns(samples), metric, result.data());
+  }
+  return result;
+}
+
+QVector<float> ColorDifference::distanceMatrix(const QVector<Lab> &rows,
+                                               const QVector<Lab> &columns, Metric metric) {
+  QVector<float> result(rows.size() * columns.size());
+  distanceMatrix(rows, columns, metric, result.data());
+  return result;
+}
+
+void ColorDifference::distanceMatrix(const QVector<Lab> &rows, const QVector<Lab> &columns,
+                                     Metric metric, float *result) {
+  if (rows.isEmpty() || columns.isEmpty())
+    return;
+
+  const LabColumns cols = toColumns(columns);
+  const qsizetype stride = columns.size();
+
+  if (static_cast<qint64>(rows.size()) * stride < PARALLEL_THRESHOLD) {
+    for (qsizetype r = 0; r < rows.size(); ++r) {
+      computeRow(rows[r], cols, metric, result + r * stride);
+    }
+    return;
+  }
+
+  // Split the matrix into row bands and let the global thread pool fill them
+  QVector<QPair<int, int>> bands;
+  for (int first = 0; first < rows.size(); first += ROWS_PER_BAND) {
+    bands.append(qMakePair(first, qMin<int>(first + ROWS_PER_BAND, rows.size())));
+  }
+
+  QtConcurrent::blockingMap(bands, [&](const QPair<int, int> &band) {
+    for (int r = band.first; r < band.second; ++r) {
+      computeRow(rows[r], cols, metric, result + r * stride);
+    }
+  });
+}
+
+float ColorDifference::paletteDistance(const QVector<QColor> &first,
+                                       const QVector<QColor> &second, Metric metric,
+                                       Space space) {
+  if (first.isEmpty() || second.isEmpty())
+    return 0.0f;
+
+  const QVector<float> matrix =
+      distanceMatrix(toSpace(first, space), toSpace(second, space), metric);
+  const qsizetype stride = second.size();
+
+  // Nearest counterpart for every color of both palettes
+  QVector<float> columnMin(second.size(), std::numeric_limits<float>::max());
+  double total = 0.0;
+  for (qsizetype r = 0; r < first.size(); ++r) {
+    const float *row = matrix.constData() + r * stride;
+    float rowMin = std::numeric_limits<float>::max();
+    for (qsizetype c = 0; c < stride; ++c) {
+      rowMin = std::min(rowMin, row[c]);
+      columnMin[c] = std::min(columnMin[c], row[c]);
+    }
+    total += rowMin;
+  }
+  for (float value : std::as_const(columnMin)) {
+    total += value;
+  }
+
+  return static_cast<float>(total / (first.size() + second.size()));
+}
+
+QVector<QColor> ColorDifference::removeNearDuplicates(const QVector<QColor> &colors,
+                                                      float threshold, Metric metric,
+                                                      Space space) {
+  QVector<QColor> result;
+  QVector<Lab> kept;
+
+  for (const QColor &color : colors) {
+    const Lab lab = toSpace(color, space);
+    bool duplicate = false;
+    for (const Lab &other : std::as_const(kept)) {
+      if (deltaE(other, lab, metric) < threshold) {
+        duplicate = true;
+        break;
+      }
+    }
+
+    if (!duplicate) {
+      kept.append(lab);
+      result.append(color);
+    }
+  }
+
+  return result;
+}
+
+ColorDifference::LabColumns ColorDifference::toColumns(const QVector<Lab> &colors) {
+  LabColumns columns;
+  columns.count = colors.size();
+  columns.L.resize(colors.size());
+  columns.a.resize(colors.size());
+  columns.b.resize(colors.size());
+  columns.C.resize(colors.size());
+
+  for (qsizetype i = 0; i < colors.size(); ++i) {
+    columns.L[i] = colors[i].L;
+    columns.a[i] = colors[i].a;
+    columns.b[i] = colors[i].b;
+    columns.C[i] = std::sqrt(colors[i].a * colors[i].a + colors[i].b * colors[i].b);
+  }
+
+  return columns;
+}
+
+void ColorDifference::computeRow(const Lab &reference, const LabColumns &columns,
+                                 Metric metric, float *result) {
+  switch (metric) {
+  case CIE76:
+    rowCie76(reference, columns, result);
+    break;
+  case CIE94:
+    rowCie94(reference, columns, result);
+    break;
+  case CIEDE2000:
+    rowCiede2000(reference, columns, result);
+    break;
+  }
+}
+
+void ColorDifference::rowCie76(const Lab &reference, const LabColumns &columns,
+                               float *result) {
+  const float *L = columns.L.constData();
+  const float *a = columns.a.constData();
+  const float *b = columns.b.constData();
+  int i = 0;
+
+#ifdef COLORSMITH_HAVE_SSE2
+  const __m128 refL = _mm_set1_ps(reference.L);
+  const __m128 refA = _mm_set1_ps(reference.a);
+  const __m128 refB = _mm_set1_ps(reference.b);
+  for (; i + 4 <= columns.count; i += 4) {
+    const __m128 dL = _mm_sub_ps(refL, _mm_loadu_ps(L + i));
+    const __m128 da = _mm_sub_ps(refA, _mm_loadu_ps(a + i));
+    const __m128 db = _mm_sub_ps(refB, _mm_loadu_ps(b + i));
+    const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dL, dL), _mm_mul_ps(da, da)),
+                                  _mm_mul_ps(db, db));
+    _mm_storeu_ps(result + i, _mm_sqrt_ps(sum));
+  }
+#endif
+
+  for (; i < columns.count; ++i) {
+    const float dL = reference.L - L[i];
+    const float da = reference.a - a[i];
+    const float db = reference.b - b[i];
+    result[i] = std::sqrt(dL * dL + da * da + db * db);
+  }
+}
+
+void ColorDifference::rowCie94(const Lab &reference, const LabColumns &columns,
+                               float *result) {
+  const float *L = columns.L.constData();
+  const float *a = columns.a.constData();
+  const float *b = columns.b.constData();
+  const float *C = columns.C.constData();
+
+  // Weighting depends only on the reference chroma, so it is constant per row
+  const float refC = std::sqrt(reference.a * reference.a + reference.b * reference.b);
+  const float invSC = 1.0f / (1.0f + CIE94_K1 * refC);
+  const float invSH = 1.0f / (1.0f + CIE94_K2 * refC);
+  int i = 0;
+
+#ifdef COLORSMITH_HAVE_SSE2
+  const __m128 refL = _mm_set1_ps(reference.L);
+  const __m128 refA = _mm_set1_ps(reference.a);
+  const __m128 refB = _mm_set1_ps(reference.b);
+  const __m128 refCv = _mm_set1_ps(refC);
+  const __m128 invSCv = _mm_set1_ps(invSC);
+  const __m128 invSHv = _mm_set1_ps(invSH);
+  const __m128 zero = _mm_setzero_ps();
+  for (; i + 4 <= columns.count; i += 4) {
+    const __m128 dL = _mm_sub_ps(refL, _mm_loadu_ps(L + i));
+    const __m128 da = _mm_sub_ps(refA, _mm_loadu_ps(a + i));
+    const __m128 db = _mm_sub_ps(refB, _mm_loadu_ps(b + i));
+    const __m128 dC = _mm_sub_ps(refCv, _mm_loadu_ps(C + i));
+    const __m128 dC2 = _mm_mul_ps(dC, dC);
+    const __m128 dH2 = _mm_max_ps(
+        zero, _mm_sub_ps(_mm_add_ps(_mm_mul_ps(da, da), _mm_mul_ps(db, db)), dC2));
+    const __m128 termC = _mm_mul_ps(dC2, _mm_mul_ps(invSCv, invSCv));
+    const __m128 termH = _mm_mul_ps(dH2, _mm_mul_ps(invSHv, invSHv));
+    const __m128 sum = _mm_add_ps(_mm_mul_ps(dL, dL), _mm_add_ps(termC, termH));
+    _mm_storeu_ps(result + i, _mm_sqrt_ps(sum));
+  }
+#endif
+
+  for (; i < columns.count; ++i) {
+    const float dL = reference.L - L[i];
+    const float da = reference.a - a[i];
+    const float db = reference.b - b[i];
+    const float dC = refC - C[i];
+    const float dH2 = std::max(0.0f, da * da + db * db - dC * dC);
+    result[i] = std::sqrt(dL * dL + dC * dC * invSC * invSC + dH2 * invSH * invSH);
+  }
+}
+
+void ColorDifference::rowCiede2000(const Lab &reference, const LabColumns &columns,
+                                   float *result) {
+  // The hue terms need trigonometry per pair, so this row stays scalar and
+  // relies on the row-level parallelism of distanceMatrix()
+  for (int i = 0; i < columns.count; ++i) {
+    result[i] = ciede2000(reference, {columns.L[i], columns.a[i], columns.b[i]});
+  }
+}
+
+float ColorDifference::cie94(const Lab &reference, const Lab &sample) {
+  const float C1 = std::sqrt(reference.a * reference.a + reference.b * reference.b);
+  const float C2 = std::sqrt(sample.a * sample.a + sample.b * sample.b);
+  const float dL = reference.L - sample.L;
+  const float da = reference.a - sample.a;
+  const float db = reference.b - sample.b;
+  const float dC = C1 - C2;
+  const float dH2 = std::max(0.0f, da * da + db * db - dC * dC);
+  const float SC = 1.0f + CIE94_K1 * C1;
+  const float SH = 1.0f + CIE94_K2 * C1;
+  return std::sqrt(dL * dL + (dC * dC) / (SC * SC) + dH2 / (SH * SH));
+}
+
+float ColorDifference::ciede2000(const Lab &reference, const Lab &sample) {
+  const float C1 = std::sqrt(reference.a * reference.a + reference.b * reference.b);
+  const float C2 = std::sqrt(sample.a * sample.a + sample.b * sample.b);
+  const float Cbar = 0.5f * (C1 + C2);
+  const float Cbar7 = std::pow(Cbar, 7.0f);
+  const float G = 0.5f * (1.0f - std::sqrt(Cbar7 / (Cbar7 + POW25_7)));
+
+  const float a1 = (1.0f + G) * reference.a;
+  const float a2 = (1.0f + G) * sample.a;
+  const float C1p = std::sqrt(a1 * a1 + reference.b * reference.b);
+  const float C2p = std::sqrt(a2 * a2 + sample.b * sample.b);
+
+  auto hueAngle = [](float b, float a) {
+    if (a == 0.0f && b == 0.0f)
+      return 0.0f;
+    float h = std::atan2(b, a) * RAD_TO_DEG;
+    return h < 0.0f ? h + 360.0f : h;
+  };
+  const float h1p = hueAngle(reference.b, a1);
+  const float h2p = hueAngle(sample.b, a2);
+
+  const float dLp = sample.L - reference.L;
+  const float dCp = C2p - C1p;
+
+  const float chromaProduct = C1p * C2p;
+  float dhp = 0.0f;
+  if (chromaProduct != 0.0f) {
+    dhp = h2p - h1p;
+    if (dhp > 180.0f)
+      dhp -= 360.0f;
+    else if (dhp < -180.0f)
+      dhp += 360.0f;
+  }
+  const float dHp = 2.0f * std::sqrt(chromaProduct) * std::sin(0.5f * dhp * DEG_TO_RAD);
+
+  const float Lbarp = 0.5f * (reference.L + sample.L);
+  const float Cbarp = 0.5f * (C1p + C2p);
+
+  float hbarp = h1p + h2p;
+  if (chromaProduct != 0.0f) {
+    if (std::fabs(h1p - h2p) <= 180.0f)
+      hbarp *= 0.5f;
+    else if (hbarp < 360.0f)
+      hbarp = 0.5f * (hbarp + 360.0f);
+    else
+      hbarp = 0.5f * (hbarp - 360.0f);
+  }
+
+  const float T = 1.0f - 0.17f * std::cos((hbarp - 30.0f) * DEG_TO_RAD) +
+                  0.24f * std::cos(2.0f * hbarp * DEG_TO_RAD) +
+                  0.32f * std::cos((3.0f * hbarp + 6.0f) * DEG_TO_RAD) -
+                  0.20f * std::cos((4.0f * hbarp - 63.0f) * DEG_TO_RAD);
+
+  const float hueOffset = (hbarp - 275.0f) / 25.0f;
+  const float dTheta = 30.0f * std::exp(-hueOffset * hueOffset);
+  const float Cbarp7 = std::pow(Cbarp, 7.0f);
+  const float RC = 2.0f * std::sqrt(Cbarp7 / (Cbarp7 + POW25_7));
+  const float lightnessOffset = (Lbarp - 50.0f) * (Lbarp - 50.0f);
+  const float SL = 1.0f + 0.015f * lightnessOffset / std::sqrt(20.0f + lightnessOffset);
+  const float SC = 1.0f + 0.045f * Cbarp;
+  const float SH = 1.0f + 0.015f * Cbarp * T;
+  const float RT = -std::sin(2.0f * dTheta * DEG_TO_RAD) * RC;
+
+  const float termL = dLp / SL;
+  const float termC = dCp / SC;
+  const float termH = dHp / SH;
+  return std::sqrt(std::max(
+      0.0f, termL * termL + termC * termC + termH * termH + RT * termC * termH));
+}
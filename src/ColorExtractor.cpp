@@ -1,8 +1,10 @@
 #include "../include/ColorExtractor.h"
+#include "../include/Profiler.h"
 #include <algorithm>
 #include <climits>
 
 QVector<QColor> ColorExtractor::extractDominantColors(const QImage &image, int colorCount) {
+    const Profiler::Scope scope("ColorExtractor::extractDominantColors");
     if (image.isNull() || colorCount <= 0)
         return QVector<QColor>();
 
@@ -1,7 +1,11 @@
 #include "../include/ColorLogic.h"
+#include "../include/ColorSpace.h"
 #include <QRandomGenerator>
 #include <QRegularExpression>
+#include <QStringList>
+#include <QVector>
 #include <QtMath>
+#include <cstring>
 
 // HEX format
 QString ColorLogic::colorToHex(const QColor &color) {
@@ -148,6 +152,223 @@ QColor ColorLogic::cmykStringToColor(const QString &cmykString) {
     return QColor();
 }
 
+// Formats by name
+QStringList ColorLogic::formatNames() {
+    return {"hex", "rgb", "rgba", "hsl", "hsla", "hsv", "cmyk"};
+}
+
+QString ColorLogic::colorToString(const QColor &color, const QString &format) {
+    if (format == QLatin1String("rgb"))
+        return colorToRgbString(color);
+    if (format == QLatin1String("rgba"))
+        return colorToRgbaString(color);
+    if (format == QLatin1String("hsl"))
+        return colorToHslString(color);
+    if (format == QLatin1String("hsla"))
+        return colorToHslaString(color);
+    if (format == QLatin1String("hsv"))
+        return colorToHsvString(color);
+    if (format == QLatin1String("cmyk"))
+        return colorToCmykString(color);
+    return colorToHex(color);
+}
+
+QColor ColorLogic::stringToColor(const QString &text, QString *format) {
+    // HEX first, as the most common for pasting
+    static const struct {
+        const char *name;
+        QColor (*parse)(const QString &);
+    } parsers[] = {
+        {"hex", hexToColor},
+        {"rgb", rgbStringToColor},
+        {"rgba", rgbaStringToColor},
+        {"hsl", hslStringToColor},
+        {"hsla", hslaStringToColor},
+        {"hsv", hsvStringToColor},
+        {"cmyk", cmykStringToColor},
+    };
+
+    for (const auto &parser : parsers) {
+        const QColor color = parser.parse(text);
+        if (color.isValid()) {
+            if (format)
+                *format = QLatin1String(parser.name);
+            return color;
+        }
+    }
+    return QColor();
+}
+
+// Storage format
+QString ColorLogic::colorToStorageString(const QColor &color) {
+    return packedToStorageString(toPacked(color));
+}
+
+QString ColorLogic::packedToStorageString(const PackedColor &packed) {
+    if (isEightBit(packed)) {
+        return fromPacked(packed).name(QColor::HexArgb);
+    }
+
+    QString text = QString("color(srgb %1 %2 %3")
+            .arg(QString::number(packed.red(), 'g', 6),
+                 QString::number(packed.green(), 'g', 6),
+                 QString::number(packed.blue(), 'g', 6));
+    if (packed.alpha() < 1.0f) {
+        text += QString(" / %1").arg(QString::number(packed.alpha(), 'g', 6));
+    }
+    return text + ")";
+}
+
+QColor ColorLogic::storageStringToColor(const QString &text) {
+    static QRegularExpression re("^color\\(\\s*srgb\\s+([-+0-9.eE]+)\\s+([-+0-9.eE]+)\\s+([-+0-9.eE]+)"
+                                 "(?:\\s*/\\s*([-+0-9.eE]+))?\\s*\\)$");
+    const QString trimmed = text.trimmed();
+    QRegularExpressionMatch match = re.match(trimmed);
+    if (match.hasMatch()) {
+        float r = match.captured(1).toFloat();
+        float g = match.captured(2).toFloat();
+        float b = match.captured(3).toFloat();
+        float a = match.captured(4).isEmpty() ? 1.0f : match.captured(4).toFloat();
+        return QColor::fromRgbF(r, g, b, qBound(0.0f, a, 1.0f));
+    }
+
+    if (QColor color(trimmed); color.isValid()) {
+        return color;
+    }
+    return hexToColor(trimmed);
+}
+
+// Packed representation
+PackedColor ColorLogic::toPacked(const QColor &color) {
+    float r, g, b, a;
+    color.getRgbF(&r, &g, &b, &a);
+    return packedFromRgbF(r, g, b, a);
+}
+
+PackedColor ColorLogic::packedFromRgbF(float r, float g, float b, float a) {
+    return PackedColor{qfloat16(r), qfloat16(g), qfloat16(b), qfloat16(a)};
+}
+
+bool ColorLogic::hexToPacked(QByteArrayView hex, PackedColor *packed, bool alphaLast) {
+    if (!hex.isEmpty() && hex.at(0) == '#') {
+        hex = hex.sliced(1);
+    }
+
+    const qsizetype digits = hex.size();
+    if (digits != 3 && digits != 4 && digits != 6 && digits != 8) {
+        return false;
+    }
+
+    auto nibble = [](char c) {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    };
+
+    // Short forms repeat each digit (#abc == #aabbcc)
+    const int width = digits <= 4 ? 1 : 2;
+    float channels[4];
+    for (int i = 0; i < digits / width; ++i) {
+        int value = 0;
+        for (int j = 0; j < width; ++j) {
+            const int n = nibble(hex.at(i * width + j));
+            if (n < 0) {
+                return false;
+            }
+            value = value * 16 + n;
+        }
+        channels[i] = (width == 1 ? value * 17 : value) / 255.0f;
+    }
+
+    if (digits == 3 || digits == 6) {
+        *packed = packedFromRgbF(channels[0], channels[1], channels[2]);
+    } else if (alphaLast) {
+        *packed = packedFromRgbF(channels[0], channels[1], channels[2], channels[3]);
+    } else {
+        *packed = packedFromRgbF(channels[1], channels[2], channels[3], channels[0]);
+    }
+    return true;
+}
+
+QColor ColorLogic::fromPacked(const PackedColor &packed) {
+    return QColor::fromRgbF(packed.red(), packed.green(), packed.blue(), packed.alpha());
+}
+
+quint64 ColorLogic::packedKey(const PackedColor &packed) {
+    static_assert(sizeof(PackedColor) == sizeof(quint64), "PackedColor must be 8 bytes");
+    quint64 key;
+    std::memcpy(&key, &packed, sizeof(key));
+    return key;
+}
+
+bool ColorLogic::isEightBit(const PackedColor &packed) {
+    // A channel is 8-bit when quantizing it to 1/255 steps packs to the same half
+    auto isExact = [](float value) {
+        if (value < 0.0f || value > 1.0f)
+            return false;
+        return float(qfloat16(qRound(value * 255.0f) / 255.0f)) == value;
+    };
+    return isExact(packed.red()) && isExact(packed.green()) && isExact(packed.blue()) &&
+           isExact(packed.alpha());
+}
+
+// Contrast
+double ColorLogic::relativeLuminance(const QColor &color) {
+    auto toLinear = [](double val) {
+        return (val <= 0.03928) ? val / 12.92 : qPow((val + 0.055) / 1.055, 2.4);
+    };
+    return 0.2126 * toLinear(color.redF()) + 0.7152 * toLinear(color.greenF()) +
+           0.0722 * toLinear(color.blueF());
+}
+
+double ColorLogic::contrastRatio(const QColor &first, const QColor &second) {
+    double l1 = relativeLuminance(first);
+    double l2 = relativeLuminance(second);
+
+    // Ensure l1 is the lighter color
+    if (l1 < l2) {
+        qSwap(l1, l2);
+    }
+    return (l1 + 0.05) / (l2 + 0.05);
+}
+
+// Names
+QString ColorLogic::nearestColorName(const QColor &color) {
+    struct NamedColor {
+        QString name;
+        ColorSpace::Lab lab;
+    };
+
+    // Synonyms such as aqua and cyan keep the alphabetically first name
+    static const QVector<NamedColor> named = [] {
+        QVector<NamedColor> list;
+        for (const QString &name : QColor::colorNames()) {
+            if (name != QLatin1String("transparent"))
+                list.append({name, ColorSpace::toOklab(QColor(name))});
+        }
+        return list;
+    }();
+
+    const ColorSpace::Lab lab = ColorSpace::toOklab(color);
+    const NamedColor *nearest = nullptr;
+    float nearestDistance = 0.0f;
+    for (const NamedColor &candidate : named) {
+        const float dL = candidate.lab.L - lab.L;
+        const float da = candidate.lab.a - lab.a;
+        const float db = candidate.lab.b - lab.b;
+        const float distance = dL * dL + da * da + db * db;
+        if (!nearest || distance < nearestDistance) {
+            nearest = &candidate;
+            nearestDistance = distance;
+        }
+    }
+    return nearest ? nearest->name : QString();
+}
+
 // Utility
 QColor ColorLogic::randomColor() {
     return QColor(
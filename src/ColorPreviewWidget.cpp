@@ -1,4 +1,5 @@
 #include "../include/ColorPreviewWidget.h"
+#include "../include/Checkerboard.h"
 #include <QPainter>
 #include <QPaintEvent>
 #include <QApplication>
@@ -31,15 +32,7 @@ void ColorPreviewWidget::paintEvent(QPaintEvent* event) {
     QRect contentRect = contentsRect();
 
     // Draw checkered background for transparency
-    painter.fillRect(contentRect, Qt::white);
-    int checkerSize = 10;
-    for (int y = contentRect.top(); y < contentRect.bottom(); y += checkerSize) {
-        for (int x = contentRect.left(); x < contentRect.right(); x += checkerSize) {
-            if ((x / checkerSize + y / checkerSize) % 2 == 0) {
-                painter.fillRect(x, y, checkerSize, checkerSize, QColor(204, 204, 204));
-            }
-        }
-    }
+    Checkerboard::paint(&painter, contentRect, 10);
 
     // Draw the actual color on top
     painter.fillRect(contentRect, m_color);
@@ -95,15 +88,7 @@ void ColorPreviewWidget::showColorPreview() {
             QRect contentRect = contentsRect();
 
             // Draw checkered background for transparency
-            painter.fillRect(contentRect, Qt::white);
-            int checkerSize = 15;
-            for (int y = contentRect.top(); y < contentRect.bottom(); y += checkerSize) {
-                for (int x = contentRect.left(); x < contentRect.right(); x += checkerSize) {
-                    if ((x / checkerSize + y / checkerSize) % 2 == 0) {
-                        painter.fillRect(x, y, checkerSize, checkerSize, QColor(204, 204, 204));
-                    }
-                }
-            }
+            Checkerboard::paint(&painter, contentRect, 15);
 
             // Draw the actual color on top
             painter.fillRect(contentRect, color);
@@ -0,0 +1,286 @@
+#include "../include/ColorRaster.h"
+#include "../include/ColorMath.h"
+#include "../include/ColorSpace.h"
+#include <QPair>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtMath>
+#include <array>
+#include <cmath>
+#include <functional>
+
+namespace {
+
+// Planes smaller than this are filled on the calling thread
+constexpr qint64 PARALLEL_THRESHOLD = 256 * 256;
+constexpr int ROWS_PER_BAND = 64;
+
+// Linear light is encoded to sRGB through a table of this many steps,
+// fine enough to stay within a fraction of a level near black
+constexpr int ENCODE_STEPS = 16383;
+
+const std::array<uchar, ENCODE_STEPS + 1> &encodeTable() {
+  static const std::array<uchar, ENCODE_STEPS + 1> table = [] {
+    std::array<uchar, ENCODE_STEPS + 1> t;
+    for (int i = 0; i <= ENCODE_STEPS; ++i) {
+      const float c = ColorSpace::linearToSrgb(float(i) / ENCODE_STEPS);
+      t[i] = uchar(qBound(0, qRound(c * 255.0f), 255));
+    }
+    return t;
+  }();
+  return table;
+}
+
+bool inGamut(float c) {
+  return c >= -ColorMath::GAMUT_EPSILON &&
+         c <= 1.0f + ColorMath::GAMUT_EPSILON;
+}
+
+uchar encode(const std::array<uchar, ENCODE_STEPS + 1> &table, float c) {
+  return table[int(qBound(0.0f, c, 1.0f) * ENCODE_STEPS + 0.5f)];
+}
+
+void packLinearRow(QRgb *line, const float *red, const float *green,
+                   const float *blue, int width, QRgb outOfGamut) {
+  const std::array<uchar, ENCODE_STEPS + 1> &table = encodeTable();
+  outOfGamut |= 0xff000000u;
+  for (int x = 0; x < width; ++x) {
+    if (!inGamut(red[x]) || !inGamut(green[x]) || !inGamut(blue[x])) {
+      line[x] = outOfGamut;
+      continue;
+    }
+    line[x] = qRgb(encode(table, red[x]), encode(table, green[x]),
+                   encode(table, blue[x]));
+  }
+}
+
+// Calls fillRows(first, last) over the image's rows, split into bands on
+// the global thread pool when the image is large. fillRows must address
+// rows through bits(): scanLine() detaches, which must not run on several
+// threads at once.
+void forEachRowBand(const QImage &image,
+                    const std::function<void(int, int)> &fillRows) {
+  const int height = image.height();
+  if (static_cast<qint64>(image.width()) * height < PARALLEL_THRESHOLD) {
+    fillRows(0, height);
+    return;
+  }
+
+  QVector<QPair<int, int>> bands;
+  for (int first = 0; first < height; first += ROWS_PER_BAND) {
+    bands.append(qMakePair(first, qMin(first + ROWS_PER_BAND, height)));
+  }
+
+  QtConcurrent::blockingMap(bands, [&](const QPair<int, int> &band) {
+    fillRows(band.first, band.second);
+  });
+}
+
+QRgb *lineAt(uchar *bits, qsizetype bytesPerLine, int y) {
+  return reinterpret_cast<QRgb *>(bits + y * bytesPerLine);
+}
+
+// Shared by the HSV and HSL planes; row(line, saturation) fills one row
+void fillHuePlane(QImage *image, const ColorRaster::HueRamp &ramp,
+                  float satTop, float satBottom,
+                  const std::function<void(QRgb *, float)> &row) {
+  Q_ASSERT(image->format() == QImage::Format_RGB32);
+  Q_ASSERT(image->width() == ramp.width());
+  Q_UNUSED(ramp);
+
+  const int height = image->height();
+  const float step = height > 0 ? (satBottom - satTop) / height : 0.0f;
+  uchar *bits = image->bits();
+  const qsizetype bytesPerLine = image->bytesPerLine();
+
+  forEachRowBand(*image, [&](int first, int last) {
+    for (int y = first; y < last; ++y) {
+      row(lineAt(bits, bytesPerLine, y),
+          qBound(0.0f, satTop + step * y, 1.0f));
+    }
+  });
+}
+
+} // namespace
+
+ColorRaster::HueRamp ColorRaster::hueRamp(int width, float hueLeft,
+                                          float hueRight) {
+  HueRamp ramp;
+  width = qMax(0, width);
+  ramp.red.resize(width);
+  ramp.green.resize(width);
+  ramp.blue.resize(width);
+
+  const float step = width > 0 ? (hueRight - hueLeft) / width : 0.0f;
+  for (int x = 0; x < width; ++x) {
+    // Sector position 0..6; each channel is a clamped triangle over it
+    const float h = qBound(0.0f, (hueLeft + step * x) / 60.0f, 6.0f);
+    ramp.red[x] = 255.0f * qBound(0.0f, qAbs(h - 3.0f) - 1.0f, 1.0f);
+    ramp.green[x] = 255.0f * qBound(0.0f, 2.0f - qAbs(h - 2.0f), 1.0f);
+    ramp.blue[x] = 255.0f * qBound(0.0f, 2.0f - qAbs(h - 4.0f), 1.0f);
+  }
+  return ramp;
+}
+
+void ColorRaster::hueRampRow(QRgb *line, const HueRamp &ramp, float offset,
+                             float scale) {
+  const float *red = ramp.red.constData();
+  const float *green = ramp.green.constData();
+  const float *blue = ramp.blue.constData();
+  const int width = ramp.width();
+
+  // The 0.5 rounds on truncation
+  offset += 0.5f;
+  int x = 0;
+
+#ifdef COLORSMITH_HAVE_SSE2
+  const __m128 offsetv = _mm_set1_ps(offset);
+  const __m128 scalev = _mm_set1_ps(scale);
+  const __m128i opaque = _mm_set1_epi32(int(0xff000000u));
+  for (; x + 4 <= width; x += 4) {
+    const __m128i r = _mm_cvttps_epi32(
+        _mm_add_ps(offsetv, _mm_mul_ps(scalev, _mm_loadu_ps(red + x))));
+    const __m128i g = _mm_cvttps_epi32(
+        _mm_add_ps(offsetv, _mm_mul_ps(scalev, _mm_loadu_ps(green + x))));
+    const __m128i b = _mm_cvttps_epi32(
+        _mm_add_ps(offsetv, _mm_mul_ps(scalev, _mm_loadu_ps(blue + x))));
+    const __m128i pixels = _mm_or_si128(
+        _mm_or_si128(opaque, _mm_slli_epi32(r, 16)),
+        _mm_or_si128(_mm_slli_epi32(g, 8), b));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(line + x), pixels);
+  }
+#endif
+
+  for (; x < width; ++x) {
+    const quint32 r = quint32(int(offset + scale * red[x]));
+    const quint32 g = quint32(int(offset + scale * green[x]));
+    const quint32 b = quint32(int(offset + scale * blue[x]));
+    line[x] = 0xff000000u | (r << 16) | (g << 8) | b;
+  }
+}
+
+void ColorRaster::hsvRow(QRgb *line, const HueRamp &ramp, float saturation,
+                         float value) {
+  hueRampRow(line, ramp, 255.0f * value * (1.0f - saturation),
+             value * saturation);
+}
+
+void ColorRaster::hslRow(QRgb *line, const HueRamp &ramp, float saturation,
+                         float lightness) {
+  const float chroma = (1.0f - qAbs(2.0f * lightness - 1.0f)) * saturation;
+  hueRampRow(line, ramp, 255.0f * (lightness - chroma / 2.0f), chroma);
+}
+
+void ColorRaster::hsvPlane(QImage *image, const HueRamp &ramp, float satTop,
+                           float satBottom, float value) {
+  value = qBound(0.0f, value, 1.0f);
+  fillHuePlane(image, ramp, satTop, satBottom,
+               [&](QRgb *line, float saturation) {
+                 hsvRow(line, ramp, saturation, value);
+               });
+}
+
+void ColorRaster::hslPlane(QImage *image, const HueRamp &ramp, float satTop,
+                           float satBottom, float lightness) {
+  lightness = qBound(0.0f, lightness, 1.0f);
+  fillHuePlane(image, ramp, satTop, satBottom,
+               [&](QRgb *line, float saturation) {
+                 hslRow(line, ramp, saturation, lightness);
+               });
+}
+
+void ColorRaster::oklchPlane(QImage *image, float hueLeft, float hueRight,
+                             float chromaTop, float chromaBottom,
+                             float lightness, QRgb outOfGamut) {
+  Q_ASSERT(image->format() == QImage::Format_RGB32);
+
+  const int width = image->width();
+  const int height = image->height();
+
+  // a and b are the row's chroma times the column's cosine and sine of hue
+  QVector<float> columns(2 * width);
+  float *cosHue = columns.data();
+  float *sinHue = cosHue + width;
+  const float hueStep = width > 0 ? (hueRight - hueLeft) / width : 0.0f;
+  for (int x = 0; x < width; ++x) {
+    const float h = qDegreesToRadians(hueLeft + hueStep * x);
+    cosHue[x] = std::cos(h);
+    sinHue[x] = std::sin(h);
+  }
+
+  const float chromaStep =
+      height > 0 ? (chromaBottom - chromaTop) / height : 0.0f;
+  uchar *bits = image->bits();
+  const qsizetype bytesPerLine = image->bytesPerLine();
+
+  forEachRowBand(*image, [&](int first, int last) {
+    QVector<float> scratch(5 * width);
+    float *a = scratch.data();
+    float *b = a + width;
+    float *red = b + width;
+    float *green = red + width;
+    float *blue = green + width;
+
+    for (int y = first; y < last; ++y) {
+      const float chroma = qMax(0.0f, chromaTop + chromaStep * y);
+      for (int x = 0; x < width; ++x) {
+        a[x] = chroma * cosHue[x];
+        b[x] = chroma * sinHue[x];
+      }
+      ColorSpace::oklabToLinearRgb(lightness, a, b, width, red, green, blue);
+      packLinearRow(lineAt(bits, bytesPerLine, y), red, green, blue, width,
+                    outOfGamut);
+    }
+  });
+}
+
+void ColorRaster::labPlane(QImage *image, float aLeft, float aRight,
+                           float bTop, float bBottom, float lightness,
+                           QRgb outOfGamut) {
+  Q_ASSERT(image->format() == QImage::Format_RGB32);
+
+  const int width = image->width();
+  const int height = image->height();
+
+  // At a fixed L, X only depends on a and Z only on b, so linear RGB is a
+  // column term plus a row term: rgb(a, b) = rgb(a, 0) + rgb(0, b) - rgb(0, 0)
+  QVector<float> columns(3 * width);
+  float *columnRed = columns.data();
+  float *columnGreen = columnRed + width;
+  float *columnBlue = columnGreen + width;
+  const float aStep = width > 0 ? (aRight - aLeft) / width : 0.0f;
+  for (int x = 0; x < width; ++x) {
+    const ColorSpace::Rgb rgb =
+        ColorSpace::labToLinearRgb({lightness, aLeft + aStep * x, 0.0f});
+    columnRed[x] = rgb.r;
+    columnGreen[x] = rgb.g;
+    columnBlue[x] = rgb.b;
+  }
+
+  const ColorSpace::Rgb origin =
+      ColorSpace::labToLinearRgb({lightness, 0.0f, 0.0f});
+  const float bStep = height > 0 ? (bBottom - bTop) / height : 0.0f;
+  uchar *bits = image->bits();
+  const qsizetype bytesPerLine = image->bytesPerLine();
+
+  forEachRowBand(*image, [&](int first, int last) {
+    QVector<float> scratch(3 * width);
+    float *red = scratch.data();
+    float *green = red + width;
+    float *blue = green + width;
+
+    for (int y = first; y < last; ++y) {
+      const ColorSpace::Rgb row =
+          ColorSpace::labToLinearRgb({lightness, 0.0f, bTop + bStep * y});
+      const float dr = row.r - origin.r;
+      const float dg = row.g - origin.g;
+      const float db = row.b - origin.b;
+      for (int x = 0; x < width; ++x) {
+        red[x] = columnRed[x] + dr;
+        green[x] = columnGreen[x] + dg;
+        blue[x] = columnBlue[x] + db;
+      }
+      packLinearRow(lineAt(bits, bytesPerLine, y), red, green, blue, width,
+                    outOfGamut);
+    }
+  });
+}
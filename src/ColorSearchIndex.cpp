@@ -0,0 +1,273 @@
+#include "../include/ColorSearchIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <utility>
+
+ColorSearchIndex::ColorSearchIndex()
+    : m_cells(DIM_L * DIM_A * DIM_B), m_size(0) {}
+
+ColorSearchIndex::CellCoord ColorSearchIndex::cellOf(float L, float a,
+                                                     float b) const {
+  auto axis = [](float value, float minimum, int dim) {
+    return qBound(0, static_cast<int>(std::floor((value - minimum) / CELL_SIZE)),
+                  dim - 1);
+  };
+  return {axis(L, MIN_L, DIM_L), axis(a, MIN_A, DIM_A), axis(b, MIN_B, DIM_B)};
+}
+
+void ColorSearchIndex::setPaletteColors(PaletteHandle palette,
+                                        const QVector<PackedColor> &colors) {
+  removePalette(palette);
+  if (colors.isEmpty())
+    return;
+
+  QVector<int> &touched = m_cellsByPalette[palette];
+
+  for (int i = 0; i < colors.size(); ++i) {
+    const ColorDifference::Lab lab = ColorDifference::toSpace(
+        ColorLogic::fromPacked(colors[i]), ColorDifference::OKLab);
+    const CellCoord c = cellOf(lab.L, lab.a, lab.b);
+    const int cell = cellIndex(c.x, c.y, c.z);
+
+    QVector<Point> &points = m_cells[cell];
+    // Cheap filter for runs of similar colors; the list is deduplicated below
+    if (points.isEmpty() || points.last().palette != palette) {
+      touched.append(cell);
+    }
+    points.append({lab.L, lab.a, lab.b, palette, i});
+  }
+
+  std::sort(touched.begin(), touched.end());
+  touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+  m_size += colors.size();
+}
+
+void ColorSearchIndex::removePalette(PaletteHandle palette) {
+  const auto it = m_cellsByPalette.constFind(palette);
+  if (it == m_cellsByPalette.constEnd())
+    return;
+
+  for (int cell : it.value()) {
+    QVector<Point> &points = m_cells[cell];
+    const auto end =
+        std::remove_if(points.begin(), points.end(),
+                       [palette](const Point &p) { return p.palette == palette; });
+    m_size -= static_cast<int>(points.end() - end);
+    points.erase(end, points.end());
+  }
+
+  m_cellsByPalette.erase(it);
+}
+
+void ColorSearchIndex::addPoint(PaletteHandle palette, const PackedColor &color,
+                                int index, QVector<int> *touched) {
+  const ColorDifference::Lab lab = ColorDifference::toSpace(
+      ColorLogic::fromPacked(color), ColorDifference::OKLab);
+  const CellCoord c = cellOf(lab.L, lab.a, lab.b);
+  const int cell = cellIndex(c.x, c.y, c.z);
+
+  m_cells[cell].append({lab.L, lab.a, lab.b, palette, index});
+
+  const auto it = std::lower_bound(touched->begin(), touched->end(), cell);
+  if (it == touched->end() || *it != cell) {
+    touched->insert(it, cell);
+  }
+}
+
+void ColorSearchIndex::insertColors(PaletteHandle palette,
+                                    const QVector<PackedColor> &colors,
+                                    int index, int count) {
+  if (count <= 0 || index < 0 || index + count > colors.size())
+    return;
+
+  QVector<int> &touched = m_cellsByPalette[palette];
+
+  // Renumber before adding, so the new colors are not shifted themselves
+  for (int cell : std::as_const(touched)) {
+    for (Point &p : m_cells[cell]) {
+      if (p.palette == palette && p.index >= index) {
+        p.index += count;
+      }
+    }
+  }
+
+  for (int i = index; i < index + count; ++i) {
+    addPoint(palette, colors[i], i, &touched);
+  }
+
+  m_size += count;
+}
+
+void ColorSearchIndex::removeColors(PaletteHandle palette, int index,
+                                    int count) {
+  const auto it = m_cellsByPalette.find(palette);
+  if (it == m_cellsByPalette.end() || count <= 0)
+    return;
+
+  QVector<int> &touched = it.value();
+  const int end = index + count;
+  int kept = 0;
+
+  for (int i = 0; i < touched.size(); ++i) {
+    QVector<Point> &points = m_cells[touched[i]];
+    const auto removed = std::remove_if(
+        points.begin(), points.end(), [&](const Point &p) {
+          return p.palette == palette && p.index >= index && p.index < end;
+        });
+    m_size -= static_cast<int>(points.end() - removed);
+    points.erase(removed, points.end());
+
+    bool stillTouched = false;
+    for (Point &p : points) {
+      if (p.palette != palette)
+        continue;
+      if (p.index >= end) {
+        p.index -= count;
+      }
+      stillTouched = true;
+    }
+
+    if (stillTouched) {
+      touched[kept++] = touched[i];
+    }
+  }
+
+  touched.resize(kept);
+  if (touched.isEmpty()) {
+    m_cellsByPalette.erase(it);
+  }
+}
+
+void ColorSearchIndex::moveColor(PaletteHandle palette, int from, int to) {
+  const auto it = m_cellsByPalette.constFind(palette);
+  if (it == m_cellsByPalette.constEnd() || from == to)
+    return;
+
+  // Colors between the two positions close the gap, as in Palette::moveColor
+  const int low = std::min(from, to);
+  const int high = std::max(from, to);
+  const int shift = from < to ? -1 : 1;
+
+  for (int cell : it.value()) {
+    for (Point &p : m_cells[cell]) {
+      if (p.palette != palette || p.index < low || p.index > high)
+        continue;
+      p.index = p.index == from ? to : p.index + shift;
+    }
+  }
+}
+
+void ColorSearchIndex::clear() {
+  for (QVector<Point> &points : m_cells) {
+    points.clear();
+  }
+  m_cellsByPalette.clear();
+  m_size = 0;
+}
+
+QVector<ColorSearchIndex::Match>
+ColorSearchIndex::withinRadius(const QColor &color, float radius) const {
+  QVector<Match> matches;
+  if (!color.isValid() || radius < 0.0f)
+    return matches;
+
+  const ColorDifference::Lab q =
+      ColorDifference::toSpace(color, ColorDifference::OKLab);
+  const CellCoord lo = cellOf(q.L - radius, q.a - radius, q.b - radius);
+  const CellCoord hi = cellOf(q.L + radius, q.a + radius, q.b + radius);
+  const float radius2 = radius * radius;
+
+  for (int x = lo.x; x <= hi.x; ++x) {
+    for (int y = lo.y; y <= hi.y; ++y) {
+      for (int z = lo.z; z <= hi.z; ++z) {
+        for (const Point &p : m_cells[cellIndex(x, y, z)]) {
+          const float dL = p.L - q.L;
+          const float da = p.a - q.a;
+          const float db = p.b - q.b;
+          const float d2 = dL * dL + da * da + db * db;
+          if (d2 <= radius2) {
+            matches.append({p.palette, p.index, std::sqrt(d2)});
+          }
+        }
+      }
+    }
+  }
+
+  std::sort(matches.begin(), matches.end(),
+            [](const Match &a, const Match &b) { return a.distance < b.distance; });
+  return matches;
+}
+
+QVector<ColorSearchIndex::Match> ColorSearchIndex::nearest(const QColor &color,
+                                                           int k) const {
+  QVector<Match> matches;
+  if (!color.isValid() || k <= 0 || m_size == 0)
+    return matches;
+
+  const ColorDifference::Lab q =
+      ColorDifference::toSpace(color, ColorDifference::OKLab);
+  const CellCoord center = cellOf(q.L, q.a, q.b);
+
+  // Max-heap holding the best k so far; distances stay squared until the end
+  auto farther = [](const Match &a, const Match &b) {
+    return a.distance < b.distance;
+  };
+  std::priority_queue<Match, std::vector<Match>, decltype(farther)> best(farther);
+
+  auto visitCell = [&](int x, int y, int z) {
+    for (const Point &p : m_cells[cellIndex(x, y, z)]) {
+      const float dL = p.L - q.L;
+      const float da = p.a - q.a;
+      const float db = p.b - q.b;
+      const float d2 = dL * dL + da * da + db * db;
+      if (int(best.size()) < k) {
+        best.push({p.palette, p.index, d2});
+      } else if (d2 < best.top().distance) {
+        best.pop();
+        best.push({p.palette, p.index, d2});
+      }
+    }
+  };
+
+  const int maxRing = std::max({DIM_L, DIM_A, DIM_B});
+
+  // Visit shells of cells at growing Chebyshev distance from the query cell.
+  // Every cell beyond ring r is at least r cells away, so the search stops
+  // once the k-th best is closer than that.
+  for (int ring = 0; ring <= maxRing; ++ring) {
+    for (int x = center.x - ring; x <= center.x + ring; ++x) {
+      if (x < 0 || x >= DIM_L)
+        continue;
+      for (int y = center.y - ring; y <= center.y + ring; ++y) {
+        if (y < 0 || y >= DIM_A)
+          continue;
+        const bool onShellXY = std::abs(x - center.x) == ring ||
+                               std::abs(y - center.y) == ring;
+        // Inside the shell only the two z faces are new
+        const int step = onShellXY ? 1 : std::max(1, 2 * ring);
+        for (int z = center.z - ring; z <= center.z + ring; z += step) {
+          if (z >= 0 && z < DIM_B) {
+            visitCell(x, y, z);
+          }
+        }
+      }
+    }
+
+    if (int(best.size()) == k) {
+      const float bound = ring * CELL_SIZE;
+      if (best.top().distance <= bound * bound)
+        break;
+    }
+  }
+
+  matches.resize(static_cast<int>(best.size()));
+  for (int i = matches.size() - 1; i >= 0; --i) {
+    Match match = best.top();
+    best.pop();
+    match.distance = std::sqrt(match.distance);
+    matches[i] = match;
+  }
+  return matches;
+}
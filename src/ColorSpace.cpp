@@ -0,0 +1,143 @@
+#include "../include/ColorSpace.h"
+#include "../include/ColorMath.h"
+#include <cmath>
+
+namespace {
+
+// D65 reference white
+constexpr float WHITE_X = 0.95047f;
+constexpr float WHITE_Y = 1.0f;
+constexpr float WHITE_Z = 1.08883f;
+
+float labF(float t) {
+  constexpr float delta = 6.0f / 29.0f;
+  if (t > delta * delta * delta) {
+    return std::cbrt(t);
+  }
+  return t / (3.0f * delta * delta) + 4.0f / 29.0f;
+}
+
+float labFInverse(float t) {
+  constexpr float delta = 6.0f / 29.0f;
+  if (t > delta) {
+    return t * t * t;
+  }
+  return 3.0f * delta * delta * (t - 4.0f / 29.0f);
+}
+
+} // namespace
+
+float ColorSpace::srgbToLinear(float c) {
+  if (c <= 0.04045f) {
+    return c / 12.92f;
+  }
+  return std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+float ColorSpace::linearToSrgb(float c) {
+  if (c <= 0.0031308f) {
+    return c * 12.92f;
+  }
+  return 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+ColorSpace::Lab ColorSpace::linearRgbToLab(float r, float g, float b) {
+  const float x = 0.4124564f * r + 0.3575761f * g + 0.1804375f * b;
+  const float y = 0.2126729f * r + 0.7151522f * g + 0.0721750f * b;
+  const float z = 0.0193339f * r + 0.1191920f * g + 0.9503041f * b;
+
+  const float fx = labF(x / WHITE_X);
+  const float fy = labF(y / WHITE_Y);
+  const float fz = labF(z / WHITE_Z);
+
+  return {116.0f * fy - 16.0f, 500.0f * (fx - fy), 200.0f * (fy - fz)};
+}
+
+ColorSpace::Rgb ColorSpace::labToLinearRgb(const Lab &lab) {
+  const float fy = (lab.L + 16.0f) / 116.0f;
+  const float fx = fy + lab.a / 500.0f;
+  const float fz = fy - lab.b / 200.0f;
+
+  const float x = WHITE_X * labFInverse(fx);
+  const float y = WHITE_Y * labFInverse(fy);
+  const float z = WHITE_Z * labFInverse(fz);
+
+  return {3.2404542f * x - 1.5371385f * y - 0.4985314f * z,
+          -0.9692660f * x + 1.8760108f * y + 0.0415560f * z,
+          0.0556434f * x - 0.2040259f * y + 1.0572252f * z};
+}
+
+ColorSpace::Lab ColorSpace::linearRgbToOklab(float r, float g, float b) {
+  const float l = 0.4122214708f * r + 0.5363325363f * g + 0.0514459929f * b;
+  const float m = 0.2119034982f * r + 0.6806995451f * g + 0.1073969566f * b;
+  const float s = 0.0883024619f * r + 0.2817188376f * g + 0.6299787005f * b;
+
+  const float l_ = std::cbrt(l);
+  const float m_ = std::cbrt(m);
+  const float s_ = std::cbrt(s);
+
+  return {0.2104542553f * l_ + 0.7936177850f * m_ - 0.0040720468f * s_,
+          1.9779984951f * l_ - 2.4285922050f * m_ + 0.4505937099f * s_,
+          0.0259040371f * l_ + 0.7827717662f * m_ - 0.8086757660f * s_};
+}
+
+ColorSpace::Rgb ColorSpace::oklabToLinearRgb(const Lab &lab) {
+  const float l_ = lab.L + 0.3963377774f * lab.a + 0.2158037573f * lab.b;
+  const float m_ = lab.L - 0.1055613458f * lab.a - 0.0638541728f * lab.b;
+  const float s_ = lab.L - 0.0894841775f * lab.a - 1.2914855480f * lab.b;
+
+  const float l = l_ * l_ * l_;
+  const float m = m_ * m_ * m_;
+  const float s = s_ * s_ * s_;
+
+  return {4.0767416621f * l - 3.3077115913f * m + 0.2309699292f * s,
+          -1.2684380046f * l + 2.6097574011f * m - 0.3413193965f * s,
+          -0.0041960863f * l - 0.7034186147f * m + 1.7076147010f * s};
+}
+
+void ColorSpace::oklabToLinearRgb(float L, const float *a, const float *b,
+                                  int count, float *red, float *green,
+                                  float *blue) {
+  int i = 0;
+
+#ifdef COLORSMITH_HAVE_SSE2
+  const __m128 Lv = _mm_set1_ps(L);
+  const auto mad = [](__m128 x, float k, __m128 y) {
+    return _mm_add_ps(x, _mm_mul_ps(_mm_set1_ps(k), y));
+  };
+  const auto cube = [](__m128 x) { return _mm_mul_ps(x, _mm_mul_ps(x, x)); };
+  for (; i + 4 <= count; i += 4) {
+    const __m128 av = _mm_loadu_ps(a + i);
+    const __m128 bv = _mm_loadu_ps(b + i);
+    const __m128 l = cube(mad(mad(Lv, 0.3963377774f, av), 0.2158037573f, bv));
+    const __m128 m = cube(mad(mad(Lv, -0.1055613458f, av), -0.0638541728f, bv));
+    const __m128 s = cube(mad(mad(Lv, -0.0894841775f, av), -1.2914855480f, bv));
+    const __m128 zero = _mm_setzero_ps();
+    _mm_storeu_ps(red + i, mad(mad(mad(zero, 4.0767416621f, l), -3.3077115913f, m),
+                               0.2309699292f, s));
+    _mm_storeu_ps(green + i, mad(mad(mad(zero, -1.2684380046f, l), 2.6097574011f, m),
+                                 -0.3413193965f, s));
+    _mm_storeu_ps(blue + i, mad(mad(mad(zero, -0.0041960863f, l), -0.7034186147f, m),
+                                1.7076147010f, s));
+  }
+#endif
+
+  for (; i < count; ++i) {
+    const Rgb rgb = oklabToLinearRgb({L, a[i], b[i]});
+    red[i] = rgb.r;
+    green[i] = rgb.g;
+    blue[i] = rgb.b;
+  }
+}
+
+ColorSpace::Lab ColorSpace::toLab(const QColor &color) {
+  float r, g, b;
+  color.getRgbF(&r, &g, &b);
+  return linearRgbToLab(srgbToLinear(r), srgbToLinear(g), srgbToLinear(b));
+}
+
+ColorSpace::Lab ColorSpace::toOklab(const QColor &color) {
+  float r, g, b;
+  color.getRgbF(&r, &g, &b);
+  return linearRgbToOklab(srgbToLinear(r), srgbToLinear(g), srgbToLinear(b));
+}
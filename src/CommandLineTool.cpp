@@ -0,0 +1,388 @@
+#include "../include/CommandLineTool.h"
+#include "../include/ColorLogic.h"
+#include "../include/PaletteExporter.h"
+#include "../include/PaletteManager.h"
+#include "../include/version.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QTextStream>
+#include <cstring>
+
+namespace {
+
+constexpr const char *COMMANDS[] = {"export", "convert", "search"};
+
+// Lines longer than this are not colors
+constexpr int MAX_LINE_LENGTH = 4096;
+// Output is written in blocks of about this size
+constexpr int OUTPUT_BUFFER_SIZE = 64 * 1024;
+// Converted colors remembered; inputs repeat a lot in practice
+constexpr int MEMO_ENTRIES = 64 * 1024;
+
+// Same as ColorLogic::colorToHex, without the QString round trip
+void appendHex(QByteArray *out, const QColor &color) {
+  static const char digits[] = "0123456789abcdef";
+  const int channels[] = {color.alpha(), color.red(), color.green(),
+                          color.blue()};
+  out->append('#');
+  for (int i = color.alpha() < 255 ? 0 : 1; i < 4; ++i) {
+    out->append(digits[channels[i] >> 4]);
+    out->append(digits[channels[i] & 0xf]);
+  }
+}
+
+QByteArrayView trimSpaces(QByteArrayView text) {
+  auto isSpace = [](char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+  };
+  qsizetype begin = 0;
+  qsizetype end = text.size();
+  while (begin < end && isSpace(text.at(begin)))
+    ++begin;
+  while (end > begin && isSpace(text.at(end - 1)))
+    --end;
+  return text.sliced(begin, end - begin);
+}
+
+// Skips the rest of a line that did not fit the buffer
+void skipLine(QFile *input, char *buffer, qint64 length) {
+  while (length > 0 && buffer[length - 1] != '\n') {
+    length = input->readLine(buffer, MAX_LINE_LENGTH);
+  }
+}
+
+} // namespace
+
+bool CommandLineTool::isCommand(int argc, char *argv[]) {
+  if (argc < 2)
+    return false;
+  for (const char *command : COMMANDS) {
+    if (std::strcmp(argv[1], command) == 0)
+      return true;
+  }
+  return false;
+}
+
+int CommandLineTool::run(int argc, char *argv[]) {
+  // No GUI application: commands must work without a display
+  QCoreApplication app(argc, argv);
+
+  QCoreApplication::setApplicationName(COLORSMITH_APP_NAME);
+  QCoreApplication::setOrganizationName(COLORSMITH_ORGANIZATION_NAME);
+  QCoreApplication::setOrganizationDomain(COLORSMITH_ORGANIZATION_DOMAIN);
+  QCoreApplication::setApplicationVersion(COLORSMITH_VERSION_STRING);
+
+  // Drop the command so the parser sees "colorsmith --option ..."
+  QStringList arguments = QCoreApplication::arguments();
+  const QString command = arguments.takeAt(1);
+
+  if (command == QLatin1String("export"))
+    return runExport(arguments);
+  if (command == QLatin1String("convert"))
+    return runConvert(arguments);
+  if (command == QLatin1String("search"))
+    return runSearch(arguments);
+  return 1;
+}
+
+int CommandLineTool::runExport(const QStringList &arguments) {
+  QStringList formatNames;
+  for (PaletteExporter::Format format : PaletteExporter::formats()) {
+    formatNames.append(PaletteExporter::formatName(format));
+  }
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(
+      QStringLiteral("Exports palettes from the library, one file each."));
+  parser.addHelpOption();
+
+  const QCommandLineOption formatOption(
+      {"f", "format"},
+      QStringLiteral("Output format: %1.").arg(formatNames.join(", ")),
+      "format", "gpl");
+  const QCommandLineOption outputOption(
+      {"o", "output"}, QStringLiteral("Directory to write the files to."),
+      "directory", ".");
+  const QCommandLineOption paletteOption(
+      {"p", "palette"},
+      QStringLiteral("Export only this palette (id or name); may be repeated."),
+      "palette");
+  parser.addOption(formatOption);
+  parser.addOption(outputOption);
+  parser.addOption(paletteOption);
+  parser.process(arguments);
+
+  QTextStream out(stdout);
+  QTextStream err(stderr);
+
+  PaletteExporter::Format format;
+  if (!PaletteExporter::formatFromName(parser.value(formatOption), &format)) {
+    err << "Unknown format: " << parser.value(formatOption) << "\n";
+    return 1;
+  }
+
+  const QDir directory(parser.value(outputOption));
+  if (!directory.mkpath(".")) {
+    err << "Cannot create " << directory.path() << "\n";
+    return 1;
+  }
+
+  // Read-only: a running GUI may own the library and journal
+  PaletteManager &manager = PaletteManager::instance();
+  manager.loadPalettes(PaletteManager::LoadMode::ReadOnly);
+  const PaletteLibrary::Snapshot snapshot = manager.captureSnapshot();
+
+  const QStringList wanted = parser.values(paletteOption);
+  const QString suffix = PaletteExporter::fileSuffix(format);
+  QSet<QString> usedNames;
+  int failed = 0;
+
+  for (const PaletteLibrary::PaletteData &palette : snapshot.palettes) {
+    if (!wanted.isEmpty() && !wanted.contains(palette.id) &&
+        !wanted.contains(palette.name))
+      continue;
+
+    // Palettes may share a name; number the later ones
+    const QString base = PaletteExporter::identifier(palette.name);
+    QString fileName = base;
+    for (int n = 2; usedNames.contains(fileName); ++n) {
+      fileName = QStringLiteral("%1-%2").arg(base).arg(n);
+    }
+    usedNames.insert(fileName);
+
+    const QString path = directory.filePath(fileName + '.' + suffix);
+    if (PaletteExporter::exportFile(path, palette.name, palette.colors, format)) {
+      out << path << "\n";
+    } else {
+      ++failed;
+    }
+  }
+
+  return failed > 0 ? 1 : 0;
+}
+
+int CommandLineTool::runConvert(const QStringList &arguments) {
+  const QStringList formatNames = ColorLogic::formatNames();
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(QStringLiteral(
+      "Converts colors read from standard input, one per line and in any "
+      "supported format, to standard output. Annotations follow the color, "
+      "separated by tabs."));
+  parser.addHelpOption();
+
+  const QCommandLineOption toOption(
+      {"t", "to"},
+      QStringLiteral("Output format: %1.").arg(formatNames.join(", ")),
+      "format", "hex");
+  const QCommandLineOption contrastOption(
+      {"c", "contrast"},
+      QStringLiteral("Annotate the WCAG contrast ratio against this color."),
+      "color");
+  const QCommandLineOption nameOption(
+      {"n", "name"},
+      QStringLiteral("Annotate the name of the nearest named color."));
+  parser.addOption(toOption);
+  parser.addOption(contrastOption);
+  parser.addOption(nameOption);
+  parser.process(arguments);
+
+  QTextStream err(stderr);
+
+  const QString format = parser.value(toOption);
+  if (!formatNames.contains(format)) {
+    err << "Unknown format: " << format << "\n";
+    return 1;
+  }
+
+  QColor background;
+  if (parser.isSet(contrastOption)) {
+    background = ColorLogic::stringToColor(parser.value(contrastOption));
+    if (!background.isValid()) {
+      err << "Not a color: " << parser.value(contrastOption) << "\n";
+      return 1;
+    }
+  }
+  const bool annotateName = parser.isSet(nameOption);
+  const bool hexOnly = format == QLatin1String("hex") &&
+                       !background.isValid() && !annotateName;
+
+  QFile input;
+  QFile output;
+  if (!input.open(stdin, QIODevice::ReadOnly) ||
+      !output.open(stdout, QIODevice::WriteOnly)) {
+    err << "Cannot open standard input or output\n";
+    return 1;
+  }
+
+  // Formatted color and annotations by the input color
+  QHash<quint64, QByteArray> memo;
+  QByteArray out;
+  out.reserve(OUTPUT_BUFFER_SIZE + MAX_LINE_LENGTH);
+  char line[MAX_LINE_LENGTH];
+  int lineNumber = 0;
+  int failed = 0;
+
+  // Streams line by line; only the output block is held in memory
+  for (qint64 length; (length = input.readLine(line, sizeof line)) > 0;) {
+    ++lineNumber;
+    if (line[length - 1] != '\n' && !input.atEnd()) {
+      skipLine(&input, line, length);
+      err << "Line " << lineNumber << ": too long\n";
+      ++failed;
+      out.append('\n');
+      continue;
+    }
+
+    const QByteArrayView text = trimSpaces(QByteArrayView(line, length));
+    if (text.isEmpty()) {
+      out.append('\n');
+      continue;
+    }
+
+    // HEX is parsed without building a QString. Only the forms hexToColor
+    // takes (3, 6 or 8 digits, '#' optional) use the fast path; the rest,
+    // such as 4-digit shorthand, get the same answer as in the GUI.
+    QColor color;
+    PackedColor packed;
+    const qsizetype digits = text.size() - (text.startsWith('#') ? 1 : 0);
+    if (digits != 4 && ColorLogic::hexToPacked(text, &packed)) {
+      color = ColorLogic::fromPacked(packed);
+    } else {
+      color = ColorLogic::stringToColor(QString::fromUtf8(text));
+    }
+
+    if (!color.isValid()) {
+      err << "Line " << lineNumber << ": not a color: "
+          << QString::fromUtf8(text) << "\n";
+      ++failed;
+    } else if (hexOnly) {
+      appendHex(&out, color);
+    } else {
+      const quint64 key = color.rgba64();
+      auto it = memo.constFind(key);
+      if (it == memo.constEnd()) {
+        QByteArray converted =
+            format == QLatin1String("hex")
+                ? QByteArray()
+                : ColorLogic::colorToString(color, format).toUtf8();
+        if (converted.isEmpty()) {
+          appendHex(&converted, color);
+        }
+        if (background.isValid()) {
+          converted += '\t' +
+                       QByteArray::number(
+                           ColorLogic::contrastRatio(color, background), 'f', 2) +
+                       ":1";
+        }
+        if (annotateName) {
+          converted += '\t' + ColorLogic::nearestColorName(color).toUtf8();
+        }
+
+        if (memo.size() >= MEMO_ENTRIES) {
+          memo.clear();
+        }
+        it = memo.insert(key, converted);
+      }
+      out.append(*it);
+    }
+    out.append('\n');
+
+    if (out.size() >= OUTPUT_BUFFER_SIZE) {
+      output.write(out);
+      out.resize(0);
+    }
+  }
+
+  output.write(out);
+  output.flush();
+  return failed > 0 ? 1 : 0;
+}
+
+int CommandLineTool::runSearch(const QStringList &arguments) {
+  QCommandLineParser parser;
+  parser.setApplicationDescription(QStringLiteral(
+      "Finds the palette colors closest to each color given, nearest first. "
+      "Each match is printed as the color searched for, the match, its "
+      "OKLab Delta E, the palette and the index in it, separated by tabs."));
+  parser.addHelpOption();
+  parser.addPositionalArgument("colors", QStringLiteral("Colors to search for."),
+                               "color...");
+
+  const QCommandLineOption countOption(
+      {"n", "count"}, QStringLiteral("Number of matches per color."), "count",
+      "10");
+  const QCommandLineOption radiusOption(
+      {"r", "radius"},
+      QStringLiteral("List every match within this Delta E instead."),
+      "radius");
+  parser.addOption(countOption);
+  parser.addOption(radiusOption);
+  parser.process(arguments);
+
+  QTextStream out(stdout);
+  QTextStream err(stderr);
+
+  bool ok = false;
+  const int count = parser.value(countOption).toInt(&ok);
+  if (!ok || count <= 0) {
+    err << "Not a count: " << parser.value(countOption) << "\n";
+    return 1;
+  }
+  float radius = -1.0f;
+  if (parser.isSet(radiusOption)) {
+    radius = parser.value(radiusOption).toFloat(&ok);
+    if (!ok || radius < 0.0f) {
+      err << "Not a radius: " << parser.value(radiusOption) << "\n";
+      return 1;
+    }
+  }
+
+  const QStringList queries = parser.positionalArguments();
+  if (queries.isEmpty()) {
+    parser.showHelp(1);
+  }
+
+  // Read-only, as for export; the standard colors are searched as well
+  PaletteManager &manager = PaletteManager::instance();
+  manager.loadPalettes(PaletteManager::LoadMode::ReadOnly);
+  manager.loadDeferredPalettes();
+
+  // Colors of the palettes matched so far, copied out of the library once
+  QHash<PaletteHandle, QVector<PackedColor>> colorsByPalette;
+  int failed = 0;
+
+  for (const QString &query : queries) {
+    const QColor color = ColorLogic::stringToColor(query);
+    if (!color.isValid()) {
+      err << "Not a color: " << query << "\n";
+      ++failed;
+      continue;
+    }
+
+    const QVector<ColorSearchIndex::Match> matches =
+        radius >= 0.0f ? manager.findSimilarColors(color, radius)
+                       : manager.findNearestColors(color, count);
+
+    for (const ColorSearchIndex::Match &match : matches) {
+      const Palette *palette = manager.getPalette(match.palette);
+      if (!palette)
+        continue;
+      auto it = colorsByPalette.constFind(match.palette);
+      if (it == colorsByPalette.constEnd()) {
+        it = colorsByPalette.insert(match.palette, manager.paletteColors(palette));
+      }
+
+      out << query << '\t'
+          << ColorLogic::colorToHex(ColorLogic::fromPacked(it->at(match.index)))
+          << '\t' << QString::number(match.distance, 'f', 2) << '\t'
+          << palette->name() << '\t' << match.index << '\n';
+    }
+  }
+
+  return failed > 0 ? 1 : 0;
+}
@@ -1,4 +1,5 @@
 #include "../include/ContrastChecker.h"
+#include "../include/ColorLogic.h"
 #include "../include/HSLGradientSlider.h"
 #include "../include/ScreenPicker.h"
 #include <QHBoxLayout>
@@ -447,34 +448,11 @@ void ContrastChecker::updateBackgroundHslSliders() {
 }
 
 double ContrastChecker::calculateRelativeLuminance(const QColor &color) {
-  // Convert RGB to sRGB
-  double r = color.redF();
-  double g = color.greenF();
-  double b = color.blueF();
-
-  // Apply gamma correction
-  auto toLinear = [](double val) {
-    return (val <= 0.03928) ? val / 12.92 : qPow((val + 0.055) / 1.055, 2.4);
-  };
-
-  r = toLinear(r);
-  g = toLinear(g);
-  b = toLinear(b);
-
-  // Calculate relative luminance
-  return 0.2126 * r + 0.7152 * g + 0.0722 * b;
+  return ColorLogic::relativeLuminance(color);
 }
 
 double ContrastChecker::calculateContrastRatio(const QColor &foreground, const QColor &background) {
-  double l1 = calculateRelativeLuminance(foreground);
-  double l2 = calculateRelativeLuminance(background);
-
-  // Ensure l1 is the lighter color
-  if (l1 < l2) {
-    qSwap(l1, l2);
-  }
-
-  return (l1 + 0.05) / (l2 + 0.05);
+  return ColorLogic::contrastRatio(foreground, background);
 }
 
 void ContrastChecker::updateContrastRatio() {
@@ -1,4 +1,5 @@
 #include "../include/GradientMaker.h"
+#include "../include/Checkerboard.h"
 #include "../include/ScreenPicker.h"
 #include <QApplication>
 #include <QClipboard>
@@ -61,15 +62,7 @@ void GradientSlider::paintEvent(QPaintEvent *event) {
   QRect trackRect(margin, trackY, width() - 2 * margin, trackHeight);
 
   // Draw checkered background for transparency
-  painter.fillRect(trackRect, Qt::white);
-  int checkerSize = 5;
-  for (int y = trackRect.top(); y < trackRect.bottom(); y += checkerSize) {
-    for (int x = trackRect.left(); x < trackRect.right(); x += checkerSize) {
-      if ((x / checkerSize + y / checkerSize) % 2 == 0) {
-        painter.fillRect(x, y, checkerSize, checkerSize, QColor(204, 204, 204));
-      }
-    }
-  }
+  Checkerboard::paint(&painter, trackRect, 5);
 
   // Create gradient for track
   QLinearGradient gradient(trackRect.left(), 0, trackRect.right(), 0);
@@ -0,0 +1,126 @@
+#include "../include/GradientStrip.h"
+#include <QCache>
+#include <QCoreApplication>
+#include <QImage>
+#include <QVector>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Enough for every slider of a few windows at several sizes
+constexpr int CACHE_BUDGET_KIB = 4 * 1024;
+
+struct StripKey {
+  GradientStrip::Type type;
+  quint32 dependency;
+  Qt::Orientation orientation;
+  QSize size;
+  int dprPercent;
+};
+
+bool operator==(const StripKey &a, const StripKey &b) {
+  return a.type == b.type && a.dependency == b.dependency &&
+         a.orientation == b.orientation && a.size == b.size &&
+         a.dprPercent == b.dprPercent;
+}
+
+size_t qHash(const StripKey &key, size_t seed = 0) {
+  return qHashMulti(seed, int(key.type), key.dependency, int(key.orientation),
+                    key.size.width(), key.size.height(), key.dprPercent);
+}
+
+// Only used from the GUI thread. Pixmaps must not outlive the application,
+// so the cache is emptied on shutdown.
+QCache<StripKey, QPixmap> &stripCache() {
+  static QCache<StripKey, QPixmap> cache = [] {
+    qAddPostRoutine([] { stripCache().clear(); });
+    return QCache<StripKey, QPixmap>(CACHE_BUDGET_KIB);
+  }();
+  return cache;
+}
+
+// Hue of -1 (achromatic) packs as 0
+quint32 pack(int hue, int component) {
+  return (quint32(hue + 1) << 8) | quint32(component);
+}
+
+QRgb stripColor(GradientStrip::Type type, const QColor &color, float t) {
+  const int level = qRound(255.0f * t);
+  int h, s, l;
+  switch (type) {
+  case GradientStrip::Hue:
+    return QColor::fromHsv(qRound(359.0f * t), 255, 255).rgb();
+  case GradientStrip::Saturation:
+    color.getHsl(&h, &s, &l);
+    return QColor::fromHsl(h, level, l).rgb();
+  case GradientStrip::Lightness:
+    color.getHsl(&h, &s, &l);
+    return QColor::fromHsl(h, s, level).rgb();
+  case GradientStrip::Value:
+    color.getHsv(&h, &s, &l);
+    return QColor::fromHsv(h, s, 255 - level).rgb();
+  }
+  return 0;
+}
+
+} // namespace
+
+quint32 GradientStrip::dependencyKey(Type type, const QColor &color) {
+  int h, s, l;
+  switch (type) {
+  case Hue:
+    return 0;
+  case Saturation:
+    color.getHsl(&h, &s, &l);
+    return pack(h, l);
+  case Lightness:
+    color.getHsl(&h, &s, &l);
+    return pack(h, s);
+  case Value:
+    color.getHsv(&h, &s, &l);
+    return pack(h, s);
+  }
+  return 0;
+}
+
+QPixmap GradientStrip::pixmap(Type type, const QColor &color,
+                              const QSize &size, Qt::Orientation orientation,
+                              qreal devicePixelRatio) {
+  QCache<StripKey, QPixmap> &cache = stripCache();
+
+  const StripKey key{type, dependencyKey(type, color), orientation, size,
+                     qRound(devicePixelRatio * 100)};
+  if (const QPixmap *cached = cache.object(key))
+    return *cached;
+
+  const QSize deviceSize(qRound(size.width() * devicePixelRatio),
+                         qRound(size.height() * devicePixelRatio));
+  if (deviceSize.isEmpty())
+    return QPixmap();
+
+  // One color per device pixel along the axis
+  const bool horizontal = orientation == Qt::Horizontal;
+  const int length = horizontal ? deviceSize.width() : deviceSize.height();
+  QVector<QRgb> ramp(length);
+  for (int i = 0; i < length; ++i) {
+    const float t = length > 1 ? float(i) / (length - 1) : 0.0f;
+    ramp[i] = stripColor(type, color, t);
+  }
+
+  QImage image(deviceSize, QImage::Format_RGB32);
+  for (int y = 0; y < deviceSize.height(); ++y) {
+    QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+    if (horizontal) {
+      std::memcpy(line, ramp.constData(), length * sizeof(QRgb));
+    } else {
+      std::fill(line, line + deviceSize.width(), ramp[y]);
+    }
+  }
+  image.setDevicePixelRatio(devicePixelRatio);
+
+  QPixmap strip = QPixmap::fromImage(image);
+  const int cost = qMax(1, deviceSize.width() * deviceSize.height() / 256);
+  cache.insert(key, new QPixmap(strip), cost);
+  return strip;
+}
@@ -1,7 +1,8 @@
 #include "../include/HSLGradientSlider.h"
+#include "../include/Profiler.h"
+#include <QEvent>
 #include <QPainter>
 #include <QStyleOptionSlider>
-#include <QLinearGradient>
 
 HSLGradientSlider::HSLGradientSlider(Qt::Orientation orientation, GradientType type, QWidget *parent)
     : QSlider(orientation, parent), m_gradientType(type), m_baseColor(Qt::red) {
@@ -9,16 +10,49 @@ HSLGradientSlider::HSLGradientSlider(Qt::Orientation orientation, GradientType t
 }
 
 void HSLGradientSlider::setGradientType(GradientType type) {
+    if (m_gradientType == type)
+        return;
     m_gradientType = type;
+    m_track = QPixmap();
     update();
 }
 
 void HSLGradientSlider::setBaseColor(const QColor &color) {
+    if (m_baseColor == color)
+        return;
+
+    // Only components the track shows matter; the hue track shows none
+    const GradientStrip::Type type = stripType();
+    const bool trackChanged = GradientStrip::dependencyKey(type, color) !=
+                              GradientStrip::dependencyKey(type, m_baseColor);
     m_baseColor = color;
-    update();
+    if (trackChanged) {
+        m_track = QPixmap();
+        update();
+    }
+}
+
+GradientStrip::Type HSLGradientSlider::stripType() const {
+    switch (m_gradientType) {
+        case Hue:
+            return GradientStrip::Hue;
+        case Saturation:
+            return GradientStrip::Saturation;
+        case Lightness:
+            return GradientStrip::Lightness;
+    }
+    return GradientStrip::Hue;
+}
+
+void HSLGradientSlider::changeEvent(QEvent *event) {
+    // The border is drawn in the palette's dark color
+    if (event->type() == QEvent::PaletteChange || event->type() == QEvent::StyleChange)
+        m_track = QPixmap();
+    QSlider::changeEvent(event);
 }
 
 void HSLGradientSlider::paintEvent(QPaintEvent *event) {
+    const Profiler::Scope scope("HSLGradientSlider::paintEvent");
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing);
 
@@ -30,29 +64,15 @@ void HSLGradientSlider::paintEvent(QPaintEvent *event) {
     // Adjust groove rect for better appearance
     grooveRect.adjust(2, 5, -2, -5);
 
-    // Draw gradient background
-    QLinearGradient gradient;
-    switch (m_gradientType) {
-        case Hue:
-            gradient = createHueGradient(grooveRect);
-            break;
-        case Saturation:
-            gradient = createSaturationGradient(grooveRect);
-            break;
-        case Lightness:
-            gradient = createLightnessGradient(grooveRect);
-            break;
+    // Re-render the track only when its size or pixel ratio changed, or it
+    // was invalidated
+    const qreal dpr = devicePixelRatioF();
+    if (m_track.isNull() || m_trackSize != grooveRect.size() ||
+        m_track.devicePixelRatio() != dpr) {
+        m_track = renderTrack(grooveRect.size(), dpr);
+        m_trackSize = grooveRect.size();
     }
-
-    // Draw the gradient
-    painter.setPen(Qt::NoPen);
-    painter.setBrush(gradient);
-    painter.drawRoundedRect(grooveRect, 3, 3);
-
-    // Draw border
-    painter.setPen(QPen(palette().dark().color(), 1));
-    painter.setBrush(Qt::NoBrush);
-    painter.drawRoundedRect(grooveRect, 3, 3);
+    painter.drawPixmap(grooveRect.topLeft() - QPoint(1, 1), m_track);
 
     // Draw the handle
     QRect handleRect = style()->subControlRect(QStyle::CC_Slider, &opt, QStyle::SC_SliderHandle, this);
@@ -78,64 +98,28 @@ void HSLGradientSlider::paintEvent(QPaintEvent *event) {
     }
 }
 
-QLinearGradient HSLGradientSlider::createHueGradient(const QRect &rect) const {
-    QLinearGradient gradient;
+QPixmap HSLGradientSlider::renderTrack(const QSize &size, qreal devicePixelRatio) const {
+    const QSize padded = size + QSize(2, 2);
+    QPixmap track(qRound(padded.width() * devicePixelRatio),
+                  qRound(padded.height() * devicePixelRatio));
+    track.setDevicePixelRatio(devicePixelRatio);
+    track.fill(Qt::transparent);
 
-    if (orientation() == Qt::Horizontal) {
-        gradient = QLinearGradient(rect.left(), 0, rect.right(), 0);
-    } else {
-        gradient = QLinearGradient(0, rect.top(), 0, rect.bottom());
-    }
-
-    // Add color stops for full hue spectrum
-    gradient.setColorAt(0.0, QColor::fromHsv(0, 255, 255));     // Red
-    gradient.setColorAt(0.17, QColor::fromHsv(60, 255, 255));   // Yellow
-    gradient.setColorAt(0.33, QColor::fromHsv(120, 255, 255));  // Green
-    gradient.setColorAt(0.5, QColor::fromHsv(180, 255, 255));   // Cyan
-    gradient.setColorAt(0.67, QColor::fromHsv(240, 255, 255));  // Blue
-    gradient.setColorAt(0.83, QColor::fromHsv(300, 255, 255));  // Magenta
-    gradient.setColorAt(1.0, QColor::fromHsv(359, 255, 255));   // Red
-
-    return gradient;
-}
-
-QLinearGradient HSLGradientSlider::createSaturationGradient(const QRect &rect) const {
-    QLinearGradient gradient;
-
-    if (orientation() == Qt::Horizontal) {
-        gradient = QLinearGradient(rect.left(), 0, rect.right(), 0);
-    } else {
-        gradient = QLinearGradient(0, rect.top(), 0, rect.bottom());
-    }
-
-    // Get current hue and lightness from base color
-    int h, s, l;
-    m_baseColor.getHsl(&h, &s, &l);
-
-    // From gray (no saturation) to full color (full saturation)
-    gradient.setColorAt(0.0, QColor::fromHsl(h, 0, l));
-    gradient.setColorAt(1.0, QColor::fromHsl(h, 255, l));
-
-    return gradient;
-}
-
-QLinearGradient HSLGradientSlider::createLightnessGradient(const QRect &rect) const {
-    QLinearGradient gradient;
-
-    if (orientation() == Qt::Horizontal) {
-        gradient = QLinearGradient(rect.left(), 0, rect.right(), 0);
-    } else {
-        gradient = QLinearGradient(0, rect.top(), 0, rect.bottom());
-    }
+    QPainter painter(&track);
+    painter.setRenderHint(QPainter::Antialiasing);
+    const QRect rect(QPoint(1, 1), size);
 
-    // Get current hue and saturation from base color
-    int h, s, l;
-    m_baseColor.getHsl(&h, &s, &l);
+    // Draw the shared strip clipped to the rounded groove
+    painter.setPen(Qt::NoPen);
+    painter.setBrushOrigin(rect.topLeft());
+    painter.setBrush(GradientStrip::pixmap(stripType(), m_baseColor, size,
+                                           orientation(), devicePixelRatio));
+    painter.drawRoundedRect(rect, 3, 3);
 
-    // From black (0% lightness) to white (100% lightness)
-    gradient.setColorAt(0.0, QColor::fromHsl(h, s, 0));    // Black
-    gradient.setColorAt(0.5, QColor::fromHsl(h, s, 127));  // Mid tone
-    gradient.setColorAt(1.0, QColor::fromHsl(h, s, 255));  // White
+    // Draw border
+    painter.setPen(QPen(palette().dark().color(), 1));
+    painter.setBrush(Qt::NoBrush);
+    painter.drawRoundedRect(rect, 3, 3);
 
-    return gradient;
+    return track;
 }
@@ -8,6 +8,7 @@
 #include "../include/Palette.h"
 #include "../include/PaletteManager.h"
 #include "../include/PaletteWidget.h"
+#include "../include/Profiler.h"
 #include "../include/ScreenPicker.h"
 #include "../include/Settings.h"
 #include "../include/ShortcutsDialog.h"
@@ -16,17 +17,28 @@
 
 #include <QClipboard>
 #include <QKeyEvent>
-#include <QScrollArea>
-#include <QScrollBar>
+#include <QMetaEnum>
+#include <QScreen>
 #include <QSpinBox>
 #include <QSplitter>
 #include <QStatusBar>
 #include <QTimer>
+#include <QWindow>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), ui(new Ui::MainWindow),
-      m_screenPicker(new ScreenPicker(this)), m_programmaticChange(false) {
-  ui->setupUi(this);
+      m_screenPicker(new ScreenPicker(this)), m_programmaticChange(false),
+      m_firstFrameWatched(false), m_pendingUpdates(0),
+      m_updateTimer(new QTimer(this)) {
+  {
+    const Profiler::Scope scope("MainWindow::setupUi");
+    ui->setupUi(this);
+  }
+
+  m_updateTimer->setSingleShot(true);
+  m_updateTimer->setTimerType(Qt::PreciseTimer);
+  connect(m_updateTimer, &QTimer::timeout, this,
+          &MainWindow::flushColorUpdates);
 
   // Setup implicit data for comboBox
   ui->comboOutput->setItemData(0, "hex");
@@ -127,7 +139,8 @@ MainWindow::MainWindow(QWidget *parent)
   connect(m_paletteWidget, &PaletteWidget::addColorRequested, this,
           &MainWindow::onAddToPaletteClicked);
 
-  // Load palettes and set current
+  // Load palettes and set current; palettes the first frame does not show
+  // are filled by loadDeferred
   PaletteManager::instance().loadPalettes();
   m_paletteWidget->setPalette(PaletteManager::instance().currentPalette());
 
@@ -147,41 +160,20 @@ MainWindow::~MainWindow() { delete ui; }
 
 void MainWindow::updateColor(const QColor &color, bool updateOutputField,
                              bool skipBrightnessReset, bool addToRecent) {
+  const Profiler::Scope scope("MainWindow::updateColor");
   if (!color.isValid())
     return;
 
-  m_programmaticChange = true;
+  // State changes at once; the widgets follow on the next frame, so a drag
+  // delivering several mouse events per frame updates them only once
   m_currentColor = color;
 
-  // Update color preview widget
-  m_colorPreview->setColor(color);
-
-  // Update color picker widget
-  m_colorPlane->blockSignals(true);
-  m_colorPlane->setColor(color);
-  m_colorPlane->blockSignals(false);
-
-  // Update inputs including alpha
-  QSpinBox *spins[] = {ui->spinR, ui->spinG, ui->spinB, ui->spinA};
-  QSlider *sliders[] = {ui->sliderR, ui->sliderG, ui->sliderB, ui->sliderA};
-  const int values[] = {color.red(), color.green(), color.blue(),
-                        color.alpha()};
-
-  for (int i = 0; i < 4; i++) {
-    spins[i]->blockSignals(true);
-    sliders[i]->blockSignals(true);
-    spins[i]->setValue(values[i]);
-    sliders[i]->setValue(values[i]);
-    spins[i]->blockSignals(false);
-    sliders[i]->blockSignals(false);
-  }
+  unsigned updates = PendingPreview | PendingPlane | PendingChannels;
 
   // Only reset brightness slider if not skipped
   if (!skipBrightnessReset) {
-    m_brightnessSlider->setColor(color);
     m_baseColorForBrightness = color;
-    // Update the "last color" preview to show the original color
-    m_lastColorPreview->setColor(color);
+    updates |= PendingBrightness;
   }
 
   // Add color to recently picked colors (only when explicitly requested)
@@ -190,31 +182,86 @@ void MainWindow::updateColor(const QColor &color, bool updateOutputField,
   }
 
   if (updateOutputField) {
+    updates |= PendingOutput;
+  }
+
+  scheduleColorUpdate(updates);
+}
+
+void MainWindow::scheduleColorUpdate(unsigned updates) {
+  m_pendingUpdates |= updates;
+  if (m_updateTimer->isActive())
+    return;
+
+  // The first change after a pause goes out on the next event loop pass;
+  // later ones wait for the rest of the frame
+  const qreal refreshRate = screen() ? screen()->refreshRate() : 0.0;
+  const qint64 frame =
+      qRound64(1000.0 / (refreshRate > 0.0 ? refreshRate : 60.0));
+  const qint64 elapsed =
+      m_sinceFlush.isValid() ? m_sinceFlush.elapsed() : frame;
+  m_updateTimer->start(int(qBound<qint64>(0, frame - elapsed, frame)));
+}
+
+void MainWindow::flushColorUpdates() {
+  const Profiler::Scope scope("MainWindow::flushColorUpdates");
+  m_updateTimer->stop();
+  const unsigned updates = m_pendingUpdates;
+  m_pendingUpdates = 0;
+  if (updates == 0)
+    return;
+
+  m_programmaticChange = true;
+  const QColor &color = m_currentColor;
+
+  // Update color preview widget
+  if (updates & PendingPreview) {
+    m_colorPreview->setColor(color);
+  }
+
+  // Update color picker widget
+  if (updates & PendingPlane) {
+    m_colorPlane->blockSignals(true);
+    m_colorPlane->setColor(color);
+    m_colorPlane->blockSignals(false);
+  }
+
+  // Update inputs including alpha
+  if (updates & PendingChannels) {
+    QSpinBox *spins[] = {ui->spinR, ui->spinG, ui->spinB, ui->spinA};
+    QSlider *sliders[] = {ui->sliderR, ui->sliderG, ui->sliderB, ui->sliderA};
+    const int values[] = {color.red(), color.green(), color.blue(),
+                          color.alpha()};
+
+    for (int i = 0; i < 4; i++) {
+      spins[i]->blockSignals(true);
+      sliders[i]->blockSignals(true);
+      spins[i]->setValue(values[i]);
+      sliders[i]->setValue(values[i]);
+      spins[i]->blockSignals(false);
+      sliders[i]->blockSignals(false);
+    }
+  }
+
+  if (updates & PendingBrightness) {
+    m_brightnessSlider->setColor(m_baseColorForBrightness);
+    // Update the "last color" preview to show the original color
+    m_lastColorPreview->setColor(m_baseColorForBrightness);
+  }
+
+  if (updates & PendingOutput) {
     ui->outputEdit->blockSignals(true);
     updateOutput();
     ui->outputEdit->blockSignals(false);
   }
 
   m_programmaticChange = false;
+  m_sinceFlush.start();
 }
 
 void MainWindow::updateOutput() const {
-  if (const QString mode = ui->comboOutput->currentData().toString();
-      mode == "hex") {
-    ui->outputEdit->setText(ColorLogic::colorToHex(m_currentColor));
-  } else if (mode == "rgb") {
-    ui->outputEdit->setText(ColorLogic::colorToRgbString(m_currentColor));
-  } else if (mode == "rgba") {
-    ui->outputEdit->setText(ColorLogic::colorToRgbaString(m_currentColor));
-  } else if (mode == "hsl") {
-    ui->outputEdit->setText(ColorLogic::colorToHslString(m_currentColor));
-  } else if (mode == "hsla") {
-    ui->outputEdit->setText(ColorLogic::colorToHslaString(m_currentColor));
-  } else if (mode == "hsv") {
-    ui->outputEdit->setText(ColorLogic::colorToHsvString(m_currentColor));
-  } else if (mode == "cmyk") {
-    ui->outputEdit->setText(ColorLogic::colorToCmykString(m_currentColor));
-  }
+  const QString mode = ui->comboOutput->currentData().toString();
+  ui->outputEdit->setText(ColorLogic::colorToString(m_currentColor, mode));
 }
 
 void MainWindow::onRgbInputChanged() {
@@ -234,25 +281,26 @@ void MainWindow::onRgbInputChanged() {
     return s->value();
   };
 
+  // The other inputs may not show the current color yet
   if (senderObj == ui->spinR || senderObj == ui->sliderR)
     r = getValue(ui->spinR, ui->sliderR);
   else
-    r = ui->spinR->value();
+    r = m_currentColor.red();
 
   if (senderObj == ui->spinG || senderObj == ui->sliderG)
     g = getValue(ui->spinG, ui->sliderG);
   else
-    g = ui->spinG->value();
+    g = m_currentColor.green();
 
   if (senderObj == ui->spinB || senderObj == ui->sliderB)
     b = getValue(ui->spinB, ui->sliderB);
   else
-    b = ui->spinB->value();
+    b = m_currentColor.blue();
 
   if (senderObj == ui->spinA || senderObj == ui->sliderA)
     a = getValue(ui->spinA, ui->sliderA);
   else
-    a = ui->spinA->value();
+    a = m_currentColor.alpha();
 
   // RGB slider adjustments don't add to recent colors
   updateColor(QColor(r, g, b, a), true, false, false);
@@ -274,63 +322,9 @@ void MainWindow::onOutputTextChanged() {
   if (text.isEmpty())
     return;
 
-  QColor newColor;
+  // Detect the format and parse the color
   QString detectedFormat;
-
-  // Try to detect the format and parse the color
-  // Try HEX format (most common for pasting)
-  newColor = ColorLogic::hexToColor(text);
-  if (newColor.isValid()) {
-    detectedFormat = "hex";
-  }
-
-  // Try RGB format
-  if (!newColor.isValid()) {
-    newColor = ColorLogic::rgbStringToColor(text);
-    if (newColor.isValid()) {
-      detectedFormat = "rgb";
-    }
-  }
-
-  // Try RGBA format
-  if (!newColor.isValid()) {
-    newColor = ColorLogic::rgbaStringToColor(text);
-    if (newColor.isValid()) {
-      detectedFormat = "rgba";
-    }
-  }
-
-  // Try HSL format
-  if (!newColor.isValid()) {
-    newColor = ColorLogic::hslStringToColor(text);
-    if (newColor.isValid()) {
-      detectedFormat = "hsl";
-    }
-  }
-
-  // Try HSLA format
-  if (!newColor.isValid()) {
-    newColor = ColorLogic::hslaStringToColor(text);
-    if (newColor.isValid()) {
-      detectedFormat = "hsla";
-    }
-  }
-
-  // Try HSV format
-  if (!newColor.isValid()) {
-    newColor = ColorLogic::hsvStringToColor(text);
-    if (newColor.isValid()) {
-      detectedFormat = "hsv";
-    }
-  }
-
-  // Try CMYK format
-  if (!newColor.isValid()) {
-    newColor = ColorLogic::cmykStringToColor(text);
-    if (newColor.isValid()) {
-      detectedFormat = "cmyk";
-    }
-  }
+  const QColor newColor = ColorLogic::stringToColor(text, &detectedFormat);
 
   if (newColor.isValid() && !detectedFormat.isEmpty()) {
     // Switch combo box to the detected format
@@ -354,7 +348,10 @@ void MainWindow::onOutputTextChanged() {
   }
 }
 
-void MainWindow::onCopyClicked() const {
+void MainWindow::onCopyClicked() {
+  // The output field may still show the previous color
+  flushColorUpdates();
+
   QClipboard *clipboard = QApplication::clipboard();
   clipboard->setText(ui->outputEdit->text());
   statusBar()->showMessage(tr("%1 copied!").arg(ui->outputEdit->text()), 2000);
@@ -375,41 +372,10 @@ void MainWindow::onBrightnessColorChanged(const QColor &color) {
 }
 
 void MainWindow::onResetBrightness() {
-  // Restore the base color if it exists
+  // Restore the base color if it exists. Since we're restoring, not picking
+  // a new color, it is not added to the recent colors
   if (m_baseColorForBrightness.isValid()) {
-    // Temporarily set programmatic change to prevent any side effects
-    m_programmaticChange = true;
-
-    // Update brightness slider widget with base color
-    m_brightnessSlider->setColor(m_baseColorForBrightness);
-
-    // Restore the base color without adding to recent colors (skip brightness
-    // reset) Since we're restoring, not picking a new color, we skip the recent
-    // colors update
-    m_currentColor = m_baseColorForBrightness;
-
-    // Update color preview widget
-    m_colorPreview->setColor(m_baseColorForBrightness);
-
-    // Update color picker widget
-    m_colorPlane->blockSignals(true);
-    m_colorPlane->setColor(m_baseColorForBrightness);
-    m_colorPlane->blockSignals(false);
-
-    // Update RGB sliders
-    ui->spinR->setValue(m_baseColorForBrightness.red());
-    ui->sliderR->setValue(m_baseColorForBrightness.red());
-    ui->spinG->setValue(m_baseColorForBrightness.green());
-    ui->sliderG->setValue(m_baseColorForBrightness.green());
-    ui->spinB->setValue(m_baseColorForBrightness.blue());
-    ui->sliderB->setValue(m_baseColorForBrightness.blue());
-    ui->spinA->setValue(m_baseColorForBrightness.alpha());
-    ui->sliderA->setValue(m_baseColorForBrightness.alpha());
-
-    // Update output
-    updateOutput();
-
-    m_programmaticChange = false;
+    updateColor(m_baseColorForBrightness, true, false, false);
   }
 }
 
@@ -469,56 +435,31 @@ void MainWindow::onAddToPaletteClicked() const {
   if (Palette *currentPalette = PaletteManager::instance().currentPalette()) {
     // Check if palette is read-only (except for "Recent" palette)
     if (currentPalette->isReadOnly() &&
-        currentPalette->id() != PaletteManager::RECENTLY_PICKED_PALETTE_ID) {
+        currentPalette != PaletteManager::instance().recentPalette()) {
       statusBar()->showMessage(tr("Cannot add colors to read-only palettes"),
                                2000);
       return;
     }
 
     // Special handling for Recently Picked palette
-    if (currentPalette->id() == PaletteManager::RECENTLY_PICKED_PALETTE_ID) {
+    if (currentPalette == PaletteManager::instance().recentPalette()) {
       // Use the proper method that handles FIFO and prepending
       PaletteManager::instance().addToRecentColors(m_currentColor);
-      m_paletteWidget->refreshColors();
 
       // Scroll to top to see the newly added color (it's prepended)
-      QTimer::singleShot(50, [this]() {
-        if (const QScrollArea *scrollArea =
-                m_paletteWidget->findChild<QScrollArea *>()) {
-          if (QScrollBar *vScrollBar = scrollArea->verticalScrollBar()) {
-            vScrollBar->setValue(0); // Scroll to top
-          }
-        }
-      });
+      m_paletteWidget->scrollToColor(0);
 
       statusBar()->showMessage(tr("Color added to recent colors"), 2000);
       return;
     }
 
     // For regular palettes, check if color already exists
-    bool exists = false;
-    for (const QColor &existingColor : currentPalette->colors()) {
-      if (existingColor == m_currentColor) {
-        exists = true;
-        break;
-      }
-    }
-
-    if (!exists) {
-      currentPalette->addColor(m_currentColor);
-      m_paletteWidget->refreshColors();
+    if (!currentPalette->containsColor(m_currentColor)) {
+      PaletteManager::instance().addColor(currentPalette, m_currentColor);
 
       // Scroll to the newly added color (appended to bottom)
-      QTimer::singleShot(50, [this]() {
-        if (const QScrollArea *scrollArea =
-                m_paletteWidget->findChild<QScrollArea *>()) {
-          if (QScrollBar *vScrollBar = scrollArea->verticalScrollBar()) {
-            vScrollBar->setValue(vScrollBar->maximum());
-          }
-        }
-      });
+      m_paletteWidget->scrollToColor(currentPalette->colorCount() - 1);
 
-      PaletteManager::instance().savePalettes();
       statusBar()->showMessage(tr("Color added to palette"), 2000);
     } else {
       statusBar()->showMessage(tr("Color already in palette"), 2000);
@@ -527,6 +468,7 @@ void MainWindow::onAddToPaletteClicked() const {
 }
 
 void MainWindow::loadSettings() {
+  const Profiler::Scope scope("MainWindow::loadSettings");
   const Settings::Manager &settings = Settings::Manager::instance();
 
   // Restore window geometry and state
@@ -541,14 +483,29 @@ void MainWindow::loadSettings() {
     restoreState(state);
   }
 
+  m_colorPlane->setCacheBudget(
+      settings.getPlaneCacheBudget(QtHsvRectPicker::DEFAULT_CACHE_BUDGET));
+
+  // Restore plane mode; unknown names keep the default
+  const QMetaEnum planeModes = QMetaEnum::fromType<QtHsvRectPicker::PlaneMode>();
+  bool planeModeOk = false;
+  const int planeMode =
+      planeModes.keyToValue(settings.getPlaneMode().toLatin1(), &planeModeOk);
+  if (planeModeOk) {
+    m_colorPlane->setPlaneMode(QtHsvRectPicker::PlaneMode(planeMode));
+  }
+
   // Restore last color
   if (const QString lastColor = settings.getLastColor(); !lastColor.isEmpty()) {
     // Restoring saved color should not add to recent
-    updateColor(ColorLogic::hexToColor(lastColor), true, false, false);
+    updateColor(ColorLogic::storageStringToColor(lastColor), true, false,
+                false);
   } else {
     // Initial random color should not add to recent
     updateColor(ColorLogic::randomColor(), true, false, false);
   }
+  // Show it in the first frame rather than the one after
+  flushColorUpdates();
 
   // Restore output mode (combobox selection)
   const QString outputMode = settings.getOutputMode();
@@ -574,7 +531,7 @@ void MainWindow::saveSettings() const {
   settings.setWindowState(saveState());
 
   // Save last color
-  settings.setLastColor(ColorLogic::colorToHex(m_currentColor));
+  settings.setLastColor(ColorLogic::colorToStorageString(m_currentColor));
 
   // Save output mode (combobox selection)
   const QString outputMode = ui->comboOutput->currentData().toString();
@@ -583,16 +540,49 @@ void MainWindow::saveSettings() const {
   // Save splitter state
   settings.setSplitterState(m_splitter->saveState());
 
+  // Save plane mode
+  settings.setPlaneMode(QString::fromLatin1(
+      QMetaEnum::fromType<QtHsvRectPicker::PlaneMode>().valueToKey(
+          m_colorPlane->planeMode())));
+
   // Save palettes
   PaletteManager::instance().savePalettes();
 }
 
+void MainWindow::showEvent(QShowEvent *event) {
+  QMainWindow::showEvent(event);
+
+  // The expose arrives asynchronously on X11 and Wayland, so the first frame
+  // is detected on the native window rather than assumed to follow show()
+  if (!m_firstFrameWatched && windowHandle()) {
+    m_firstFrameWatched = true;
+    windowHandle()->installEventFilter(this);
+  }
+}
+
+void MainWindow::loadDeferred() {
+  emit firstFramePresented();
+
+  const Profiler::Scope scope("MainWindow::loadDeferred");
+  PaletteManager::instance().loadDeferredPalettes();
+}
+
 void MainWindow::closeEvent(QCloseEvent *event) {
   saveSettings();
   QMainWindow::closeEvent(event);
 }
 
 bool MainWindow::eventFilter(QObject *obj, QEvent *event) {
+  // Widgets are painted and flushed while the window handles its first
+  // expose, or the update request that follows; the zero timer runs after
+  if (obj == windowHandle() &&
+      (event->type() == QEvent::Expose ||
+       event->type() == QEvent::UpdateRequest) &&
+      windowHandle()->isExposed()) {
+    windowHandle()->removeEventFilter(this);
+    QTimer::singleShot(0, this, &MainWindow::loadDeferred);
+  }
+
   if (event->type() == QEvent::KeyPress) {
     const QKeyEvent *keyEvent = static_cast<QKeyEvent *>(event);
 
@@ -1,42 +1,106 @@
 #include "../include/Palette.h"
+#include "../include/PaletteLibrary.h"
 
 Palette::Palette(const QString &name, const QString &id, bool isReadOnly)
     : m_id(id.isEmpty() ? QUuid::createUuid().toString(QUuid::WithoutBraces)
                         : id),
       m_name(name), m_isReadOnly(isReadOnly) {}
 
+QVector<PackedColor> Palette::preview() const {
+  return isLoaded() ? PaletteLibrary::samplePreview(m_colors) : m_preview;
+}
+
+QColor Palette::colorAt(int index) const {
+  if (index >= 0 && index < m_colors.size()) {
+    return ColorLogic::fromPacked(m_colors[index]);
+  }
+  return QColor();
+}
+
 void Palette::addColor(const QColor &color, const QString &colorName) {
   if (color.isValid()) {
-    m_colors.append(color);
-    m_colorNames.append(colorName);
+    addPackedColor(ColorLogic::toPacked(color), colorName);
+  }
+}
+
+void Palette::addPackedColor(const PackedColor &color, const QString &colorName) {
+  m_colors.append(color);
+  insertName(m_colors.size() - 1, colorName);
+}
+
+void Palette::insertPackedColor(int index, const PackedColor &color,
+                                const QString &colorName) {
+  index = qBound(0, index, int(m_colors.size()));
+  m_colors.insert(index, color);
+  insertName(index, colorName);
+}
+
+void Palette::moveColor(int from, int to) {
+  if (from < 0 || from >= m_colors.size() || to < 0 || to >= m_colors.size() ||
+      from == to)
+    return;
+
+  m_colors.move(from, to);
+  if (!m_nameRefs.isEmpty()) {
+    m_nameRefs.move(from, to);
+  }
+}
+
+bool Palette::containsColor(const QColor &color) const {
+  const quint64 key = ColorLogic::packedKey(ColorLogic::toPacked(color));
+  for (const PackedColor &existing : m_colors) {
+    if (ColorLogic::packedKey(existing) == key) {
+      return true;
+    }
   }
+  return false;
 }
 
-void Palette::setColors(const QVector<QColor> &colors) {
+void Palette::setPackedColors(const QVector<PackedColor> &colors) {
   m_colors = colors;
-  // Clear color names and resize to match colors (with empty names)
-  m_colorNames.clear();
-  m_colorNames.resize(colors.size());
+  m_nameRefs.clear();
+  m_namePool.clear();
 }
 
 void Palette::removeColor(int index) {
   if (index >= 0 && index < m_colors.size()) {
     m_colors.remove(index);
-    // Only remove from color names if the index exists there
-    if (index < m_colorNames.size()) {
-      m_colorNames.remove(index);
+    if (!m_nameRefs.isEmpty()) {
+      m_nameRefs.remove(index);
     }
   }
 }
 
 void Palette::clearColors() {
   m_colors.clear();
-  m_colorNames.clear();
+  m_nameRefs.clear();
+  m_namePool.clear();
+}
+
+QStringView Palette::colorName(int index) const {
+  if (index >= 0 && index < m_nameRefs.size()) {
+    const NameRef &ref = m_nameRefs[index];
+    return QStringView(m_namePool).mid(ref.offset, ref.length);
+  }
+  return QStringView();
+}
+
+Palette::NameRef Palette::storeName(QStringView name) {
+  if (name.isEmpty())
+    return NameRef();
+
+  // Removed names are left in the pool; it is reset with the colors
+  const NameRef ref{quint32(m_namePool.size()), quint32(name.size())};
+  m_namePool.append(name);
+  return ref;
 }
 
-QString Palette::colorName(int index) const {
-  if (index >= 0 && index < m_colorNames.size()) {
-    return m_colorNames[index];
+void Palette::insertName(int index, QStringView name) {
+  // Palettes without names carry no reference table at all
+  if (m_nameRefs.isEmpty()) {
+    if (name.isEmpty())
+      return;
+    m_nameRefs.resize(m_colors.size() - 1);
   }
-  return QString();
+  m_nameRefs.insert(index, storeName(name));
 }
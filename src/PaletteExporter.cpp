@@ -0,0 +1,411 @@
+#include "../include/PaletteExporter.h"
+#include <QBuffer>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+struct Document {
+  QByteArray name;       // UTF-8
+  QByteArray identifier; // PaletteExporter::identifier() of the name
+  const QVector<PackedColor> &colors;
+};
+
+using Renderer = void (*)(const Document &document, QByteArray *out);
+
+struct FormatInfo {
+  PaletteExporter::Format format;
+  const char *name;
+  const char *suffix;
+  // The buffer is reserved as fixedBytes plus bytesPerColor (and the
+  // identifier, if repeated) per color. 8-bit colors always fit; colors
+  // written as color(srgb ...) may grow it.
+  int fixedBytes;
+  int bytesPerColor;
+  bool identifierPerColor;
+  Renderer render;
+};
+
+constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+// Adobe Swatch Exchange color entry: "#rrggbb" name, RGB floats, color type
+constexpr int ASE_NAME_UNITS = 8; // seven characters and a terminating null
+constexpr int ASE_ENTRY_SIZE = 2 + ASE_NAME_UNITS * 2 + 4 + 3 * 4 + 2;
+constexpr int ASE_BLOCK_SIZE = 6 + ASE_ENTRY_SIZE;
+
+constexpr int SWATCH_SIZE = 32;
+constexpr int SWATCH_COLUMNS = 8;
+
+int to8Bit(float value) { return qBound(0, qRound(value * 255.0f), 255); }
+
+void appendHexByte(QByteArray *out, int value) {
+  out->append(HEX_DIGITS[value >> 4]);
+  out->append(HEX_DIGITS[value & 15]);
+}
+
+void appendInt(QByteArray *out, int value, int width = 0) {
+  char digits[12];
+  int count = 0;
+  unsigned magnitude = value < 0 ? 0u - unsigned(value) : unsigned(value);
+  do {
+    digits[count++] = char('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+
+  if (value < 0)
+    digits[count++] = '-';
+  for (int i = count; i < width; ++i)
+    out->append(' ');
+  while (count > 0)
+    out->append(digits[--count]);
+}
+
+void appendSrgbFunction(QByteArray *out, const PackedColor &color) {
+  out->append("color(srgb ");
+  out->append(QByteArray::number(color.red(), 'g', 6));
+  out->append(' ');
+  out->append(QByteArray::number(color.green(), 'g', 6));
+  out->append(' ');
+  out->append(QByteArray::number(color.blue(), 'g', 6));
+  if (color.alpha() < 1.0f) {
+    out->append(" / ");
+    out->append(QByteArray::number(color.alpha(), 'g', 6));
+  }
+  out->append(')');
+}
+
+// #rrggbb, or #rrggbbaa when translucent
+void appendCssColor(QByteArray *out, const PackedColor &color) {
+  if (!ColorLogic::isEightBit(color)) {
+    appendSrgbFunction(out, color);
+    return;
+  }
+  out->append('#');
+  appendHexByte(out, to8Bit(color.red()));
+  appendHexByte(out, to8Bit(color.green()));
+  appendHexByte(out, to8Bit(color.blue()));
+  if (const int alpha = to8Bit(color.alpha()); alpha < 255) {
+    appendHexByte(out, alpha);
+  }
+}
+
+// Same text as ColorLogic::packedToStorageString (#aarrggbb for 8-bit colors)
+void appendStorageColor(QByteArray *out, const PackedColor &color) {
+  if (!ColorLogic::isEightBit(color)) {
+    appendSrgbFunction(out, color);
+    return;
+  }
+  out->append('#');
+  appendHexByte(out, to8Bit(color.alpha()));
+  appendHexByte(out, to8Bit(color.red()));
+  appendHexByte(out, to8Bit(color.green()));
+  appendHexByte(out, to8Bit(color.blue()));
+}
+
+void appendJsonString(QByteArray *out, const QByteArray &utf8) {
+  out->append('"');
+  for (char c : utf8) {
+    if (c == '"' || c == '\\') {
+      out->append('\\');
+      out->append(c);
+    } else if (uchar(c) < 0x20) {
+      out->append("\\u00");
+      appendHexByte(out, uchar(c));
+    } else {
+      out->append(c);
+    }
+  }
+  out->append('"');
+}
+
+void renderPlainText(const Document &document, QByteArray *out) {
+  for (const PackedColor &color : document.colors) {
+    appendStorageColor(out, color);
+    out->append('\n');
+  }
+}
+
+void renderGpl(const Document &document, QByteArray *out) {
+  QByteArray name = document.name;
+  name.replace('\n', ' ');
+
+  out->append("GIMP Palette\nName: ");
+  out->append(name);
+  out->append("\nColumns: 8\n#\n");
+  for (const PackedColor &color : document.colors) {
+    const int r = to8Bit(color.red());
+    const int g = to8Bit(color.green());
+    const int b = to8Bit(color.blue());
+    appendInt(out, r, 3);
+    out->append(' ');
+    appendInt(out, g, 3);
+    out->append(' ');
+    appendInt(out, b, 3);
+    out->append("\t#");
+    appendHexByte(out, r);
+    appendHexByte(out, g);
+    appendHexByte(out, b);
+    out->append('\n');
+  }
+}
+
+void renderAse(const Document &document, QByteArray *out) {
+  // Fixed-size records, so the file is laid out in place
+  const qsizetype start = out->size();
+  out->resize(start + 12 + document.colors.size() * qsizetype(ASE_BLOCK_SIZE));
+  char *p = out->data() + start;
+
+  std::memcpy(p, "ASEF", 4);
+  qToBigEndian<quint16>(1, p + 4);
+  qToBigEndian<quint16>(0, p + 6);
+  qToBigEndian<quint32>(quint32(document.colors.size()), p + 8);
+  p += 12;
+
+  for (const PackedColor &color : document.colors) {
+    const int channels[3] = {to8Bit(color.red()), to8Bit(color.green()),
+                             to8Bit(color.blue())};
+
+    qToBigEndian<quint16>(0x0001, p); // color entry
+    qToBigEndian<quint32>(ASE_ENTRY_SIZE, p + 2);
+    qToBigEndian<quint16>(ASE_NAME_UNITS, p + 6);
+    p += 8;
+
+    qToBigEndian<quint16>('#', p);
+    p += 2;
+    for (int channel : channels) {
+      qToBigEndian<quint16>(HEX_DIGITS[channel >> 4], p);
+      qToBigEndian<quint16>(HEX_DIGITS[channel & 15], p + 2);
+      p += 4;
+    }
+    qToBigEndian<quint16>(0, p);
+    p += 2;
+
+    std::memcpy(p, "RGB ", 4);
+    p += 4;
+    for (float value : {float(color.red()), float(color.green()),
+                        float(color.blue())}) {
+      const float clamped = qBound(0.0f, value, 1.0f);
+      quint32 bits;
+      std::memcpy(&bits, &clamped, sizeof(bits));
+      qToBigEndian<quint32>(bits, p);
+      p += 4;
+    }
+
+    qToBigEndian<quint16>(2, p); // normal (neither global nor spot)
+    p += 2;
+  }
+}
+
+void renderCss(const Document &document, QByteArray *out) {
+  out->append(":root {\n");
+  for (int i = 0; i < document.colors.size(); ++i) {
+    out->append("  --");
+    out->append(document.identifier);
+    out->append('-');
+    appendInt(out, i + 1);
+    out->append(": ");
+    appendCssColor(out, document.colors[i]);
+    out->append(";\n");
+  }
+  out->append("}\n");
+}
+
+void renderScss(const Document &document, QByteArray *out) {
+  for (int i = 0; i < document.colors.size(); ++i) {
+    out->append('$');
+    out->append(document.identifier);
+    out->append('-');
+    appendInt(out, i + 1);
+    out->append(": ");
+    appendCssColor(out, document.colors[i]);
+    out->append(";\n");
+  }
+}
+
+void renderTailwind(const Document &document, QByteArray *out) {
+  out->append("module.exports = {\n"
+              "  theme: {\n"
+              "    extend: {\n"
+              "      colors: {\n"
+              "        '");
+  out->append(document.identifier);
+  out->append("': {\n");
+  for (int i = 0; i < document.colors.size(); ++i) {
+    out->append("          '");
+    appendInt(out, i + 1);
+    out->append("': '");
+    appendCssColor(out, document.colors[i]);
+    out->append("',\n");
+  }
+  out->append("        },\n"
+              "      },\n"
+              "    },\n"
+              "  },\n"
+              "};\n");
+}
+
+void renderJson(const Document &document, QByteArray *out) {
+  out->append("{\n  \"name\": ");
+  appendJsonString(out, document.name);
+  out->append(",\n  \"colors\": [");
+  for (int i = 0; i < document.colors.size(); ++i) {
+    out->append(i == 0 ? "\n    \"" : ",\n    \"");
+    appendCssColor(out, document.colors[i]);
+    out->append('"');
+  }
+  out->append(document.colors.isEmpty() ? "]\n}\n" : "\n  ]\n}\n");
+}
+
+void renderPng(const Document &document, QByteArray *out) {
+  const int count = document.colors.size();
+  const int columns = qBound(1, count, SWATCH_COLUMNS);
+  const int rows = qMax(1, (count + columns - 1) / columns);
+
+  // 16 bits per channel keeps colors finer than 8 bits
+  QImage image(columns * SWATCH_SIZE, rows * SWATCH_SIZE, QImage::Format_RGBA64);
+  image.fill(Qt::transparent);
+
+  auto channel = [](float value) {
+    return quint16(qBound(0, qRound(value * 65535.0f), 65535));
+  };
+
+  for (int i = 0; i < count; ++i) {
+    const PackedColor &color = document.colors[i];
+    const QRgba64 pixel =
+        QRgba64::fromRgba64(channel(color.red()), channel(color.green()),
+                            channel(color.blue()), channel(color.alpha()));
+    const int x = (i % columns) * SWATCH_SIZE;
+    const int y = (i / columns) * SWATCH_SIZE;
+    for (int row = y; row < y + SWATCH_SIZE; ++row) {
+      QRgba64 *line = reinterpret_cast<QRgba64 *>(image.scanLine(row)) + x;
+      std::fill(line, line + SWATCH_SIZE, pixel);
+    }
+  }
+
+  QBuffer buffer(out);
+  buffer.open(QIODevice::WriteOnly);
+  image.save(&buffer, "PNG");
+}
+
+constexpr FormatInfo FORMATS[] = {
+    {PaletteExporter::PlainText, "text", "txt", 0, 10, false, renderPlainText},
+    {PaletteExporter::Gpl, "gpl", "gpl", 64, 20, false, renderGpl},
+    {PaletteExporter::Ase, "ase", "ase", 12, ASE_BLOCK_SIZE, false, renderAse},
+    {PaletteExporter::Css, "css", "css", 16, 28, true, renderCss},
+    {PaletteExporter::Scss, "scss", "scss", 0, 25, true, renderScss},
+    {PaletteExporter::Tailwind, "tailwind", "js", 160, 37, false,
+     renderTailwind},
+    {PaletteExporter::Json, "json", "json", 48, 17, false, renderJson},
+    {PaletteExporter::Png, "png", "png", 1024, 64, false, renderPng},
+};
+
+const FormatInfo &formatInfo(PaletteExporter::Format format) {
+  for (const FormatInfo &info : FORMATS) {
+    if (info.format == format)
+      return info;
+  }
+  return FORMATS[0];
+}
+
+} // namespace
+
+QVector<PaletteExporter::Format> PaletteExporter::formats() {
+  QVector<Format> result;
+  for (const FormatInfo &info : FORMATS) {
+    result.append(info.format);
+  }
+  return result;
+}
+
+QString PaletteExporter::formatName(Format format) {
+  return QString::fromLatin1(formatInfo(format).name);
+}
+
+QString PaletteExporter::fileSuffix(Format format) {
+  return QString::fromLatin1(formatInfo(format).suffix);
+}
+
+bool PaletteExporter::formatFromName(const QString &name, Format *format) {
+  QString key = name.trimmed().toLower();
+  if (key.startsWith('.')) {
+    key.remove(0, 1);
+  }
+
+  for (const FormatInfo &info : FORMATS) {
+    if (key == QLatin1String(info.name) || key == QLatin1String(info.suffix)) {
+      *format = info.format;
+      return true;
+    }
+  }
+  return false;
+}
+
+QString PaletteExporter::identifier(const QString &paletteName) {
+  QString id;
+  id.reserve(paletteName.size());
+
+  // Runs of anything else collapse into a single dash
+  bool separator = false;
+  for (QChar c : paletteName.toLower()) {
+    if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+      if (separator && !id.isEmpty()) {
+        id += '-';
+      }
+      separator = false;
+      id += c;
+    } else {
+      separator = true;
+    }
+  }
+
+  // SCSS and JavaScript identifiers cannot start with a digit
+  if (id.isEmpty() || id.at(0).isDigit()) {
+    id.prepend(id.isEmpty() ? QStringLiteral("palette")
+                            : QStringLiteral("palette-"));
+  }
+  return id;
+}
+
+QByteArray PaletteExporter::render(const QString &name,
+                                   const QVector<PackedColor> &colors,
+                                   Format format) {
+  const FormatInfo &info = formatInfo(format);
+  const Document document{name.toUtf8(), identifier(name).toLatin1(), colors};
+
+  const qsizetype perColor =
+      info.bytesPerColor +
+      (info.identifierPerColor ? document.identifier.size() : 0);
+  QByteArray out;
+  out.reserve(info.fixedBytes + document.name.size() +
+              document.identifier.size() + colors.size() * perColor);
+
+  info.render(document, &out);
+  return out;
+}
+
+bool PaletteExporter::exportFile(const QString &path, const QString &name,
+                                 const QVector<PackedColor> &colors,
+                                 Format format) {
+  const QByteArray data = render(name, colors, format);
+
+  QDir().mkpath(QFileInfo(path).absolutePath());
+
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qWarning() << "Failed to open" << path << "for writing:" << file.errorString();
+    return false;
+  }
+
+  file.write(data);
+  if (!file.commit()) {
+    qWarning() << "Failed to write" << path << ":" << file.errorString();
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,643 @@
+#include "../include/PaletteImporter.h"
+#include "../include/ColorSpace.h"
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr qint64 PROGRESS_STEP = 256 * 1024;
+constexpr int MAX_LINE = 4096;      // longer lines are truncated
+constexpr int MAX_STATEMENT = 4096; // longer CSS declarations are ignored
+constexpr int CHUNK_SIZE = 64 * 1024;
+constexpr quint32 MAX_ASE_BLOCK = 64 * 1024;
+constexpr quint16 ASE_COLOR_ENTRY = 0x0001;
+
+using Result = PaletteImporter::Result;
+
+// Forwards progress at most once per PROGRESS_STEP bytes
+class ProgressReporter {
+public:
+  ProgressReporter(QIODevice *device,
+                   const PaletteImporter::ProgressCallback &callback)
+      : m_device(device), m_callback(callback),
+        m_total(device->isSequential() ? 0 : device->size()) {}
+
+  // False once the callback asked to cancel
+  bool update() {
+    if (!m_callback)
+      return true;
+    const qint64 done = m_device->pos();
+    if (done - m_reported < PROGRESS_STEP)
+      return true;
+    m_reported = done;
+    return m_callback(done, m_total);
+  }
+
+private:
+  QIODevice *m_device;
+  const PaletteImporter::ProgressCallback &m_callback;
+  qint64 m_total;
+  qint64 m_reported = 0;
+};
+
+// Reads lines into a fixed buffer; the rest of an over-long line is dropped
+class LineReader {
+public:
+  explicit LineReader(QIODevice *device) : m_device(device) {}
+
+  // Next line without its line break; false at the end of the device
+  bool next(QByteArrayView *line) {
+    qint64 length = m_device->readLine(m_buffer, sizeof(m_buffer));
+    if (length <= 0)
+      return false;
+
+    if (m_buffer[length - 1] != '\n') {
+      char c;
+      while (m_device->getChar(&c) && c != '\n') {
+      }
+    }
+    while (length > 0 &&
+           (m_buffer[length - 1] == '\n' || m_buffer[length - 1] == '\r')) {
+      --length;
+    }
+    *line = QByteArrayView(m_buffer, length);
+    return true;
+  }
+
+private:
+  QIODevice *m_device;
+  char m_buffer[MAX_LINE];
+};
+
+bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' ||
+         c == '\v';
+}
+
+QByteArrayView trimSpaces(QByteArrayView text) {
+  qsizetype begin = 0;
+  qsizetype end = text.size();
+  while (begin < end && isSpace(text.at(begin)))
+    ++begin;
+  while (end > begin && isSpace(text.at(end - 1)))
+    --end;
+  return text.sliced(begin, end - begin);
+}
+
+qsizetype indexOf(QByteArrayView text, char c) {
+  const auto it = std::find(text.begin(), text.end(), c);
+  return it == text.end() ? -1 : it - text.begin();
+}
+
+// Takes a decimal integer off the front of text, skipping leading whitespace
+bool takeInt(QByteArrayView *text, int *value) {
+  qsizetype i = 0;
+  while (i < text->size() && isSpace(text->at(i)))
+    ++i;
+
+  const qsizetype start = i;
+  int result = 0;
+  while (i < text->size() && i - start < 9 && text->at(i) >= '0' &&
+         text->at(i) <= '9') {
+    result = result * 10 + (text->at(i) - '0');
+    ++i;
+  }
+  if (i == start)
+    return false;
+
+  *value = result;
+  *text = text->sliced(i);
+  return true;
+}
+
+bool readExact(QIODevice *device, char *data, qint64 size) {
+  return device->read(data, size) == size;
+}
+
+float bigEndianFloat(const char *data) {
+  const quint32 bits = qFromBigEndian<quint32>(data);
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+PackedColor fromCmyk(float c, float m, float y, float k) {
+  // Naive conversion; swatch files carry no ink profile to do better
+  return ColorLogic::packedFromRgbF((1.0f - c) * (1.0f - k),
+                                    (1.0f - m) * (1.0f - k),
+                                    (1.0f - y) * (1.0f - k));
+}
+
+PackedColor fromLab(float L, float a, float b) {
+  const ColorSpace::Rgb rgb = ColorSpace::labToLinearRgb({L, a, b});
+  auto channel = [](float c) {
+    return qBound(0.0f, ColorSpace::linearToSrgb(c), 1.0f);
+  };
+  return ColorLogic::packedFromRgbF(channel(rgb.r), channel(rgb.g),
+                                    channel(rgb.b));
+}
+
+PackedColor fromHsv(float hue, float s, float v) {
+  const float sector = std::fmod(hue / 60.0f, 6.0f);
+  const float c = v * s;
+  const float x = c * (1.0f - std::fabs(std::fmod(sector, 2.0f) - 1.0f));
+  const float m = v - c;
+
+  float r = 0.0f, g = 0.0f, b = 0.0f;
+  switch (static_cast<int>(sector)) {
+  case 0:
+    r = c;
+    g = x;
+    break;
+  case 1:
+    r = x;
+    g = c;
+    break;
+  case 2:
+    g = c;
+    b = x;
+    break;
+  case 3:
+    g = x;
+    b = c;
+    break;
+  case 4:
+    r = x;
+    b = c;
+    break;
+  default:
+    r = c;
+    b = x;
+    break;
+  }
+  return ColorLogic::packedFromRgbF(r + m, g + m, b + m);
+}
+
+// CSS Color 4 color(srgb r g b / a), the storage form of colors finer than
+// 8 bits
+bool parseSrgbFunction(QByteArrayView text, PackedColor *packed) {
+  if (!text.startsWith("color(") || !text.endsWith(')'))
+    return false;
+  text = trimSpaces(text.sliced(6, text.size() - 7));
+  if (!text.startsWith("srgb"))
+    return false;
+  text = text.sliced(4);
+
+  float values[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+  int count = 0;
+  bool slash = false;
+  qsizetype i = 0;
+  while (i < text.size()) {
+    if (isSpace(text.at(i))) {
+      ++i;
+      continue;
+    }
+    if (text.at(i) == '/') {
+      if (count != 3 || slash)
+        return false;
+      slash = true;
+      ++i;
+      continue;
+    }
+    if (count == 4 || (count == 3 && !slash))
+      return false;
+
+    qsizetype end = i;
+    while (end < text.size() && !isSpace(text.at(end)) && text.at(end) != '/')
+      ++end;
+    bool ok = false;
+    values[count++] =
+        QByteArray::fromRawData(text.data() + i, end - i).toFloat(&ok);
+    if (!ok)
+      return false;
+    i = end;
+  }
+  if (count != (slash ? 4 : 3))
+    return false;
+
+  *packed = ColorLogic::packedFromRgbF(values[0], values[1], values[2],
+                                       qBound(0.0f, values[3], 1.0f));
+  return true;
+}
+
+// Named colors and functional notations other than color(srgb) are rare in
+// palette files, so they go through the QColor based parsers
+bool parseSlowColor(QByteArrayView text, PackedColor *packed) {
+  const QString string = QString::fromUtf8(text);
+  QColor color;
+  if (text.startsWith("rgba(")) {
+    color = ColorLogic::rgbaStringToColor(string);
+  } else if (text.startsWith("rgb(")) {
+    color = ColorLogic::rgbStringToColor(string);
+  } else if (text.startsWith("hsla(")) {
+    color = ColorLogic::hslaStringToColor(string);
+  } else if (text.startsWith("hsl(")) {
+    color = ColorLogic::hslStringToColor(string);
+  } else {
+    color = QColor(string);
+  }
+
+  if (!color.isValid())
+    return false;
+  *packed = ColorLogic::toPacked(color);
+  return true;
+}
+
+bool importPlainText(QIODevice *device, Result *result,
+                     ProgressReporter &progress) {
+  LineReader reader(device);
+  QByteArrayView line;
+  while (reader.next(&line)) {
+    if (!progress.update())
+      return false;
+
+    line = trimSpaces(line);
+    if (line.isEmpty())
+      continue;
+
+    // Hex needs its '#' as it does for QColor, or words such as "face"
+    // would import as colors; QColor has no 4-digit form either
+    PackedColor packed;
+    if ((line.startsWith('#') && line.size() != 5 &&
+         ColorLogic::hexToPacked(line, &packed)) ||
+        parseSrgbFunction(line, &packed) || parseSlowColor(line, &packed)) {
+      result->colors.append(packed);
+    } else {
+      ++result->skipped;
+    }
+  }
+  return true;
+}
+
+bool importGpl(QIODevice *device, Result *result, ProgressReporter &progress) {
+  LineReader reader(device);
+  QByteArrayView line;
+  if (!reader.next(&line) || !trimSpaces(line).startsWith("GIMP Palette")) {
+    qWarning() << "Not a GIMP palette";
+    return false;
+  }
+
+  while (reader.next(&line)) {
+    if (!progress.update())
+      return false;
+
+    line = trimSpaces(line);
+    if (line.isEmpty() || line.at(0) == '#' || line.startsWith("Columns:"))
+      continue;
+    if (line.startsWith("Name:")) {
+      result->name = QString::fromUtf8(trimSpaces(line.sliced(5)));
+      continue;
+    }
+
+    // "R G B<whitespace>optional name"
+    int r, g, b;
+    if (takeInt(&line, &r) && takeInt(&line, &g) && takeInt(&line, &b) &&
+        r <= 255 && g <= 255 && b <= 255) {
+      result->colors.append(
+          ColorLogic::packedFromRgbF(r / 255.0f, g / 255.0f, b / 255.0f));
+    } else {
+      ++result->skipped;
+    }
+  }
+  return true;
+}
+
+// Color entry block: UTF-16 name, 4-byte color model, big-endian floats
+bool parseAseColor(QByteArrayView block, PackedColor *packed) {
+  if (block.size() < 2)
+    return false;
+  const qsizetype nameEnd =
+      2 + qsizetype(qFromBigEndian<quint16>(block.data())) * 2;
+  if (block.size() < nameEnd + 4)
+    return false;
+
+  const char *model = block.data() + nameEnd;
+  const char *values = model + 4;
+  const qsizetype available = (block.size() - nameEnd - 4) / 4;
+  auto value = [values](int i) { return bigEndianFloat(values + i * 4); };
+
+  if (std::memcmp(model, "RGB ", 4) == 0 && available >= 3) {
+    *packed = ColorLogic::packedFromRgbF(value(0), value(1), value(2));
+  } else if (std::memcmp(model, "CMYK", 4) == 0 && available >= 4) {
+    *packed = fromCmyk(value(0), value(1), value(2), value(3));
+  } else if (std::memcmp(model, "LAB ", 4) == 0 && available >= 3) {
+    // L is stored as a fraction
+    *packed = fromLab(value(0) * 100.0f, value(1), value(2));
+  } else if (std::memcmp(model, "Gray", 4) == 0 && available >= 1) {
+    *packed = ColorLogic::packedFromRgbF(value(0), value(0), value(0));
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool importAse(QIODevice *device, Result *result, ProgressReporter &progress) {
+  // "ASEF", version major/minor, block count
+  char header[12];
+  if (!readExact(device, header, sizeof(header)) ||
+      std::memcmp(header, "ASEF", 4) != 0) {
+    qWarning() << "Not an Adobe Swatch Exchange file";
+    return false;
+  }
+
+  const quint32 blockCount = qFromBigEndian<quint32>(header + 8);
+  QByteArray block;
+  for (quint32 i = 0; i < blockCount; ++i) {
+    char blockHeader[6];
+    if (!readExact(device, blockHeader, sizeof(blockHeader))) {
+      qWarning() << "Truncated ASE file after" << i << "blocks";
+      break;
+    }
+    const quint16 type = qFromBigEndian<quint16>(blockHeader);
+    const quint32 length = qFromBigEndian<quint32>(blockHeader + 2);
+
+    // Group start/end blocks only carry a name
+    if (type != ASE_COLOR_ENTRY || length > MAX_ASE_BLOCK) {
+      if (type == ASE_COLOR_ENTRY)
+        ++result->skipped;
+      if (device->skip(length) != qint64(length)) {
+        qWarning() << "Truncated ASE file after" << i << "blocks";
+        break;
+      }
+      continue;
+    }
+
+    block.resize(length);
+    if (!readExact(device, block.data(), length)) {
+      qWarning() << "Truncated ASE file after" << i << "blocks";
+      break;
+    }
+
+    PackedColor packed;
+    if (parseAseColor(block, &packed)) {
+      result->colors.append(packed);
+    } else {
+      ++result->skipped;
+    }
+
+    if (!progress.update())
+      return false;
+  }
+  return true;
+}
+
+// Color entry: color space, then four 16-bit components
+bool parseAcoColor(const char *entry, PackedColor *packed) {
+  const quint16 space = qFromBigEndian<quint16>(entry);
+  const quint16 w = qFromBigEndian<quint16>(entry + 2);
+  const quint16 x = qFromBigEndian<quint16>(entry + 4);
+  const quint16 y = qFromBigEndian<quint16>(entry + 6);
+  const quint16 z = qFromBigEndian<quint16>(entry + 8);
+
+  switch (space) {
+  case 0: // RGB
+    *packed =
+        ColorLogic::packedFromRgbF(w / 65535.0f, x / 65535.0f, y / 65535.0f);
+    return true;
+  case 1: // HSB
+    *packed = fromHsv(w / 65535.0f * 360.0f, x / 65535.0f, y / 65535.0f);
+    return true;
+  case 2: // CMYK, 0 is full ink
+    *packed = fromCmyk(1.0f - w / 65535.0f, 1.0f - x / 65535.0f,
+                       1.0f - y / 65535.0f, 1.0f - z / 65535.0f);
+    return true;
+  case 7: // Lab, L in 0..10000 and signed a/b in hundredths
+    *packed = fromLab(w / 100.0f, qint16(x) / 100.0f, qint16(y) / 100.0f);
+    return true;
+  case 8: { // Grayscale as ink coverage in 0..10000
+    const float gray = 1.0f - qMin<quint16>(w, 10000) / 10000.0f;
+    *packed = ColorLogic::packedFromRgbF(gray, gray, gray);
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+bool importAco(QIODevice *device, Result *result, ProgressReporter &progress) {
+  char header[4];
+  if (!readExact(device, header, sizeof(header))) {
+    qWarning() << "Truncated ACO file";
+    return false;
+  }
+
+  const quint16 version = qFromBigEndian<quint16>(header);
+  const quint16 count = qFromBigEndian<quint16>(header + 2);
+  if (version != 1 && version != 2) {
+    qWarning() << "Unsupported ACO version" << version;
+    return false;
+  }
+
+  // Version 1 data is usually followed by a version 2 copy of the same
+  // colors that adds names, so reading stops after the first section
+  for (int i = 0; i < count; ++i) {
+    char entry[10];
+    if (!readExact(device, entry, sizeof(entry))) {
+      qWarning() << "Truncated ACO file after" << i << "colors";
+      break;
+    }
+
+    if (version == 2) {
+      // Name as a UTF-16 unit count followed by the units
+      char nameLength[4];
+      const qint64 nameSize =
+          readExact(device, nameLength, sizeof(nameLength))
+              ? qint64(qFromBigEndian<quint32>(nameLength)) * 2
+              : -1;
+      if (nameSize < 0 || device->skip(nameSize) != nameSize) {
+        qWarning() << "Truncated ACO file after" << i << "colors";
+        break;
+      }
+    }
+
+    PackedColor packed;
+    if (parseAcoColor(entry, &packed)) {
+      result->colors.append(packed);
+    } else {
+      ++result->skipped;
+    }
+
+    if (!progress.update())
+      return false;
+  }
+  return true;
+}
+
+// --name: value and $name: value declarations holding a color
+void parseCssDeclaration(QByteArrayView statement, Result *result) {
+  const QByteArrayView text = trimSpaces(statement);
+  if (!text.startsWith("--") && !text.startsWith('$'))
+    return;
+
+  const qsizetype colon = indexOf(text, ':');
+  if (colon < 0)
+    return;
+
+  QByteArrayView value = text.sliced(colon + 1);
+  // Drop !important, !default and friends
+  if (const qsizetype bang = indexOf(value, '!'); bang >= 0) {
+    value = value.first(bang);
+  }
+  value = trimSpaces(value);
+  if (value.isEmpty())
+    return;
+
+  // Only '#' marks hex here; bare words are names or other values
+  PackedColor packed;
+  if ((value.at(0) == '#' && ColorLogic::hexToPacked(value, &packed, true)) ||
+      parseSrgbFunction(value, &packed) || parseSlowColor(value, &packed)) {
+    result->colors.append(packed);
+  }
+}
+
+// Splits the stream into declarations at ';', '{' and '}' without ever
+// holding more than one chunk and one declaration, skipping comments and
+// keeping quoted text intact
+bool importCss(QIODevice *device, Result *result, ProgressReporter &progress) {
+  enum State { Normal, BlockComment, LineComment, Quoted };
+
+  QByteArray chunk(CHUNK_SIZE, Qt::Uninitialized);
+  QByteArray statement;
+  statement.reserve(MAX_STATEMENT);
+  bool overflow = false;
+  State state = Normal;
+  char quote = 0;
+  char previous = 0;
+
+  auto finishStatement = [&]() {
+    if (!overflow) {
+      parseCssDeclaration(statement, result);
+    }
+    statement.clear();
+    overflow = false;
+  };
+
+  auto append = [&](char c) {
+    if (statement.size() < MAX_STATEMENT) {
+      statement.append(c);
+    } else {
+      overflow = true;
+    }
+  };
+
+  qint64 read;
+  while ((read = device->read(chunk.data(), chunk.size())) > 0) {
+    for (qint64 i = 0; i < read; ++i) {
+      const char c = chunk.at(i);
+      switch (state) {
+      case BlockComment:
+        if (previous == '*' && c == '/') {
+          state = Normal;
+          previous = 0;
+          continue;
+        }
+        break;
+      case LineComment:
+        if (c == '\n')
+          state = Normal;
+        break;
+      case Quoted:
+        append(c);
+        if (c == quote && previous != '\\')
+          state = Normal;
+        break;
+      case Normal:
+        if (previous == '/' && c == '*') {
+          statement.chop(1);
+          state = BlockComment;
+          previous = 0;
+          continue;
+        }
+        // SCSS line comments, recognized only where a declaration starts
+        if (previous == '/' && c == '/' && trimSpaces(statement).size() == 1) {
+          statement.clear();
+          state = LineComment;
+          break;
+        }
+        if (c == ';' || c == '{' || c == '}') {
+          finishStatement();
+        } else {
+          append(c);
+          if (c == '"' || c == '\'') {
+            state = Quoted;
+            quote = c;
+          }
+        }
+        break;
+      }
+      previous = c;
+    }
+
+    if (!progress.update())
+      return false;
+  }
+
+  if (read < 0) {
+    qWarning() << "Failed to read CSS file:" << device->errorString();
+    return false;
+  }
+
+  // SCSS allows the last declaration to go without a semicolon
+  if (state == Normal) {
+    finishStatement();
+  }
+  return true;
+}
+
+} // namespace
+
+PaletteImporter::Format PaletteImporter::detectFormat(QIODevice *device,
+                                                      const QString &fileName) {
+  const QByteArray head = device->peek(12);
+  if (head.startsWith("ASEF"))
+    return Ase;
+  if (head.startsWith("GIMP Palette"))
+    return Gpl;
+
+  const QString suffix = QFileInfo(fileName).suffix().toLower();
+  if (suffix == "gpl")
+    return Gpl;
+  if (suffix == "ase")
+    return Ase;
+  if (suffix == "aco")
+    return Aco;
+  if (suffix == "css" || suffix == "scss")
+    return Css;
+  return PlainText;
+}
+
+bool PaletteImporter::import(QIODevice *device, Format format, Result *result,
+                             const ProgressCallback &progress) {
+  *result = Result();
+  ProgressReporter reporter(device, progress);
+
+  switch (format) {
+  case PlainText:
+    return importPlainText(device, result, reporter);
+  case Gpl:
+    return importGpl(device, result, reporter);
+  case Ase:
+    return importAse(device, result, reporter);
+  case Aco:
+    return importAco(device, result, reporter);
+  case Css:
+    return importCss(device, result, reporter);
+  }
+  return false;
+}
+
+bool PaletteImporter::importFile(const QString &path, Result *result,
+                                 const ProgressCallback &progress) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    qWarning() << "Failed to open palette file" << path << ":"
+               << file.errorString();
+    return false;
+  }
+  return import(&file, detectFormat(&file, path), result, progress);
+}
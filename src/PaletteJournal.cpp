@@ -0,0 +1,249 @@
+#include "../include/PaletteJournal.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <iterator>
+
+namespace {
+
+// Operation names as written to the journal
+const char *const OPERATION_NAMES[] = {"create", "delete", "rename", "add",
+                                       "remove", "move",   "set",    "select"};
+
+} // namespace
+
+bool PaletteJournal::open(const QString &path) {
+  close();
+  QDir().mkpath(QFileInfo(path).absolutePath());
+
+  m_file.setFileName(path);
+  if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+    qWarning() << "Failed to open palette journal" << path << ":"
+               << m_file.errorString();
+    return false;
+  }
+  m_size = m_file.size();
+
+  // A crash during append can leave the last line cut short; the first batch
+  // then starts on a fresh line so it is not lost along with it
+  m_partialLine = false;
+  if (m_size > 0) {
+    QFile existing(path);
+    if (existing.open(QIODevice::ReadOnly) && existing.seek(m_size - 1)) {
+      m_partialLine = existing.read(1) != "\n";
+    }
+  }
+  return true;
+}
+
+void PaletteJournal::close() {
+  if (m_file.isOpen()) {
+    m_file.close();
+  }
+}
+
+QVector<PaletteJournal::Entry>
+PaletteJournal::readEntries(const QString &path) {
+  QVector<Entry> entries;
+
+  for (const QString &filePath : {rotatedPath(path), path}) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+      continue;
+
+    while (!file.atEnd()) {
+      const QByteArray line = file.readLine().trimmed();
+      if (line.isEmpty())
+        continue;
+
+      // A crash during append can leave a partial last line; skip it
+      if (Entry entry; parse(line, &entry)) {
+        entries.append(entry);
+      }
+    }
+  }
+
+  return entries;
+}
+
+bool PaletteJournal::append(const QVector<Entry> &entries) {
+  // One write and flush per batch rather than per entry. After a failed
+  // write the batch starts on a fresh line; empty lines are skipped on read.
+  QByteArray data = m_partialLine ? QByteArray("\n") : QByteArray();
+  for (const Entry &entry : entries) {
+    data += serialize(entry);
+  }
+
+  // The file stays closed if a rotation could not reopen it; try again
+  if (!m_file.isOpen() &&
+      !m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+    qWarning() << "Failed to open palette journal" << m_file.fileName() << ":"
+               << m_file.errorString();
+    return false;
+  }
+
+  const bool written = m_file.write(data) == data.size() && m_file.flush();
+  m_size = m_file.size();
+  m_partialLine = !written;
+
+  if (!written) {
+    qWarning() << "Failed to write palette journal" << m_file.fileName()
+               << ":" << m_file.errorString();
+  }
+  return written;
+}
+
+bool PaletteJournal::rotate() {
+  const QString path = m_file.fileName();
+  if (path.isEmpty())
+    return false;
+
+  if (hasRotated()) {
+    QFile active(path);
+    if (!active.open(QIODevice::ReadOnly)) {
+      qWarning() << "Failed to read palette journal" << path << ":"
+                 << active.errorString();
+      return false;
+    }
+
+    QFile rotated(rotatedPath());
+    if (!rotated.open(QIODevice::WriteOnly | QIODevice::Append)) {
+      qWarning() << "Failed to open palette journal" << rotated.fileName()
+                 << ":" << rotated.errorString();
+      return false;
+    }
+
+    // The leading newline ends a line cut short by a crash
+    const QByteArray entries = '\n' + active.readAll();
+    if (rotated.write(entries) != entries.size() || !rotated.flush()) {
+      qWarning() << "Failed to write palette journal" << rotated.fileName()
+                 << ":" << rotated.errorString();
+      return false;
+    }
+
+    // Until the resize the entries are in both files; replay skips the
+    // second copy by sequence
+    const bool truncated =
+        m_file.isOpen() ? m_file.resize(0) : QFile::resize(path, 0);
+    if (truncated) {
+      m_size = 0;
+      m_partialLine = false;
+    }
+    return truncated;
+  }
+
+  close();
+  const bool renamed = QFile::rename(path, rotatedPath());
+  if (renamed) {
+    m_size = 0;
+  } else {
+    qWarning() << "Failed to rotate palette journal" << path;
+  }
+  // If this fails append() retries opening
+  open(path);
+  m_partialLine = false;
+  return renamed;
+}
+
+bool PaletteJournal::hasRotated() const { return QFile::exists(rotatedPath()); }
+
+void PaletteJournal::removeRotated() { QFile::remove(rotatedPath()); }
+
+void PaletteJournal::clear() {
+  if (m_file.isOpen()) {
+    m_file.resize(0);
+    m_size = 0;
+    m_partialLine = false;
+  }
+  removeRotated();
+}
+
+QByteArray PaletteJournal::serialize(const Entry &entry) {
+  QJsonObject obj;
+  obj["seq"] = static_cast<qint64>(entry.sequence);
+  obj["op"] = OPERATION_NAMES[entry.operation];
+  obj["palette"] = entry.paletteId;
+
+  switch (entry.operation) {
+  case CreatePalette:
+  case RenamePalette:
+    obj["name"] = entry.name;
+    break;
+  case AddColor:
+    obj["index"] = entry.index;
+    obj["color"] = ColorLogic::packedToStorageString(entry.colors.value(0));
+    break;
+  case RemoveColor:
+    obj["index"] = entry.index;
+    break;
+  case MoveColor:
+    obj["index"] = entry.index;
+    obj["to"] = entry.toIndex;
+    break;
+  case SetColors: {
+    QJsonArray colorsArray;
+    for (const PackedColor &color : entry.colors) {
+      colorsArray.append(ColorLogic::packedToStorageString(color));
+    }
+    obj["colors"] = colorsArray;
+    break;
+  }
+  case DeletePalette:
+  case SelectPalette:
+    break;
+  }
+
+  return QJsonDocument(obj).toJson(QJsonDocument::Compact) + '\n';
+}
+
+bool PaletteJournal::parse(const QByteArray &line, Entry *entry) {
+  const QJsonDocument doc = QJsonDocument::fromJson(line);
+  if (!doc.isObject())
+    return false;
+
+  const QJsonObject obj = doc.object();
+  const QString op = obj["op"].toString();
+
+  int operation = -1;
+  for (int i = 0; i < int(std::size(OPERATION_NAMES)); ++i) {
+    if (op == QLatin1String(OPERATION_NAMES[i])) {
+      operation = i;
+      break;
+    }
+  }
+  if (operation < 0)
+    return false;
+
+  entry->sequence = static_cast<quint64>(obj["seq"].toInteger());
+  entry->operation = static_cast<Operation>(operation);
+  entry->paletteId = obj["palette"].toString();
+  entry->name = obj["name"].toString();
+  entry->index = obj["index"].toInt(-1);
+  entry->toIndex = obj["to"].toInt(-1);
+  entry->colors.clear();
+
+  if (entry->operation == AddColor) {
+    const QColor color = ColorLogic::storageStringToColor(obj["color"].toString());
+    if (!color.isValid())
+      return false;
+    entry->colors.append(ColorLogic::toPacked(color));
+  } else if (entry->operation == SetColors) {
+    const QJsonArray colorsArray = obj["colors"].toArray();
+    entry->colors.reserve(colorsArray.size());
+    for (const QJsonValue &value : colorsArray) {
+      const QColor color = ColorLogic::storageStringToColor(value.toString());
+      if (color.isValid()) {
+        entry->colors.append(ColorLogic::toPacked(color));
+      }
+    }
+  }
+
+  return entry->sequence > 0 && !entry->paletteId.isEmpty();
+}
+
+QString PaletteJournal::rotatedPath(const QString &path) {
+  return path + ".old";
+}
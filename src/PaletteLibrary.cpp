@@ -0,0 +1,444 @@
+#include "../include/PaletteLibrary.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QSysInfo>
+#include <QtEndian>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+constexpr char MAGIC[4] = {'C', 'S', 'P', 'L'};
+constexpr int HEADER_SIZE_V1 = 48;
+constexpr int HEADER_SIZE = 56;
+constexpr int DIRECTORY_ENTRY_SIZE = 32;
+constexpr int COLOR_SIZE = 8;
+
+// Header field offsets
+constexpr int H_VERSION = 4;
+constexpr int H_PALETTE_COUNT = 8;
+constexpr int H_DIRECTORY_OFFSET = 12;
+constexpr int H_STRINGS_OFFSET = 16;
+constexpr int H_STRINGS_SIZE = 20;
+constexpr int H_JOURNAL_SEQUENCE = 24;
+constexpr int H_CURRENT_ID_OFFSET = 32;
+constexpr int H_CURRENT_ID_LENGTH = 36;
+constexpr int H_FILE_SIZE = 40;
+constexpr int H_PREVIEW_OFFSET = 48; // version 2
+constexpr int H_PREVIEW_SIZE = 52;   // version 2
+
+// Directory entry field offsets
+constexpr int D_ID_OFFSET = 0;
+constexpr int D_ID_LENGTH = 4;
+constexpr int D_NAME_OFFSET = 8;
+constexpr int D_NAME_LENGTH = 12;
+constexpr int D_COLORS_OFFSET = 16;
+constexpr int D_COLOR_COUNT = 24;
+
+static_assert(sizeof(PackedColor) == COLOR_SIZE, "PackedColor must be 4 x 16 bit");
+
+template <typename T> T readLE(const uchar *data, qint64 offset) {
+  return qFromLittleEndian<T>(data + offset);
+}
+
+template <typename T> void writeLE(char *data, qint64 offset, T value) {
+  qToLittleEndian<T>(value, data + offset);
+}
+
+quint64 alignTo8(quint64 value) { return (value + 7) & ~quint64(7); }
+
+void storeColors(char *dst, const QVector<PackedColor> &colors) {
+  if constexpr (QSysInfo::ByteOrder == QSysInfo::LittleEndian) {
+    std::memcpy(dst, colors.constData(), colors.size() * sizeof(PackedColor));
+  } else {
+    const auto *src = reinterpret_cast<const quint16 *>(colors.constData());
+    for (qsizetype i = 0; i < colors.size() * 4; ++i) {
+      qToLittleEndian<quint16>(src[i], dst + i * 2);
+    }
+  }
+}
+
+void loadColors(PackedColor *dst, const uchar *src, int count) {
+  if constexpr (QSysInfo::ByteOrder == QSysInfo::LittleEndian) {
+    std::memcpy(dst, src, count * sizeof(PackedColor));
+  } else {
+    auto *out = reinterpret_cast<quint16 *>(dst);
+    for (int i = 0; i < count * 4; ++i) {
+      out[i] = qFromLittleEndian<quint16>(src + i * 2);
+    }
+  }
+}
+
+} // namespace
+
+PaletteLibrary::~PaletteLibrary() { close(); }
+
+bool PaletteLibrary::open(const QString &path) {
+  close();
+
+  m_file.setFileName(path);
+  if (!m_file.open(QIODevice::ReadOnly))
+    return false;
+
+  m_size = m_file.size();
+  if (m_size < HEADER_SIZE_V1) {
+    qWarning() << "Palette library" << path << "is truncated";
+    close();
+    return false;
+  }
+
+  m_data = m_file.map(0, m_size);
+  if (!m_data) {
+    qWarning() << "Failed to map palette library" << path << ":"
+               << m_file.errorString();
+    close();
+    return false;
+  }
+
+  m_paletteCount = static_cast<int>(readLE<quint32>(m_data, H_PALETTE_COUNT));
+  m_directoryOffset = readLE<quint32>(m_data, H_DIRECTORY_OFFSET);
+  m_stringTableOffset = readLE<quint32>(m_data, H_STRINGS_OFFSET);
+  m_stringTableSize = readLE<quint32>(m_data, H_STRINGS_SIZE);
+  m_previewOffset = 0;
+  if (readLE<quint16>(m_data, H_VERSION) >= 2 && m_size >= HEADER_SIZE) {
+    m_previewOffset = readLE<quint32>(m_data, H_PREVIEW_OFFSET);
+  }
+
+  if (!validate()) {
+    qWarning() << "Palette library" << path << "is corrupt or unsupported";
+    close();
+    return false;
+  }
+  return true;
+}
+
+void PaletteLibrary::close() {
+  if (m_data) {
+    m_file.unmap(const_cast<uchar *>(m_data));
+    m_data = nullptr;
+  }
+  if (m_file.isOpen()) {
+    m_file.close();
+  }
+  m_size = 0;
+  m_paletteCount = 0;
+}
+
+bool PaletteLibrary::validate() const {
+  if (std::memcmp(m_data, MAGIC, sizeof(MAGIC)) != 0)
+    return false;
+  const quint16 version = readLE<quint16>(m_data, H_VERSION);
+  if (version < 1 || version > FORMAT_VERSION)
+    return false;
+  if (readLE<quint64>(m_data, H_FILE_SIZE) != quint64(m_size))
+    return false;
+  if (m_paletteCount < 0)
+    return false;
+
+  const quint64 directoryEnd =
+      quint64(m_directoryOffset) + quint64(m_paletteCount) * DIRECTORY_ENTRY_SIZE;
+  const quint64 stringsEnd = quint64(m_stringTableOffset) + m_stringTableSize;
+  if (directoryEnd > quint64(m_size) || stringsEnd > quint64(m_size))
+    return false;
+
+  if (version >= 2) {
+    if (m_size < HEADER_SIZE ||
+        readLE<quint32>(m_data, H_PREVIEW_SIZE) != PREVIEW_SIZE)
+      return false;
+    const quint64 previewEnd = quint64(m_previewOffset) +
+                               quint64(m_paletteCount) * PREVIEW_SIZE * COLOR_SIZE;
+    if (previewEnd > quint64(m_size))
+      return false;
+  }
+
+  auto stringFits = [this](quint32 offset, quint32 length) {
+    return quint64(offset) + length <= m_stringTableSize;
+  };
+
+  if (!stringFits(readLE<quint32>(m_data, H_CURRENT_ID_OFFSET),
+                  readLE<quint32>(m_data, H_CURRENT_ID_LENGTH)))
+    return false;
+
+  // Check every directory entry once so later reads need no bounds checks
+  for (int i = 0; i < m_paletteCount; ++i) {
+    const uchar *entry = directoryEntry(i);
+    if (!stringFits(readLE<quint32>(entry, D_ID_OFFSET),
+                    readLE<quint32>(entry, D_ID_LENGTH)) ||
+        !stringFits(readLE<quint32>(entry, D_NAME_OFFSET),
+                    readLE<quint32>(entry, D_NAME_LENGTH)))
+      return false;
+
+    const quint64 colorsOffset = readLE<quint64>(entry, D_COLORS_OFFSET);
+    const quint64 colorCount = readLE<quint32>(entry, D_COLOR_COUNT);
+    if (colorsOffset > quint64(m_size) ||
+        colorCount * COLOR_SIZE > quint64(m_size) - colorsOffset)
+      return false;
+  }
+  return true;
+}
+
+const uchar *PaletteLibrary::directoryEntry(int index) const {
+  return m_data + m_directoryOffset + qint64(index) * DIRECTORY_ENTRY_SIZE;
+}
+
+QString PaletteLibrary::string(quint32 offset, quint32 length) const {
+  return QString::fromUtf8(
+      reinterpret_cast<const char *>(m_data + m_stringTableOffset + offset),
+      length);
+}
+
+QString PaletteLibrary::paletteId(int index) const {
+  if (index < 0 || index >= m_paletteCount)
+    return QString();
+  const uchar *entry = directoryEntry(index);
+  return string(readLE<quint32>(entry, D_ID_OFFSET),
+                readLE<quint32>(entry, D_ID_LENGTH));
+}
+
+QString PaletteLibrary::paletteName(int index) const {
+  if (index < 0 || index >= m_paletteCount)
+    return QString();
+  const uchar *entry = directoryEntry(index);
+  return string(readLE<quint32>(entry, D_NAME_OFFSET),
+                readLE<quint32>(entry, D_NAME_LENGTH));
+}
+
+int PaletteLibrary::colorCount(int index) const {
+  if (index < 0 || index >= m_paletteCount)
+    return 0;
+  return static_cast<int>(readLE<quint32>(directoryEntry(index), D_COLOR_COUNT));
+}
+
+QVector<PackedColor> PaletteLibrary::colors(int index) const {
+  QVector<PackedColor> result;
+  const int count = colorCount(index);
+  if (count == 0)
+    return result;
+
+  result.resize(count);
+  const quint64 offset = readLE<quint64>(directoryEntry(index), D_COLORS_OFFSET);
+  loadColors(result.data(), m_data + offset, count);
+  return result;
+}
+
+QVector<PackedColor> PaletteLibrary::preview(int index) const {
+  QVector<PackedColor> result;
+  const int count = qMin(colorCount(index), int(PREVIEW_SIZE));
+  if (count == 0)
+    return result;
+
+  // Version 1 files have no preview block; sample the color array instead
+  if (m_previewOffset == 0)
+    return samplePreview(colors(index));
+
+  result.resize(count);
+  loadColors(result.data(),
+             m_data + m_previewOffset +
+                 qint64(index) * PREVIEW_SIZE * COLOR_SIZE,
+             count);
+  return result;
+}
+
+QVector<PackedColor>
+PaletteLibrary::samplePreview(const QVector<PackedColor> &colors) {
+  const qsizetype count = qMin(colors.size(), qsizetype(PREVIEW_SIZE));
+  QVector<PackedColor> result;
+  result.reserve(count);
+  for (qsizetype i = 0; i < count; ++i) {
+    result.append(colors[i * colors.size() / count]);
+  }
+  return result;
+}
+
+QString PaletteLibrary::currentPaletteId() const {
+  if (!m_data)
+    return QString();
+  return string(readLE<quint32>(m_data, H_CURRENT_ID_OFFSET),
+                readLE<quint32>(m_data, H_CURRENT_ID_LENGTH));
+}
+
+quint64 PaletteLibrary::journalSequence() const {
+  return m_data ? readLE<quint64>(m_data, H_JOURNAL_SEQUENCE) : 0;
+}
+
+bool PaletteLibrary::write(const Snapshot &snapshot, const QString &path) {
+  const int count = snapshot.palettes.size();
+
+  // String table first, so the directory can point into it
+  QByteArray strings;
+  struct StringRef {
+    quint32 offset;
+    quint32 length;
+  };
+  auto addString = [&strings](const QString &text) {
+    const QByteArray utf8 = text.toUtf8();
+    const StringRef ref{quint32(strings.size()), quint32(utf8.size())};
+    strings.append(utf8);
+    return ref;
+  };
+
+  const StringRef currentId = addString(snapshot.currentPaletteId);
+
+  QVector<StringRef> ids;
+  QVector<StringRef> names;
+  ids.reserve(count);
+  names.reserve(count);
+
+  quint64 colorBytes = 0;
+  for (const PaletteData &palette : snapshot.palettes) {
+    ids.append(addString(palette.id));
+    names.append(addString(palette.name));
+    colorBytes += quint64(palette.colors.size()) * COLOR_SIZE;
+  }
+
+  const quint64 directoryOffset = HEADER_SIZE;
+  const quint64 previewOffset =
+      alignTo8(directoryOffset + quint64(count) * DIRECTORY_ENTRY_SIZE);
+  const quint64 colorsOffset =
+      previewOffset + quint64(count) * PREVIEW_SIZE * COLOR_SIZE;
+  const quint64 stringsOffset = colorsOffset + colorBytes;
+  const quint64 fileSize = stringsOffset + quint64(strings.size());
+  if (stringsOffset > std::numeric_limits<quint32>::max() ||
+      quint64(strings.size()) > std::numeric_limits<quint32>::max()) {
+    qWarning() << "Palette library too large to write";
+    return false;
+  }
+
+  // The whole file is rendered into one buffer and written once
+  QByteArray buffer(qsizetype(fileSize), '\0');
+  char *data = buffer.data();
+
+  quint64 nextColors = colorsOffset;
+  for (int i = 0; i < count; ++i) {
+    const PaletteData &palette = snapshot.palettes[i];
+    char *entry = data + directoryOffset + qint64(i) * DIRECTORY_ENTRY_SIZE;
+
+    writeLE<quint32>(entry, D_ID_OFFSET, ids[i].offset);
+    writeLE<quint32>(entry, D_ID_LENGTH, ids[i].length);
+    writeLE<quint32>(entry, D_NAME_OFFSET, names[i].offset);
+    writeLE<quint32>(entry, D_NAME_LENGTH, names[i].length);
+    writeLE<quint64>(entry, D_COLORS_OFFSET, nextColors);
+    writeLE<quint32>(entry, D_COLOR_COUNT, quint32(palette.colors.size()));
+
+    storeColors(data + nextColors, palette.colors);
+    nextColors += quint64(palette.colors.size()) * COLOR_SIZE;
+
+    storeColors(data + previewOffset + qint64(i) * PREVIEW_SIZE * COLOR_SIZE,
+                samplePreview(palette.colors));
+  }
+
+  std::memcpy(data + stringsOffset, strings.constData(), strings.size());
+
+  std::memcpy(data, MAGIC, sizeof(MAGIC));
+  writeLE<quint16>(data, H_VERSION, FORMAT_VERSION);
+  writeLE<quint32>(data, H_PALETTE_COUNT, quint32(count));
+  writeLE<quint32>(data, H_DIRECTORY_OFFSET, quint32(directoryOffset));
+  writeLE<quint32>(data, H_STRINGS_OFFSET, quint32(stringsOffset));
+  writeLE<quint32>(data, H_STRINGS_SIZE, quint32(strings.size()));
+  writeLE<quint64>(data, H_JOURNAL_SEQUENCE, snapshot.journalSequence);
+  writeLE<quint32>(data, H_CURRENT_ID_OFFSET, currentId.offset);
+  writeLE<quint32>(data, H_CURRENT_ID_LENGTH, currentId.length);
+  writeLE<quint64>(data, H_FILE_SIZE, fileSize);
+  writeLE<quint32>(data, H_PREVIEW_OFFSET, quint32(previewOffset));
+  writeLE<quint32>(data, H_PREVIEW_SIZE, PREVIEW_SIZE);
+
+  QDir().mkpath(QFileInfo(path).absolutePath());
+
+  // QSaveFile writes to a temporary file and renames it on commit, so a
+  // crash mid-write leaves the previous library intact
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qWarning() << "Failed to open" << path << "for writing:" << file.errorString();
+    return false;
+  }
+
+  file.write(buffer);
+  if (!file.commit()) {
+    qWarning() << "Failed to save palette library:" << file.errorString();
+    return false;
+  }
+  return true;
+}
+
+bool PaletteLibrary::readJson(const QString &path, Snapshot *snapshot) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+
+  const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+  file.close();
+
+  if (!doc.isObject())
+    return false;
+
+  const QJsonObject root = doc.object();
+  snapshot->currentPaletteId = root["currentPaletteId"].toString();
+  snapshot->journalSequence =
+      static_cast<quint64>(root["journalSequence"].toInteger());
+
+  const QJsonArray palettesArray = root["palettes"].toArray();
+  snapshot->palettes.reserve(palettesArray.size());
+
+  for (const QJsonValue &value : palettesArray) {
+    const QJsonObject paletteObj = value.toObject();
+
+    PaletteData palette;
+    palette.id = paletteObj["id"].toString();
+    palette.name = paletteObj["name"].toString();
+
+    const QJsonArray colorsArray = paletteObj["colors"].toArray();
+    palette.colors.reserve(colorsArray.size());
+    for (const QJsonValue &colorValue : colorsArray) {
+      QColor color = ColorLogic::storageStringToColor(colorValue.toString());
+      if (color.isValid()) {
+        palette.colors.append(ColorLogic::toPacked(color));
+      }
+    }
+
+    snapshot->palettes.append(palette);
+  }
+  return true;
+}
+
+bool PaletteLibrary::writeJson(const Snapshot &snapshot, const QString &path) {
+  QJsonArray palettesArray;
+
+  for (const PaletteData &palette : snapshot.palettes) {
+    QJsonObject paletteObj;
+    paletteObj["id"] = palette.id;
+    paletteObj["name"] = palette.name;
+
+    QJsonArray colorsArray;
+    for (const PackedColor &color : palette.colors) {
+      colorsArray.append(ColorLogic::packedToStorageString(color));
+    }
+    paletteObj["colors"] = colorsArray;
+
+    palettesArray.append(paletteObj);
+  }
+
+  QJsonObject root;
+  root["palettes"] = palettesArray;
+  root["currentPaletteId"] = snapshot.currentPaletteId;
+  root["journalSequence"] = static_cast<qint64>(snapshot.journalSequence);
+
+  QDir().mkpath(QFileInfo(path).absolutePath());
+
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qWarning() << "Failed to open" << path << "for writing:" << file.errorString();
+    return false;
+  }
+
+  file.write(QJsonDocument(root).toJson());
+  if (!file.commit()) {
+    qWarning() << "Failed to write" << path << ":" << file.errorString();
+    return false;
+  }
+  return true;
+}
@@ -1,16 +1,119 @@
 #include "../include/PaletteManager.h"
-#include <QDir>
+#include "../include/ColorLogic.h"
+#include "../include/Profiler.h"
+#include "../include/Settings.h"
+#include <QDebug>
 // ReSharper disable once CppUnusedIncludeDirective
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QFutureWatcher>
 #include <QStandardPaths>
+#include <QThreadPool>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+#include <filesystem>
+#include <utility>
+
+namespace {
+// Window in which consecutive edits are coalesced into one journal write;
+// short, since a crash loses whatever is still queued
+constexpr int SAVE_DELAY_MS = 200;
+// Journal size past which it is folded into a fresh snapshot
+constexpr qint64 COMPACTION_THRESHOLD = 256 * 1024;
+// Delay before a failed snapshot is written again
+constexpr int COMPACTION_RETRY_MS = 30 * 1000;
+
+// Fills in the colors captureSnapshot left to be read from the library
+void readLibraryColors(const PaletteLibrary &library,
+                       const QVector<int> &libraryIndices,
+                       PaletteLibrary::Snapshot *snapshot) {
+  for (int i = 0; i < libraryIndices.size(); ++i) {
+    if (libraryIndices[i] >= 0) {
+      snapshot->palettes[i].colors = library.colors(libraryIndices[i]);
+    }
+  }
+}
 
-PaletteManager::PaletteManager() : m_currentPalette(nullptr) {
+// QFile::rename refuses to overwrite; std::filesystem::rename replaces the
+// target in one step, so palettes.lib is always either the old or the new one
+bool replaceFile(const QString &from, const QString &to) {
+  std::error_code error;
+  std::filesystem::rename(std::filesystem::path(from.toStdU16String()),
+                          std::filesystem::path(to.toStdU16String()), error);
+  if (error) {
+    qWarning() << "Failed to replace" << to << ":"
+               << QString::fromStdString(error.message());
+    return false;
+  }
+  return true;
+}
+} // namespace
+
+PaletteManager::PaletteManager()
+    : m_nextHandle(1), m_currentPalette(nullptr), m_recentPalette(nullptr),
+      m_standardPalette(nullptr), m_saveTimer(new QTimer(this)),
+      m_readOnly(false), m_saveThreadPool(new QThreadPool(this)),
+      m_loadThreadPool(new QThreadPool(this)),
+      m_compactionWatcher(new QFutureWatcher<bool>(this)),
+      m_compactionRetryTimer(new QTimer(this)), m_compacting(false),
+      m_compactionPending(false), m_compactionSequence(0),
+      m_savedSequence(0), m_lostSequence(0) {
   // Current palette will be determined during loadPalettes
+
+  m_saveTimer->setSingleShot(true);
+  m_saveTimer->setInterval(SAVE_DELAY_MS);
+  connect(m_saveTimer, &QTimer::timeout, this, &PaletteManager::onSaveTimeout);
+
+  // A single thread keeps background writes in submission order
+  m_saveThreadPool->setMaxThreadCount(1);
+  m_loadThreadPool->setMaxThreadCount(1);
+
+  connect(m_compactionWatcher, &QFutureWatcher<bool>::finished, this,
+          &PaletteManager::onCompactionFinished);
+
+  m_compactionRetryTimer->setSingleShot(true);
+  m_compactionRetryTimer->setInterval(COMPACTION_RETRY_MS);
+  connect(m_compactionRetryTimer, &QTimer::timeout, this,
+          &PaletteManager::compactJournal);
+
+  // Keep the search index in step once it exists. Replaced palettes are
+  // re-indexed as a whole, single-color edits only touch those colors.
+  auto reindex = [this](Palette *palette) {
+    if (m_searchIndex)
+      m_searchIndex->setPaletteColors(palette->handle(), palette->packedColors());
+  };
+  connect(this, &PaletteManager::paletteAdded, this, reindex);
+  connect(this, &PaletteManager::paletteColorsChanged, this, reindex);
+  connect(this, &PaletteManager::colorsInserted, this,
+          [this](Palette *palette, int index, int count) {
+            if (m_searchIndex)
+              m_searchIndex->insertColors(palette->handle(),
+                                          palette->packedColors(), index, count);
+          });
+  connect(this, &PaletteManager::colorsRemoved, this,
+          [this](Palette *palette, int index, int count) {
+            if (m_searchIndex)
+              m_searchIndex->removeColors(palette->handle(), index, count);
+          });
+  connect(this, &PaletteManager::colorMoved, this,
+          [this](Palette *palette, int from, int to) {
+            if (m_searchIndex)
+              m_searchIndex->moveColor(palette->handle(), from, to);
+          });
+  connect(this, &PaletteManager::paletteRemoved, this,
+          [this](PaletteHandle handle) {
+            if (m_searchIndex)
+              m_searchIndex->removePalette(handle);
+          });
 }
 
-PaletteManager::~PaletteManager() { qDeleteAll(m_palettes); }
+PaletteManager::~PaletteManager() {
+  // Loads read from the map, which is gone once m_library is destroyed
+  m_loadThreadPool->waitForDone();
+  m_saveThreadPool->waitForDone();
+  qDeleteAll(m_palettes);
+}
 
 PaletteManager &PaletteManager::instance() {
   static PaletteManager instance;
@@ -20,188 +123,722 @@ PaletteManager &PaletteManager::instance() {
 Palette *PaletteManager::createPalette(const QString &name) {
   Palette *palette = new Palette(name);
   palette->setReadOnly(false);
-  m_palettes.append(palette);
+  insertPalette(palette);
+
+  PaletteJournal::Entry entry;
+  entry.operation = PaletteJournal::CreatePalette;
+  entry.paletteId = palette->id();
+  entry.name = name;
+  journal(entry);
+
   emit paletteAdded(palette);
   return palette;
 }
 
 Palette *PaletteManager::getPalette(const QString &id) const {
-  for (Palette *palette : m_palettes) {
-    if (palette->id() == id) {
-      return palette;
-    }
+  const int slot = m_slotById.value(id, -1);
+  return slot >= 0 ? m_palettes[slot] : nullptr;
+}
+
+Palette *PaletteManager::getPalette(PaletteHandle handle) const {
+  return m_paletteByHandle.value(handle, nullptr);
+}
+
+void PaletteManager::insertPalette(Palette *palette) {
+  palette->m_handle = m_nextHandle++;
+  m_slotById.insert(palette->id(), m_palettes.size());
+  m_paletteByHandle.insert(palette->handle(), palette);
+  m_palettes.append(palette);
+}
+
+Palette *PaletteManager::takePalette(int slot) {
+  Palette *palette = m_palettes[slot];
+  m_palettes.remove(slot);
+  m_slotById.remove(palette->id());
+  m_paletteByHandle.remove(palette->handle());
+  reindexFrom(slot);
+  return palette;
+}
+
+void PaletteManager::reindexFrom(int slot) {
+  for (int i = slot; i < m_palettes.size(); ++i) {
+    m_slotById.insert(m_palettes[i]->id(), i);
   }
-  return nullptr;
 }
 
 void PaletteManager::setCurrentPalette(const QString &id) {
-  Palette *palette = getPalette(id);
-  if (palette && palette != m_currentPalette) {
-    m_currentPalette = palette;
-    emit currentPaletteChanged(palette);
-  }
+  setCurrentPalette(getPalette(id));
 }
 
 void PaletteManager::setCurrentPalette(Palette *palette) {
-  if (palette && palette != m_currentPalette && m_palettes.contains(palette)) {
+  // The pointer may be stale, so it is looked up before it is dereferenced;
+  // handles start at 1
+  if (palette && palette != m_currentPalette &&
+      m_paletteByHandle.key(palette, 0) != 0) {
+    loadColorsAsync(palette);
     m_currentPalette = palette;
+
+    PaletteJournal::Entry entry;
+    entry.operation = PaletteJournal::SelectPalette;
+    entry.paletteId = palette->id();
+    journal(entry);
+
     emit currentPaletteChanged(palette);
   }
 }
 
 bool PaletteManager::deletePalette(const QString &id) {
-  for (int i = 0; i < m_palettes.size(); ++i) {
-    if (m_palettes[i]->id() == id) {
-      Palette *palette = m_palettes[i];
+  const int slot = m_slotById.value(id, -1);
+  if (slot < 0)
+    return false;
 
-      // Don't delete read-only palettes
-      if (palette->isReadOnly()) {
-        return false;
-      }
+  Palette *palette = m_palettes[slot];
 
-      bool wasCurrent = (palette == m_currentPalette);
+  // Don't delete read-only palettes
+  if (palette->isReadOnly()) {
+    return false;
+  }
 
-      m_palettes.remove(i);
-      emit paletteRemoved(id);
-      delete palette;
+  bool wasCurrent = (palette == m_currentPalette);
+  const PaletteHandle handle = palette->handle();
 
-      // Set new current if deleted was current
-      if (wasCurrent) {
-        m_currentPalette = nullptr;
+  takePalette(slot);
 
-        if (!m_palettes.isEmpty()) {
-          // Find first non-readonly palette
-          for (Palette *p : m_palettes) {
-            if (!p->isReadOnly()) {
-              m_currentPalette = p;
-              break;
-            }
-          }
-
-          // If no user palette found, use the first system palette
-          if (!m_currentPalette) {
-            m_currentPalette = m_palettes[0];
-          }
-
-          emit currentPaletteChanged(m_currentPalette);
-        }
+  PaletteJournal::Entry entry;
+  entry.operation = PaletteJournal::DeletePalette;
+  entry.paletteId = id;
+  journal(entry);
+
+  emit paletteRemoved(handle);
+  delete palette;
+
+  // Set new current if deleted was current
+  if (wasCurrent) {
+    m_currentPalette = nullptr;
+    Palette *replacement = nullptr;
+
+    // Find first non-readonly palette
+    for (Palette *p : m_palettes) {
+      if (!p->isReadOnly()) {
+        replacement = p;
+        break;
       }
+    }
 
-      savePalettes();
-      return true;
+    // If no user palette found, use the first system palette
+    if (!replacement && !m_palettes.isEmpty()) {
+      replacement = m_palettes[0];
     }
+
+    // Selecting it loads its colors if they are still in the library, and
+    // journals the selection
+    setCurrentPalette(replacement);
   }
-  return false;
+
+  return true;
 }
 
 bool PaletteManager::renamePalette(const QString &id, const QString &newName) {
   if (Palette *palette = getPalette(id)) {
     palette->setName(newName);
-    emit paletteRenamed(id);
+
+    PaletteJournal::Entry entry;
+    entry.operation = PaletteJournal::RenamePalette;
+    entry.paletteId = id;
+    entry.name = newName;
+    journal(entry);
+
+    emit paletteRenamed(palette->handle());
     return true;
   }
   return false;
 }
 
-void PaletteManager::savePalettes() {
-  QJsonArray palettesArray;
+void PaletteManager::addColor(Palette *palette, const QColor &color) {
+  if (!palette || !color.isValid())
+    return;
 
-  for (const Palette *palette : m_palettes) {
-    // Skip read-only palettes (like standard HTML colors)
-    if (palette->isReadOnly())
-      continue;
+  materialize(palette);
 
-    QJsonObject paletteObj;
-    paletteObj["id"] = palette->id();
-    paletteObj["name"] = palette->name();
+  const PackedColor packed = ColorLogic::toPacked(color);
 
-    QJsonArray colorsArray;
-    for (const QColor &color : palette->colors()) {
-      colorsArray.append(color.name(QColor::HexArgb));
-    }
-    paletteObj["colors"] = colorsArray;
+  PaletteJournal::Entry entry;
+  entry.operation = PaletteJournal::AddColor;
+  entry.paletteId = palette->id();
+  entry.index = palette->colorCount();
+  entry.colors.append(packed);
 
-    palettesArray.append(paletteObj);
-  }
+  emit colorsAboutToBeInserted(palette, entry.index, 1);
+  palette->addPackedColor(packed);
+  emit colorsInserted(palette, entry.index, 1);
 
-  QJsonObject root;
-  root["palettes"] = palettesArray;
-  root["currentPaletteId"] =
-      m_currentPalette ? m_currentPalette->id() : QString();
+  journal(entry);
+}
 
-  const QJsonDocument doc(root);
+void PaletteManager::removeColor(Palette *palette, int index) {
+  materialize(palette);
+  if (!palette || index < 0 || index >= palette->colorCount())
+    return;
 
-  const QString dataPath =
-      QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-  QDir().mkpath(dataPath);
+  emit colorsAboutToBeRemoved(palette, index, 1);
+  palette->removeColor(index);
+
+  emit colorsRemoved(palette, index, 1);
+
+  PaletteJournal::Entry entry;
+  entry.operation = PaletteJournal::RemoveColor;
+  entry.paletteId = palette->id();
+  entry.index = index;
+  journal(entry);
+}
+
+void PaletteManager::moveColor(Palette *palette, int from, int to) {
+  materialize(palette);
+  if (!palette || from == to || from < 0 || to < 0 ||
+      from >= palette->colorCount() || to >= palette->colorCount())
+    return;
+
+  emit colorAboutToBeMoved(palette, from, to);
+  palette->moveColor(from, to);
 
-  if (QFile file(dataPath + "/palettes.json");
-      file.open(QIODevice::WriteOnly)) {
-    file.write(doc.toJson());
-    file.close();
+  emit colorMoved(palette, from, to);
+
+  PaletteJournal::Entry entry;
+  entry.operation = PaletteJournal::MoveColor;
+  entry.paletteId = palette->id();
+  entry.index = from;
+  entry.toIndex = to;
+  journal(entry);
+}
+
+void PaletteManager::setColors(Palette *palette, const QVector<QColor> &colors) {
+  QVector<PackedColor> packed;
+  packed.reserve(colors.size());
+  for (const QColor &color : colors) {
+    if (color.isValid()) {
+      packed.append(ColorLogic::toPacked(color));
+    }
   }
+  setPackedColors(palette, packed);
 }
 
-void PaletteManager::loadPalettes() {
-  // Load recently picked colors palette first (read-only)
-  loadRecentlyPickedColorsPalette();
+void PaletteManager::setPackedColors(Palette *palette,
+                                     const QVector<PackedColor> &colors) {
+  if (!palette)
+    return;
 
-  // Load standard HTML colors palette (read-only)
-  loadStandardHtmlColorsPalette();
+  // Detach from the mapped library so the replaced colors are not reloaded
+  detachFromLibrary(palette);
 
-  const QString dataPath =
-      QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-  QFile file(dataPath + "/palettes.json");
+  PaletteJournal::Entry entry;
+  entry.operation = PaletteJournal::SetColors;
+  entry.paletteId = palette->id();
+  entry.colors = colors;
 
-  if (!file.open(QIODevice::ReadOnly)) {
+  palette->setPackedColors(colors);
+  journal(entry);
+  emit paletteColorsChanged(palette);
+}
+
+void PaletteManager::clearColors(Palette *palette) { setColors(palette, {}); }
+
+void PaletteManager::journal(PaletteJournal::Entry entry) {
+  if (m_readOnly)
     return;
+
+  // Read-only palettes are rebuilt from their own sources on startup
+  if (Palette *palette = getPalette(entry.paletteId);
+      palette && palette->isReadOnly() &&
+      entry.operation != PaletteJournal::SelectPalette)
+    return;
+
+  entry.sequence = m_journal.nextSequence();
+  m_unwrittenEntries.append(entry);
+  scheduleSave();
+}
+
+void PaletteManager::scheduleSave() {
+  // Edits arriving inside the window go out in the same write
+  if (!m_saveTimer->isActive()) {
+    m_saveTimer->start();
   }
+}
 
-  const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-  file.close();
+void PaletteManager::onSaveTimeout() {
+  writeJournal();
 
-  if (!doc.isObject()) {
-    return;
+  if (m_journal.size() > COMPACTION_THRESHOLD) {
+    compactJournal();
   }
+}
 
-  QJsonObject root = doc.object();
-  QJsonArray palettesArray = root["palettes"].toArray();
-  QString currentPaletteId = root["currentPaletteId"].toString();
+void PaletteManager::writeJournal() {
+  if (m_unwrittenEntries.isEmpty())
+    return;
 
-  for (const QJsonValue &value : palettesArray) {
-    QJsonObject paletteObj = value.toObject();
+  // The GUI thread only hands the batch over; serialization and disk I/O
+  // happen on the writer thread, in submission order
+  m_saveThreadPool->start(
+      [this, entries = std::exchange(m_unwrittenEntries, {})]() {
+        if (!m_journal.append(entries)) {
+          m_lostSequence = entries.last().sequence;
+          QMetaObject::invokeMethod(this, &PaletteManager::onJournalWriteFailed,
+                                    Qt::QueuedConnection);
+        }
+      });
+}
 
-    QString id = paletteObj["id"].toString();
-    QString name = paletteObj["name"].toString();
+void PaletteManager::onJournalWriteFailed() {
+  // The edits are in memory only; a full snapshot is the fallback
+  qWarning() << "Palette edits could not be journaled, writing a snapshot";
+  compactJournal();
+}
 
-    Palette *palette = new Palette(name, id);
+void PaletteManager::applyEntry(const PaletteJournal::Entry &entry) {
+  // Replay path: mutate state directly, without journaling or signals
+  Palette *palette = getPalette(entry.paletteId);
+
+  switch (entry.operation) {
+  case PaletteJournal::AddColor:
+  case PaletteJournal::RemoveColor:
+  case PaletteJournal::MoveColor:
+    materialize(palette);
+    break;
+  default:
+    break;
+  }
 
-    QJsonArray colorsArray = paletteObj["colors"].toArray();
-    for (const QJsonValue &colorValue : colorsArray) {
-      QColor color(colorValue.toString());
-      if (color.isValid()) {
-        palette->addColor(color);
+  switch (entry.operation) {
+  case PaletteJournal::CreatePalette:
+    if (!palette) {
+      insertPalette(new Palette(entry.name, entry.paletteId));
+    }
+    break;
+  case PaletteJournal::DeletePalette:
+    if (palette && !palette->isReadOnly()) {
+      if (palette == m_currentPalette) {
+        m_currentPalette = nullptr;
       }
+      delete takePalette(m_slotById.value(entry.paletteId));
+    }
+    break;
+  case PaletteJournal::RenamePalette:
+    if (palette) {
+      palette->setName(entry.name);
+    }
+    break;
+  case PaletteJournal::AddColor:
+    if (palette && !entry.colors.isEmpty()) {
+      palette->insertPackedColor(entry.index < 0 ? palette->colorCount()
+                                                 : entry.index,
+                                 entry.colors.first());
     }
+    break;
+  case PaletteJournal::RemoveColor:
+    if (palette) {
+      palette->removeColor(entry.index);
+    }
+    break;
+  case PaletteJournal::MoveColor:
+    if (palette) {
+      palette->moveColor(entry.index, entry.toIndex);
+    }
+    break;
+  case PaletteJournal::SetColors:
+    if (palette) {
+      detachFromLibrary(palette);
+      palette->setPackedColors(entry.colors);
+    }
+    break;
+  case PaletteJournal::SelectPalette:
+    if (palette) {
+      m_currentPalette = palette;
+    }
+    break;
+  }
+}
 
-    m_palettes.append(palette);
+void PaletteManager::compactJournal() {
+  // One snapshot at a time; a request arriving while one is running or
+  // waiting to be retried is served by the next one
+  if (m_compacting || m_compactionRetryTimer->isActive()) {
+    m_compactionPending = true;
+    return;
   }
+  m_compacting = true;
+  m_compactionPending = false;
+
+  // Queued entries go first so the rotation moves them aside with the rest
+  writeJournal();
+
+  // Palettes still in the library stay there; their colors are copied out
+  // of the map on the writer thread. The map is only replaced once the
+  // snapshot is written, in onCompactionFinished.
+  QVector<int> libraryIndices;
+  PaletteLibrary::Snapshot snapshot = captureSnapshot(&libraryIndices);
+  snapshot.journalSequence = m_journal.lastSequence();
+  m_compactionSequence = snapshot.journalSequence;
+
+  // New edits go to a fresh journal while the old one is folded into the
+  // snapshot; the rotated file is dropped only once the snapshot is
+  // committed. If the journal cannot be rotated its entries stay in place
+  // and are skipped on replay, as the snapshot already contains them.
+  PaletteJournal *journal = &m_journal;
+  const PaletteLibrary *library = &m_library;
+  const QString path = snapshotFilePath();
+  m_compactionWatcher->setFuture(QtConcurrent::run(
+      m_saveThreadPool,
+      [journal, library, libraryIndices, snapshot, path]() mutable {
+        journal->rotate();
+        readLibraryColors(*library, libraryIndices, &snapshot);
+        return PaletteLibrary::write(snapshot, path);
+      }));
+}
 
-  // Restore the last used palette (including system palettes)
-  if (!currentPaletteId.isEmpty()) {
-    for (Palette *palette : m_palettes) {
-      if (palette->id() == currentPaletteId) {
-        m_currentPalette = palette;
-        break;
-      }
+void PaletteManager::onCompactionFinished() {
+  // savePalettes may have handled it already
+  if (!m_compacting)
+    return;
+  m_compacting = false;
+
+  if (!m_compactionWatcher->result() || !replaceLibrary(snapshotFilePath())) {
+    // The rotated journal still holds every entry; the retry folds the
+    // active journal into it and writes a new snapshot
+    qWarning() << "Failed to write palette snapshot, retrying in"
+               << COMPACTION_RETRY_MS / 1000 << "seconds";
+    m_compactionRetryTimer->start();
+    return;
+  }
+
+  m_journal.removeRotated();
+  m_savedSequence = m_compactionSequence;
+
+  if (m_compactionPending) {
+    compactJournal();
+  }
+}
+
+void PaletteManager::savePalettes() {
+  const Profiler::Scope scope("PaletteManager::savePalettes");
+
+  // Every edit is already in memory and queued for the journal, so closing
+  // only has to hand over the last batch and let the writer drain it
+  m_saveTimer->stop();
+  writeJournal();
+  m_saveThreadPool->waitForDone();
+
+  // Nothing would wait for another compaction started now; the journal
+  // already holds whatever it would have folded in
+  m_compactionPending = false;
+  if (m_compacting) {
+    onCompactionFinished();
+  }
+  m_compactionRetryTimer->stop();
+
+  // Edits the journal could not take and no snapshot has covered yet are
+  // written synchronously as a last resort
+  if (m_lostSequence > m_savedSequence) {
+    PaletteLibrary::Snapshot snapshot = captureSnapshot();
+    snapshot.journalSequence = m_journal.lastSequence();
+    if (PaletteLibrary::write(snapshot, snapshotFilePath()) &&
+        replaceLibrary(snapshotFilePath())) {
+      m_journal.clear();
+      m_savedSequence = snapshot.journalSequence;
     }
   }
+}
+
+QVector<PackedColor> PaletteManager::paletteColors(const Palette *palette) const {
+  if (!palette)
+    return {};
+  return palette->isLoaded() ? palette->packedColors()
+                             : m_library.colors(palette->m_libraryIndex);
+}
+
+bool PaletteManager::exportLibraryJson(const QString &path) {
+  PaletteLibrary::Snapshot snapshot = captureSnapshot();
+  snapshot.journalSequence = 0;
+  return PaletteLibrary::writeJson(snapshot, path);
+}
+
+int PaletteManager::importLibraryJson(const QString &path) {
+  PaletteLibrary::Snapshot snapshot;
+  if (!PaletteLibrary::readJson(path, &snapshot))
+    return -1;
+
+  for (const PaletteLibrary::PaletteData &data : snapshot.palettes) {
+    // Fresh ids keep imported palettes from colliding with existing ones
+    Palette *palette = new Palette(data.name);
+    palette->setPackedColors(data.colors);
+    insertPalette(palette);
+
+    PaletteJournal::Entry entry;
+    entry.operation = PaletteJournal::CreatePalette;
+    entry.paletteId = palette->id();
+    entry.name = palette->name();
+    journal(entry);
+
+    entry.operation = PaletteJournal::SetColors;
+    entry.colors = data.colors;
+    journal(entry);
+
+    emit paletteAdded(palette);
+  }
+
+  return snapshot.palettes.size();
+}
+
+QVector<ColorSearchIndex::Match>
+PaletteManager::findSimilarColors(const QColor &color, float radius) {
+  return searchIndex().withinRadius(color, radius);
+}
+
+QVector<ColorSearchIndex::Match>
+PaletteManager::findNearestColors(const QColor &color, int count) {
+  return searchIndex().nearest(color, count);
+}
+
+ColorSearchIndex &PaletteManager::searchIndex() {
+  if (!m_searchIndex) {
+    m_searchIndex = std::make_unique<ColorSearchIndex>();
+
+    // Palettes still in the library are indexed straight from the map
+    // without loading them
+    for (const Palette *palette : std::as_const(m_palettes)) {
+      m_searchIndex->setPaletteColors(
+          palette->handle(), palette->isLoaded()
+                                 ? palette->packedColors()
+                                 : m_library.colors(palette->m_libraryIndex));
+    }
+  }
+  return *m_searchIndex;
+}
+
+void PaletteManager::materialize(Palette *palette) {
+  if (!palette || palette->m_libraryIndex < 0)
+    return;
+
+  palette->setPackedColors(m_library.colors(palette->m_libraryIndex));
+  detachFromLibrary(palette);
+
+  // Views showing the palette still hold the empty, unloaded state
+  emit paletteColorsChanged(palette);
+}
+
+void PaletteManager::detachFromLibrary(Palette *palette) {
+  palette->m_libraryIndex = -1;
+  palette->m_libraryColorCount = 0;
+  palette->m_preview.clear();
+}
+
+void PaletteManager::loadColorsAsync(Palette *palette) {
+  if (!palette || palette->isLoaded() ||
+      m_pendingLoads.contains(palette->handle()))
+    return;
+
+  const PaletteHandle handle = palette->handle();
+  const int index = palette->m_libraryIndex;
+  m_pendingLoads.insert(handle);
+
+  auto *watcher = new QFutureWatcher<QVector<PackedColor>>(this);
+  connect(watcher, &QFutureWatcher<QVector<PackedColor>>::finished, this,
+          [this, watcher, handle]() {
+            watcher->deleteLater();
+            m_pendingLoads.remove(handle);
+
+            // The palette may have been deleted, or materialized by an edit
+            // while the load was running
+            Palette *palette = getPalette(handle);
+            if (!palette || palette->isLoaded())
+              return;
+
+            palette->setPackedColors(watcher->result());
+            detachFromLibrary(palette);
+            emit paletteColorsChanged(palette);
+          });
+
+  const PaletteLibrary *library = &m_library;
+  watcher->setFuture(QtConcurrent::run(
+      m_loadThreadPool, [library, index]() { return library->colors(index); }));
+}
+
+bool PaletteManager::replaceLibrary(const QString &snapshotPath) {
+  PaletteLibrary snapshot;
+  if (!snapshot.open(snapshotPath))
+    return false;
+
+  // Unloaded palettes keep reading from the library, now at their entry in
+  // the snapshot. Every unloaded palette was captured, so a miss is only
+  // possible if the file changed underneath; load those from the old map.
+  QHash<QString, int> indexById;
+  for (int i = 0; i < snapshot.paletteCount(); ++i) {
+    indexById.insert(snapshot.paletteId(i), i);
+  }
+
+  QVector<QPair<Palette *, int>> remapped;
+  for (Palette *palette : std::as_const(m_palettes)) {
+    if (palette->isLoaded())
+      continue;
+
+    if (const int index = indexById.value(palette->id(), -1); index >= 0) {
+      remapped.append({palette, index});
+    } else {
+      materialize(palette);
+    }
+  }
+  snapshot.close();
+
+  // Loads in flight read from the old map. The file is renamed over
+  // palettes.lib only while nothing maps either of them, as Windows refuses
+  // otherwise.
+  m_loadThreadPool->waitForDone();
+  m_library.close();
+
+  const QString path = palettesFilePath();
+  const bool replaced = replaceFile(snapshotPath, path);
+  if (!m_library.open(path)) {
+    qWarning() << "Failed to reopen palette library" << path;
+  }
+  if (!replaced)
+    return false;
+
+  for (const auto &[palette, index] : std::as_const(remapped)) {
+    palette->m_libraryIndex = index;
+  }
+  return true;
+}
+
+PaletteLibrary::Snapshot PaletteManager::captureSnapshot() const {
+  QVector<int> libraryIndices;
+  PaletteLibrary::Snapshot snapshot = captureSnapshot(&libraryIndices);
+
+  // Palettes not materialized yet are copied straight out of the map
+  readLibraryColors(m_library, libraryIndices, &snapshot);
+  return snapshot;
+}
+
+PaletteLibrary::Snapshot
+PaletteManager::captureSnapshot(QVector<int> *libraryIndices) const {
+  PaletteLibrary::Snapshot snapshot;
+  snapshot.currentPaletteId =
+      m_currentPalette ? m_currentPalette->id() : QString();
+
+  for (const Palette *palette : m_palettes) {
+    // Skip read-only palettes (like standard HTML colors)
+    if (palette->isReadOnly())
+      continue;
+
+    // Color vectors are implicitly shared, so this copies no color data
+    snapshot.palettes.append(
+        {palette->id(), palette->name(), palette->packedColors()});
+    libraryIndices->append(palette->m_libraryIndex);
+  }
+
+  return snapshot;
+}
+
+QString PaletteManager::palettesFilePath() {
+  return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) +
+         "/palettes.lib";
+}
+
+QString PaletteManager::snapshotFilePath() {
+  return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) +
+         "/palettes.lib.new";
+}
+
+QString PaletteManager::legacyPalettesFilePath() {
+  return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) +
+         "/palettes.json";
+}
+
+QString PaletteManager::journalFilePath() {
+  return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) +
+         "/palettes.journal";
+}
+
+void PaletteManager::loadPalettes(LoadMode mode) {
+  const Profiler::Scope scope("PaletteManager::loadPalettes");
+  m_readOnly = mode == LoadMode::ReadOnly;
+
+  // Load recently picked colors palette first (read-only). Opening its store
+  // may migrate or rewrite it, and it is not part of a snapshot anyway.
+  if (!m_readOnly) {
+    loadRecentlyPickedColorsPalette();
+  }
+
+  // Standard HTML colors palette (read-only); its colors are parsed after
+  // the window is shown
+  loadStandardHtmlColorsPalette();
+
+  QString currentPaletteId;
+  quint64 snapshotSequence = 0;
+  bool migrated = false;
+
+  if (m_library.open(palettesFilePath())) {
+    // Only the directory is read here; colors stay in the map until the
+    // palette is selected
+    currentPaletteId = m_library.currentPaletteId();
+    snapshotSequence = m_library.journalSequence();
+
+    for (int i = 0; i < m_library.paletteCount(); ++i) {
+      const QString id = m_library.paletteId(i);
+
+      // Skip entries whose id is already taken
+      if (m_slotById.contains(id))
+        continue;
+
+      Palette *palette = new Palette(m_library.paletteName(i), id);
+      palette->m_libraryIndex = i;
+      palette->m_libraryColorCount = m_library.colorCount(i);
+      palette->m_preview = m_library.preview(i);
+      insertPalette(palette);
+    }
+  } else if (PaletteLibrary::Snapshot snapshot;
+             PaletteLibrary::readJson(legacyPalettesFilePath(), &snapshot)) {
+    // Migrate palettes.json; the next snapshot is written as palettes.lib
+    currentPaletteId = snapshot.currentPaletteId;
+    snapshotSequence = snapshot.journalSequence;
+    migrated = true;
+
+    for (const PaletteLibrary::PaletteData &data : snapshot.palettes) {
+      // Skip entries whose id is already taken (e.g. a hand-edited file)
+      if (m_slotById.contains(data.id))
+        continue;
+
+      Palette *palette = new Palette(data.name, data.id);
+      palette->setPackedColors(data.colors);
+      insertPalette(palette);
+    }
+  }
+
+  if (!currentPaletteId.isEmpty()) {
+    m_currentPalette = getPalette(currentPaletteId);
+  }
+
+  // Replay edits made after the snapshot was written. Sequences only grow
+  // through the rotated and the active journal, so anything not newer than
+  // the last applied entry is either in the snapshot or a second copy left
+  // by a crash while the journal was being rotated.
+  if (!m_readOnly) {
+    m_journal.open(journalFilePath());
+  }
+  quint64 lastSequence = snapshotSequence;
+  for (const PaletteJournal::Entry &entry :
+       PaletteJournal::readEntries(journalFilePath())) {
+    if (entry.sequence <= lastSequence)
+      continue;
+    applyEntry(entry);
+    lastSequence = entry.sequence;
+  }
+  m_journal.setLastSequence(lastSequence);
+  m_savedSequence = snapshotSequence;
 
   // If no current palette was restored, set a default
   if (!m_currentPalette) {
-    if (Palette *recentPalette = getPalette(RECENTLY_PICKED_PALETTE_ID)) {
+    if (m_recentPalette) {
       // Prefer FIFO recent palette when user previously had no selection
-      m_currentPalette = recentPalette;
+      m_currentPalette = m_recentPalette;
     } else {
       // Prefer the first non-read-only palette, fall back to the first
       // available
@@ -217,9 +854,41 @@ void PaletteManager::loadPalettes() {
       }
     }
   }
+
+  if (m_readOnly)
+    return;
+
+  // Colors of the current palette arrive after the window is shown
+  loadColorsAsync(m_currentPalette);
+
+  // A rotated journal left behind by an interrupted compaction, or palettes
+  // migrated from palettes.json, are folded into a new snapshot in the
+  // background
+  if (migrated || m_journal.hasRotated()) {
+    compactJournal();
+  }
+}
+
+void PaletteManager::loadDeferredPalettes() {
+  const Profiler::Scope scope("PaletteManager::loadDeferredPalettes");
+
+  if (m_standardPalette && m_standardPalette->colorCount() == 0) {
+    loadStandardHtmlColors();
+    emit paletteColorsChanged(m_standardPalette);
+  }
 }
 
 void PaletteManager::loadStandardHtmlColorsPalette() {
+  // Create a read-only palette with fixed ID; it is inserted right away so
+  // it keeps its place and can be restored as the current palette
+  m_standardPalette =
+      new Palette(tr("Standard HTML Colors"), "standard-html-colors", true);
+
+  // second palette, after the recently picked one
+  insertPalette(m_standardPalette);
+}
+
+void PaletteManager::loadStandardHtmlColors() {
   // Load standard HTML colors from JSON file
   QFile file(":/standard-html-colors.json");
 
@@ -236,10 +905,6 @@ void PaletteManager::loadStandardHtmlColorsPalette() {
     return;
   }
 
-  // Create a read-only palette with fixed ID
-  Palette *standardPalette =
-      new Palette(tr("Standard HTML Colors"), "standard-html-colors", true);
-
   QJsonArray colorsArray = doc.array();
   for (const QJsonValue &value : colorsArray) {
     QJsonObject colorObj = value.toObject();
@@ -247,12 +912,9 @@ void PaletteManager::loadStandardHtmlColorsPalette() {
     QString colorName = colorObj["name"].toString();
 
     if (QColor color(hexColor); color.isValid()) {
-      standardPalette->addColor(color, colorName);
+      m_standardPalette->addColor(color, colorName);
     }
   }
-
-  // first palette
-  m_palettes.append(standardPalette);
 }
 
 void PaletteManager::loadRecentlyPickedColorsPalette() {
@@ -260,92 +922,49 @@ void PaletteManager::loadRecentlyPickedColorsPalette() {
   Palette *recentPalette =
       new Palette(tr("Recently Picked"), RECENTLY_PICKED_PALETTE_ID, true);
 
-  // Load recent colors from settings
-  QString dataPath =
+  // recent-colors.json from older versions is migrated on first open
+  const QString dataPath =
       QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-  QFile file(dataPath + "/recent-colors.json");
-
-  if (file.open(QIODevice::ReadOnly)) {
-    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-    file.close();
-
-    if (doc.isArray()) {
-      QJsonArray colorsArray = doc.array();
-      for (const QJsonValue &colorValue : colorsArray) {
-        QString hexColor = colorValue.toString();
-        QColor color(hexColor);
-        if (color.isValid()) {
-          recentPalette->addColor(color);
-        }
-      }
-    }
-  }
+  m_recentColors.open(dataPath + "/recent-colors.bin",
+                      Settings::Manager::instance().getRecentColorsCapacity(
+                          RecentColorsStore::DEFAULT_CAPACITY),
+                      dataPath + "/recent-colors.json");
+  recentPalette->setPackedColors(m_recentColors.colors());
 
   // first palette
-  m_palettes.prepend(recentPalette);
+  insertPalette(recentPalette);
+  m_recentPalette = recentPalette;
 }
 
 void PaletteManager::addToRecentColors(const QColor &color) {
   if (!color.isValid())
     return;
 
-  // Find the recently picked palette
-  Palette *recentPalette = nullptr;
-  for (Palette *palette : m_palettes) {
-    if (palette->id() == RECENTLY_PICKED_PALETTE_ID) {
-      recentPalette = palette;
-      break;
-    }
-  }
-
+  Palette *recentPalette = m_recentPalette;
   if (!recentPalette)
     return;
 
-  // Remove the color if it already exists (to move it to the front)
-  QVector<QColor> colors = recentPalette->colors();
-  for (int i = 0; i < colors.size(); ++i) {
-    if (colors[i] == color) {
-      recentPalette->removeColor(i);
-      break;
+  const PackedColor packed = ColorLogic::toPacked(color);
+
+  // The store moves the color to the front and persists the one record it
+  // changed, and reports where the color was; the palette mirrors the same
+  // move without searching or rebuilding. Its colors are a QVector, so the
+  // mirror still shifts the colors ahead of the moved one.
+  const int previous = m_recentColors.touch(packed);
+  if (previous < 0) {
+    emit colorsAboutToBeInserted(recentPalette, 0, 1);
+    recentPalette->insertPackedColor(0, packed);
+    emit colorsInserted(recentPalette, 0, 1);
+
+    if (const int last = recentPalette->colorCount() - 1;
+        last >= m_recentColors.capacity()) {
+      emit colorsAboutToBeRemoved(recentPalette, last, 1);
+      recentPalette->removeColor(last);
+      emit colorsRemoved(recentPalette, last, 1);
     }
+  } else if (previous > 0 && previous < recentPalette->colorCount()) {
+    emit colorAboutToBeMoved(recentPalette, previous, 0);
+    recentPalette->moveColor(previous, 0);
+    emit colorMoved(recentPalette, previous, 0);
   }
-
-  // Get current colors
-  colors = recentPalette->colors();
-
-  // Add new color at the beginning
-  QVector<QColor> newColors;
-  newColors.append(color);
-  for (const QColor &c : colors) {
-    newColors.append(c);
-  }
-
-  // Limit to 24 colors (FIFO)
-  const int maxRecentColors = 24;
-  if (newColors.size() > maxRecentColors) {
-    newColors.resize(maxRecentColors);
-  }
-
-  // Update palette
-  recentPalette->setColors(newColors);
-
-  // Save recent colors to file
-  QString dataPath =
-      QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-  QDir().mkpath(dataPath);
-
-  QJsonArray colorsArray;
-  for (const QColor &c : newColors) {
-    colorsArray.append(c.name(QColor::HexArgb));
-  }
-
-  QJsonDocument doc(colorsArray);
-  QFile file(dataPath + "/recent-colors.json");
-  if (file.open(QIODevice::WriteOnly)) {
-    file.write(doc.toJson());
-    file.close();
-  }
-
-  // Notify that colors changed
-  emit paletteColorsChanged(recentPalette);
 }
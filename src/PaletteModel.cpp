@@ -0,0 +1,82 @@
+#include "../include/PaletteModel.h"
+#include "../include/ColorLogic.h"
+#include "../include/Palette.h"
+#include "../include/PaletteManager.h"
+
+PaletteModel::PaletteModel(QObject *parent)
+    : QAbstractListModel(parent), m_palette(nullptr) {
+  // Single-color edits become row operations, so views touch only the rows
+  // involved instead of resetting
+  const PaletteManager *manager = &PaletteManager::instance();
+  connect(manager, &PaletteManager::colorsAboutToBeInserted, this,
+          [this](Palette *palette, int index, int count) {
+            if (palette == m_palette)
+              beginInsertRows(QModelIndex(), index, index + count - 1);
+          });
+  connect(manager, &PaletteManager::colorsInserted, this,
+          [this](Palette *palette) {
+            if (palette == m_palette)
+              endInsertRows();
+          });
+  connect(manager, &PaletteManager::colorsAboutToBeRemoved, this,
+          [this](Palette *palette, int index, int count) {
+            if (palette == m_palette)
+              beginRemoveRows(QModelIndex(), index, index + count - 1);
+          });
+  connect(manager, &PaletteManager::colorsRemoved, this,
+          [this](Palette *palette) {
+            if (palette == m_palette)
+              endRemoveRows();
+          });
+  connect(manager, &PaletteManager::colorAboutToBeMoved, this,
+          [this](Palette *palette, int from, int to) {
+            // Qt counts the destination before the move
+            if (palette == m_palette)
+              beginMoveRows(QModelIndex(), from, from, QModelIndex(),
+                            to > from ? to + 1 : to);
+          });
+  connect(manager, &PaletteManager::colorMoved, this,
+          [this](Palette *palette) {
+            if (palette == m_palette)
+              endMoveRows();
+          });
+}
+
+void PaletteModel::setPalette(Palette *palette) {
+  beginResetModel();
+  m_palette = palette;
+  endResetModel();
+}
+
+int PaletteModel::rowCount(const QModelIndex &parent) const {
+  if (parent.isValid() || !m_palette)
+    return 0;
+  // Rows appear once the colors are loaded; colorCount() is known earlier
+  return m_palette->packedColors().size();
+}
+
+QVariant PaletteModel::data(const QModelIndex &index, int role) const {
+  if (!m_palette || !index.isValid() ||
+      index.row() >= m_palette->packedColors().size())
+    return QVariant();
+
+  const PackedColor &color = m_palette->packedColors()[index.row()];
+
+  switch (role) {
+  case Qt::DecorationRole:
+    return ColorLogic::fromPacked(color);
+  case Qt::DisplayRole:
+    return ColorLogic::packedToStorageString(color);
+  case Qt::ToolTipRole: {
+    // Color name (if any) above the color value
+    const QString colorText = ColorLogic::packedToStorageString(color);
+    const QStringView name = m_palette->colorName(index.row());
+    return name.isEmpty() ? colorText
+                          : QString("%1\n%2").arg(name.toString(), colorText);
+  }
+  case ColorNameRole:
+    return m_palette->colorName(index.row()).toString();
+  default:
+    return QVariant();
+  }
+}
@@ -1,97 +1,95 @@
 #include "../include/PaletteWidget.h"
+#include "../include/Checkerboard.h"
+#include "../include/ColorDifference.h"
 #include "../include/ColorExtractor.h"
+#include "../include/ColorLogic.h"
 #include "../include/Palette.h"
+#include "../include/PaletteExporter.h"
+#include "../include/PaletteImporter.h"
 #include "../include/PaletteManager.h"
+#include "../include/PaletteModel.h"
+#include "../include/Profiler.h"
 
 #include <QApplication>
 #include <QClipboard>
 #include <QComboBox>
 #include <QFileDialog>
-#include <QGridLayout>
+#include <QFileInfo>
 #include <QHBoxLayout>
+#include <QIcon>
 #include <QImage>
 #include <QInputDialog>
 #include <QLabel>
+#include <QListView>
 #include <QMainWindow>
 #include <QMenu>
 #include <QMessageBox>
 #include <QMouseEvent>
 #include <QPainter>
-#include <QScrollArea>
+#include <QPixmap>
+#include <QProgressDialog>
 #include <QStatusBar>
-#include <QTextStream>
 #include <QTimer>
 #include <QToolButton>
 
-// ColorSwatch implementations
-ColorSwatch::ColorSwatch(const QColor &color, QWidget *parent, bool readOnly,
-                         const QString &colorName)
-    : QWidget(parent), m_color(color), m_colorName(colorName),
-      m_readOnly(readOnly) {
-  setFixedSize(SWATCH_SIZE, SWATCH_SIZE);
-  setCursor(Qt::PointingHandCursor);
+namespace {
 
-  // Create tooltip with color name and hex value
-  QString tooltip;
-  if (!m_colorName.isEmpty()) {
-    tooltip = QString("%1\n%2").arg(m_colorName, color.name(QColor::HexArgb));
-  } else {
-    tooltip = color.name(QColor::HexArgb);
-  }
-  setToolTip(tooltip);
-}
+// Small strip of the palette's preview colors for the palette combo box
+QIcon previewIcon(const Palette *palette) {
+  constexpr int width = 32;
+  constexpr int height = 12;
 
-void ColorSwatch::paintEvent(QPaintEvent *event) {
-  Q_UNUSED(event);
-  QPainter painter(this);
-  painter.setRenderHint(QPainter::Antialiasing);
+  QPixmap pixmap(width, height);
+  pixmap.fill(Qt::transparent);
 
-  // Draw checkered background for transparency
-  painter.fillRect(rect(), Qt::white);
-  int checkerSize = 5;
-  for (int y = 0; y < height(); y += checkerSize) {
-    for (int x = 0; x < width(); x += checkerSize) {
-      if ((x / checkerSize + y / checkerSize) % 2 == 0) {
-        painter.fillRect(x, y, checkerSize, checkerSize, QColor(204, 204, 204));
-      }
+  const QVector<PackedColor> preview = palette->preview();
+  if (!preview.isEmpty()) {
+    QPainter painter(&pixmap);
+    for (int i = 0; i < preview.size(); ++i) {
+      const int x0 = i * width / preview.size();
+      const int x1 = (i + 1) * width / preview.size();
+      painter.fillRect(x0, 0, x1 - x0, height,
+                       ColorLogic::fromPacked(preview[i]));
     }
+    painter.setPen(QColor(136, 136, 136));
+    painter.drawRect(0, 0, width - 1, height - 1);
   }
 
-  // Draw color
-  painter.fillRect(rect(), m_color);
-
-  // Draw border
-  painter.setPen(QPen(QColor(136, 136, 136), 1));
-  painter.drawRect(rect().adjusted(0, 0, -1, -1));
+  return QIcon(pixmap);
 }
 
-void ColorSwatch::mousePressEvent(QMouseEvent *event) {
-  if (event->button() == Qt::LeftButton) {
-    emit clicked();
-  }
-  QWidget::mousePressEvent(event);
-}
+} // namespace
 
-void ColorSwatch::contextMenuEvent(QContextMenuEvent *event) {
-  QMenu menu(this);
+// SwatchDelegate implementation
+SwatchDelegate::SwatchDelegate(QObject *parent) : QStyledItemDelegate(parent) {}
 
-  // Add copy action (available for all swatches)
-  const QAction *copyAction = menu.addAction(tr("Copy HEX"));
+void SwatchDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
+                           const QModelIndex &index) const {
+  const QRect rect = option.rect;
+  const QColor color = index.data(Qt::DecorationRole).value<QColor>();
 
-  // Add remove action only for editable swatches
-  const QAction *removeAction = nullptr;
-  if (!m_readOnly) {
-    menu.addSeparator();
-    removeAction = menu.addAction(tr("Remove"));
-  }
+  painter->save();
 
-  if (const QAction *selected = menu.exec(event->globalPos()); selected == copyAction) {
-    // Copy color code to clipboard
-    QClipboard *clipboard = QApplication::clipboard();
-    clipboard->setText(m_color.name(QColor::HexArgb));
-  } else if (selected == removeAction) {
-    emit removeRequested();
-  }
+  // Draw checkered background for transparency
+  Checkerboard::paint(painter, rect, 5);
+
+  // Draw color
+  painter->fillRect(rect, color);
+
+  // Draw border, darker under the mouse
+  const bool hovered = option.state & QStyle::State_MouseOver;
+  painter->setPen(
+      QPen(hovered ? QColor(60, 60, 60) : QColor(136, 136, 136), 1));
+  painter->drawRect(rect.adjusted(0, 0, -1, -1));
+
+  painter->restore();
+}
+
+QSize SwatchDelegate::sizeHint(const QStyleOptionViewItem &option,
+                               const QModelIndex &index) const {
+  Q_UNUSED(option);
+  Q_UNUSED(index);
+  return QSize(SWATCH_SIZE, SWATCH_SIZE);
 }
 
 // AddColorSwatch implementation
@@ -150,6 +148,7 @@ PaletteWidget::PaletteWidget(QWidget *parent)
     : QWidget(parent), m_currentPalette(nullptr), m_newPaletteAction(nullptr),
       m_renamePaletteAction(nullptr), m_deletePaletteAction(nullptr),
       m_generateFromImageAction(nullptr), m_clearPaletteAction(nullptr),
+      m_removeDuplicatesAction(nullptr), m_comparePaletteAction(nullptr),
       m_exportPaletteAction(nullptr), m_importPaletteAction(nullptr) {
   setupUI();
 
@@ -160,7 +159,7 @@ PaletteWidget::PaletteWidget(QWidget *parent)
             // and this is the recently picked palette (handle initialization case)
             bool shouldRefresh = (palette == m_currentPalette) ||
                                 (!m_currentPalette && palette &&
-                                 palette->id() == PaletteManager::RECENTLY_PICKED_PALETTE_ID);
+                                 palette == PaletteManager::instance().recentPalette());
 
             if (shouldRefresh) {
               // If m_currentPalette is null, set it to this palette
@@ -195,6 +194,7 @@ void PaletteWidget::setupUI() {
   m_paletteCombo = new QComboBox(m_headerFrame);
   m_paletteCombo->setSizeAdjustPolicy(QComboBox::AdjustToContents);
   m_paletteCombo->setMinimumWidth(100);
+  m_paletteCombo->setIconSize(QSize(32, 12));
   connect(m_paletteCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
           this, &PaletteWidget::onPaletteSelected);
   headerLayout->addWidget(m_paletteCombo);
@@ -236,11 +236,21 @@ void PaletteWidget::setupUI() {
   menu->addSeparator();
   m_clearPaletteAction = menu->addAction(tr("Clear Palette"), this,
                                          &PaletteWidget::onClearPalette);
+  m_removeDuplicatesAction =
+      menu->addAction(tr("Remove Near Duplicates..."), this,
+                      &PaletteWidget::onRemoveNearDuplicates);
+  m_comparePaletteAction = menu->addAction(tr("Compare with Palette..."), this,
+                                           &PaletteWidget::onComparePalette);
   menu->addSeparator();
   m_exportPaletteAction = menu->addAction(tr("Export Palette..."), this,
                                           &PaletteWidget::onExportPalette);
   m_importPaletteAction = menu->addAction(tr("Import Palette..."), this,
                                           &PaletteWidget::onImportPalette);
+  menu->addSeparator();
+  menu->addAction(tr("Export Library..."), this,
+                  &PaletteWidget::onExportLibrary);
+  menu->addAction(tr("Import Library..."), this,
+                  &PaletteWidget::onImportLibrary);
   m_menuButton->setMenu(menu);
 
   headerLayout->addWidget(m_menuButton);
@@ -252,19 +262,37 @@ void PaletteWidget::setupUI() {
   QVBoxLayout *contentLayout = new QVBoxLayout(m_contentWidget);
   contentLayout->setContentsMargins(0, 4, 0, 4); // No left/right margins
 
-  m_scrollArea = new QScrollArea(m_contentWidget);
-  m_scrollArea->setWidgetResizable(true);
-  m_scrollArea->setFrameShape(QFrame::NoFrame);
-  m_scrollArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-  m_scrollArea->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-
-  m_gridWidget = new QWidget();
-  m_gridLayout = new QGridLayout(m_gridWidget);
-  m_gridLayout->setContentsMargins(0, SPACING, 0, SPACING);
-  m_gridLayout->setSpacing(SPACING);
-
-  m_scrollArea->setWidget(m_gridWidget);
-  contentLayout->addWidget(m_scrollArea);
+  m_model = new PaletteModel(this);
+
+  // Uniform items in a wrapping flow are placed arithmetically, and only the
+  // visible ones are painted, so large palettes cost no more than small ones
+  m_swatchView = new QListView(m_contentWidget);
+  m_swatchView->setModel(m_model);
+  m_swatchView->setItemDelegate(new SwatchDelegate(m_swatchView));
+  m_swatchView->setFlow(QListView::LeftToRight);
+  m_swatchView->setWrapping(true);
+  m_swatchView->setResizeMode(QListView::Adjust);
+  m_swatchView->setMovement(QListView::Static);
+  m_swatchView->setUniformItemSizes(true);
+  m_swatchView->setSpacing(SPACING / 2);
+  m_swatchView->setSelectionMode(QAbstractItemView::NoSelection);
+  m_swatchView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  m_swatchView->setFrameShape(QFrame::NoFrame);
+  m_swatchView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+  m_swatchView->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+  m_swatchView->setStyleSheet("QListView { background: transparent; }");
+  m_swatchView->setMouseTracking(true);
+  m_swatchView->viewport()->setCursor(Qt::PointingHandCursor);
+  m_swatchView->setContextMenuPolicy(Qt::CustomContextMenu);
+  connect(m_swatchView, &QListView::clicked, this,
+          &PaletteWidget::onSwatchClicked);
+  connect(m_swatchView, &QListView::customContextMenuRequested, this,
+          &PaletteWidget::onSwatchContextMenu);
+  connect(m_model, &PaletteModel::rowsInserted, this,
+          &PaletteWidget::updateEmptyState);
+  connect(m_model, &PaletteModel::rowsRemoved, this,
+          &PaletteWidget::updateEmptyState);
+  contentLayout->addWidget(m_swatchView);
 
   // Create empty state message widget (hidden by default)
   m_emptyStateLabel = new QLabel(m_contentWidget);
@@ -280,51 +308,22 @@ void PaletteWidget::setupUI() {
 
   mainLayout->addWidget(m_contentWidget);
 
-  updateLayout();
+  updateEmptyState();
 }
 
-void PaletteWidget::updateLayout() {
-  // Clear grid
-  while (m_gridLayout->count() > 0) {
-    QLayoutItem *item = m_gridLayout->takeAt(0);
-    if (item->widget()) {
-      item->widget()->setParent(nullptr);
-    }
-    delete item;
-  }
-
-  // Check if palette is empty
-  bool isEmpty = m_swatches.isEmpty();
-
-  // Show/hide empty state message
-  if (isEmpty) {
-    m_scrollArea->hide();
+void PaletteWidget::updateEmptyState() {
+  if (m_model->rowCount() == 0) {
+    const bool loading = m_currentPalette && !m_currentPalette->isLoaded();
+    m_emptyStateLabel->setText(
+        loading ? tr("Loading colors...")
+                : tr("No colors in this palette.\nClick the + button to add "
+                     "colors."));
+    m_swatchView->hide();
     m_emptyStateLabel->show();
   } else {
     m_emptyStateLabel->hide();
-    m_scrollArea->show();
-
-    // Add swatches to grid
-    int col = 0;
-    int row = 0;
-    for (ColorSwatch *swatch : std::as_const(m_swatches)) {
-      m_gridLayout->addWidget(swatch, row, col);
-      swatch->show(); // Ensure swatch is visible
-      col++;
-      if (col >= MAX_COLUMNS) {
-        col = 0;
-        row++;
-      }
-    }
+    m_swatchView->show();
   }
-
-  m_gridWidget->adjustSize();
-  m_gridWidget->updateGeometry();
-  m_scrollArea->updateGeometry();
-  m_contentWidget->updateGeometry();
-
-  // Force immediate update
-  update();
 }
 
 void PaletteWidget::setPalette(Palette *palette) {
@@ -336,7 +335,7 @@ void PaletteWidget::setPalette(Palette *palette) {
   bool isReadOnly = palette && palette->isReadOnly();
   // Enable + button for "Recent" palette even though it's read-only
   const bool enableAddButton = !isReadOnly ||
-      (palette && palette->id() == PaletteManager::RECENTLY_PICKED_PALETTE_ID);
+      (palette && palette == PaletteManager::instance().recentPalette());
   m_addButton->setEnabled(enableAddButton);
 
   auto setActionEnabled = [isReadOnly](QAction *action,
@@ -349,47 +348,25 @@ void PaletteWidget::setPalette(Palette *palette) {
   setActionEnabled(m_renamePaletteAction, true);
   setActionEnabled(m_deletePaletteAction, true);
   setActionEnabled(m_clearPaletteAction, true);
+  setActionEnabled(m_removeDuplicatesAction, true);
   setActionEnabled(m_importPaletteAction, true);
   setActionEnabled(m_generateFromImageAction, false);
   setActionEnabled(m_newPaletteAction, false);
   setActionEnabled(m_exportPaletteAction, false);
+  setActionEnabled(m_comparePaletteAction, false);
 }
 
 void PaletteWidget::refreshColors() {
-  // Clear existing swatches
-  for (ColorSwatch *swatch : std::as_const(m_swatches)) {
-    swatch->deleteLater();
-  }
-  m_swatches.clear();
-
-  // Add swatches for current palette
-  if (m_currentPalette) {
-    const QVector<QColor> colors = m_currentPalette->colors();
-    for (int i = 0; i < colors.size(); ++i) {
-      QString colorName = m_currentPalette->colorName(i);
-      addColorToUI(colors[i], colorName);
-    }
-  }
-
-  updateLayout();
+  const Profiler::Scope scope("PaletteWidget::refreshColors");
+  m_model->setPalette(m_currentPalette);
+  updateEmptyState();
 }
 
-void PaletteWidget::addColorToUI(const QColor &color,
-                                 const QString &colorName) {
-  if (!color.isValid())
-    return;
-
-  bool isReadOnly = m_currentPalette && m_currentPalette->isReadOnly();
-  ColorSwatch *swatch =
-      new ColorSwatch(color, m_gridWidget, isReadOnly, colorName);
-  connect(swatch, &ColorSwatch::clicked, this, &PaletteWidget::onSwatchClicked);
-
-  if (!isReadOnly) {
-    connect(swatch, &ColorSwatch::removeRequested, this,
-            &PaletteWidget::onSwatchRemoveRequested);
+void PaletteWidget::scrollToColor(int index) {
+  const QModelIndex modelIndex = m_model->index(index);
+  if (modelIndex.isValid()) {
+    m_swatchView->scrollTo(modelIndex);
   }
-
-  m_swatches.append(swatch);
 }
 
 void PaletteWidget::onClearPalette() {
@@ -408,10 +385,91 @@ void PaletteWidget::onClearPalette() {
       QMessageBox::Yes | QMessageBox::No);
 
   if (reply == QMessageBox::Yes) {
-    m_currentPalette->clearColors();
-    refreshColors();
-    PaletteManager::instance().savePalettes();
+    PaletteManager::instance().clearColors(m_currentPalette);
+  }
+}
+
+void PaletteWidget::onRemoveNearDuplicates() {
+  if (!m_currentPalette || m_currentPalette->colorCount() < 2)
+    return;
+
+  if (m_currentPalette->isReadOnly()) {
+    QMessageBox::information(this, tr("Remove Near Duplicates"),
+                             tr("Cannot modify read-only palettes."));
+    return;
+  }
+
+  // Below about 2 two colors are hard to tell apart side by side
+  bool ok;
+  const double threshold = QInputDialog::getDouble(
+      this, tr("Remove Near Duplicates"),
+      tr("Remove colors within this CIEDE2000 distance of an earlier color:"),
+      2.0, 0.1, 50.0, 1, &ok);
+  if (!ok)
+    return;
+
+  PaletteManager &manager = PaletteManager::instance();
+  QVector<QColor> colors;
+  for (const PackedColor &color : manager.paletteColors(m_currentPalette)) {
+    colors.append(ColorLogic::fromPacked(color));
+  }
+
+  const QVector<QColor> kept =
+      ColorDifference::removeNearDuplicates(colors, float(threshold));
+  const int removed = int(colors.size() - kept.size());
+  if (removed > 0) {
+    manager.setColors(m_currentPalette, kept);
+  }
+  if (statusBar()) {
+    statusBar()->showMessage(
+        tr("Removed %n near-duplicate color(s)", nullptr, removed), 2000);
+  }
+}
+
+void PaletteWidget::onComparePalette() {
+  if (!m_currentPalette || m_currentPalette->colorCount() == 0)
+    return;
+
+  PaletteManager &manager = PaletteManager::instance();
+  QVector<Palette *> others;
+  QStringList names;
+  for (Palette *palette : manager.allPalettes()) {
+    if (palette != m_currentPalette && palette->colorCount() > 0) {
+      others.append(palette);
+      names.append(palette->name());
+    }
   }
+  if (others.isEmpty()) {
+    QMessageBox::information(this, tr("Compare with Palette"),
+                             tr("There is no other palette with colors."));
+    return;
+  }
+
+  bool ok;
+  const QString name =
+      QInputDialog::getItem(this, tr("Compare with Palette"), tr("Palette:"),
+                            names, 0, false, &ok);
+  if (!ok)
+    return;
+  const Palette *other = others[names.indexOf(name)];
+
+  auto colorsOf = [&manager](const Palette *palette) {
+    QVector<QColor> colors;
+    for (const PackedColor &color : manager.paletteColors(palette)) {
+      colors.append(ColorLogic::fromPacked(color));
+    }
+    return colors;
+  };
+
+  const float distance = ColorDifference::paletteDistance(
+      colorsOf(m_currentPalette), colorsOf(other));
+  QMessageBox::information(
+      this, tr("Compare with Palette"),
+      tr("Distance between \"%1\" and \"%2\": %3\n\n"
+         "The average CIEDE2000 distance from each color to the nearest "
+         "color of the other palette. Below about 2 the palettes look alike.")
+          .arg(m_currentPalette->name(), other->name())
+          .arg(distance, 0, 'f', 2));
 }
 
 void PaletteWidget::onExportPalette() {
@@ -421,25 +479,64 @@ void PaletteWidget::onExportPalette() {
     return;
   }
 
-  QString fileName =
-      QFileDialog::getSaveFileName(this, tr("Export Palette"), QString(),
-                                   tr("Palette Files (*.txt);;All Files (*)"));
+  const struct {
+    PaletteExporter::Format format;
+    QString label;
+  } filters[] = {
+      {PaletteExporter::PlainText, tr("Text Files (*.txt)")},
+      {PaletteExporter::Gpl, tr("GIMP Palette (*.gpl)")},
+      {PaletteExporter::Ase, tr("Adobe Swatch Exchange (*.ase)")},
+      {PaletteExporter::Css, tr("CSS Variables (*.css)")},
+      {PaletteExporter::Scss, tr("SCSS Variables (*.scss)")},
+      {PaletteExporter::Tailwind, tr("Tailwind Config (*.js)")},
+      {PaletteExporter::Json, tr("JSON (*.json)")},
+      {PaletteExporter::Png, tr("PNG Swatch Sheet (*.png)")},
+  };
 
-  if (fileName.isEmpty())
-    return;
+  QStringList labels;
+  for (const auto &filter : filters) {
+    labels.append(filter.label);
+  }
 
-  QFile file(fileName);
-  if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-    QMessageBox::warning(this, tr("Export Error"),
-                         tr("Could not open file for writing."));
+  auto formatForFilter = [&filters](const QString &label) {
+    for (const auto &filter : filters) {
+      if (filter.label == label)
+        return filter.format;
+    }
+    return PaletteExporter::PlainText;
+  };
+
+  // The dialog appends the selected filter's suffix to names without one,
+  // so the overwrite confirmation applies to the file actually written
+  QFileDialog dialog(this, tr("Export Palette"));
+  dialog.setAcceptMode(QFileDialog::AcceptSave);
+  dialog.setNameFilters(labels);
+  dialog.setDefaultSuffix(PaletteExporter::fileSuffix(filters[0].format));
+  connect(&dialog, &QFileDialog::filterSelected, &dialog,
+          [&dialog, &formatForFilter](const QString &label) {
+            dialog.setDefaultSuffix(
+                PaletteExporter::fileSuffix(formatForFilter(label)));
+          });
+
+  if (dialog.exec() != QDialog::Accepted || dialog.selectedFiles().isEmpty())
     return;
+
+  // A known suffix wins over the selected filter
+  const QString fileName = dialog.selectedFiles().first();
+  PaletteExporter::Format format = PaletteExporter::PlainText;
+  if (!PaletteExporter::formatFromName(QFileInfo(fileName).suffix(), &format)) {
+    format = formatForFilter(dialog.selectedNameFilter());
   }
 
-  QTextStream out(&file);
-  for (const QColor &color : m_currentPalette->colors()) {
-    out << color.name(QColor::HexArgb) << "\n";
+  // The palette may still be loading; its colors are read from the library
+  const QVector<PackedColor> colors =
+      PaletteManager::instance().paletteColors(m_currentPalette);
+  if (!PaletteExporter::exportFile(fileName, m_currentPalette->name(), colors,
+                                   format)) {
+    QMessageBox::warning(this, tr("Export Error"),
+                         tr("Could not write the palette file."));
+    return;
   }
-  file.close();
 
   QMessageBox::information(this, tr("Export Palette"),
                            tr("Palette exported successfully."));
@@ -455,39 +552,88 @@ void PaletteWidget::onImportPalette() {
     return;
   }
 
-  QString fileName =
-      QFileDialog::getOpenFileName(this, tr("Import Palette"), QString(),
-                                   tr("Palette Files (*.txt);;All Files (*)"));
+  QString fileName = QFileDialog::getOpenFileName(
+      this, tr("Import Palette"), QString(),
+      tr("All Palettes (*.txt *.gpl *.ase *.aco *.css *.scss);;"
+         "Text Files (*.txt);;GIMP Palettes (*.gpl);;"
+         "Adobe Swatch Exchange (*.ase);;Photoshop Swatches (*.aco);;"
+         "CSS/SCSS Variables (*.css *.scss);;All Files (*)"));
 
   if (fileName.isEmpty())
     return;
 
-  QFile file(fileName);
-  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+  QProgressDialog progress(tr("Importing palette..."), tr("Cancel"), 0, 100,
+                           this);
+  progress.setWindowModality(Qt::WindowModal);
+  progress.setMinimumDuration(500);
+
+  PaletteImporter::Result result;
+  const bool ok = PaletteImporter::importFile(
+      fileName, &result, [&progress](qint64 done, qint64 total) {
+        if (total > 0) {
+          progress.setValue(static_cast<int>(done * 100 / total));
+        }
+        return !progress.wasCanceled();
+      });
+  const bool canceled = progress.wasCanceled();
+  progress.reset();
+
+  if (canceled)
+    return;
+
+  if (!ok) {
     QMessageBox::warning(this, tr("Import Error"),
-                         tr("Could not open file for reading."));
+                         tr("Could not read the palette file."));
     return;
   }
 
-  m_currentPalette->clearColors();
+  // Replaces the palette contents as a single journaled edit
+  PaletteManager::instance().setPackedColors(m_currentPalette, result.colors);
 
-  QTextStream in(&file);
-  while (!in.atEnd()) {
-    QString line = in.readLine().trimmed();
-    if (!line.isEmpty()) {
-      QColor color(line);
-      if (color.isValid()) {
-        m_currentPalette->addColor(color);
-      }
-    }
+  QString message = tr("Imported %n color(s).", "", result.colors.size());
+  if (result.skipped > 0) {
+    message += QLatin1Char('\n') +
+               tr("%n entry(s) could not be read.", "", result.skipped);
   }
-  file.close();
+  QMessageBox::information(this, tr("Import Palette"), message);
+}
 
-  refreshColors();
-  PaletteManager::instance().savePalettes();
+void PaletteWidget::onExportLibrary() {
+  QString fileName = QFileDialog::getSaveFileName(
+      this, tr("Export Library"), QString(), tr("JSON Files (*.json)"));
 
-  QMessageBox::information(this, tr("Import Palette"),
-                           tr("Palette imported successfully."));
+  if (fileName.isEmpty())
+    return;
+
+  if (!PaletteManager::instance().exportLibraryJson(fileName)) {
+    QMessageBox::warning(this, tr("Export Error"),
+                         tr("Could not write the palette library."));
+    return;
+  }
+
+  QMessageBox::information(this, tr("Export Library"),
+                           tr("Palette library exported successfully."));
+}
+
+void PaletteWidget::onImportLibrary() {
+  QString fileName = QFileDialog::getOpenFileName(
+      this, tr("Import Library"), QString(),
+      tr("JSON Files (*.json);;All Files (*)"));
+
+  if (fileName.isEmpty())
+    return;
+
+  const int imported = PaletteManager::instance().importLibraryJson(fileName);
+  if (imported < 0) {
+    QMessageBox::warning(this, tr("Import Error"),
+                         tr("Could not read the palette library."));
+    return;
+  }
+
+  updatePaletteCombo();
+
+  QMessageBox::information(this, tr("Import Library"),
+                           tr("Imported %n palette(s).", "", imported));
 }
 
 void PaletteWidget::onAddColorClicked() {
@@ -495,27 +641,40 @@ void PaletteWidget::onAddColorClicked() {
   emit addColorRequested();
 }
 
-void PaletteWidget::onSwatchClicked() {
-  ColorSwatch *swatch = qobject_cast<ColorSwatch *>(sender());
-  if (swatch) {
-    emit colorSelected(swatch->color());
+void PaletteWidget::onSwatchClicked(const QModelIndex &index) {
+  if (index.isValid()) {
+    emit colorSelected(index.data(Qt::DecorationRole).value<QColor>());
   }
 }
 
-void PaletteWidget::onSwatchRemoveRequested() {
-  if (!m_currentPalette)
+void PaletteWidget::onSwatchContextMenu(const QPoint &pos) {
+  const QModelIndex index = m_swatchView->indexAt(pos);
+  if (!index.isValid())
     return;
 
-  ColorSwatch *swatch = qobject_cast<ColorSwatch *>(sender());
-  if (swatch) {
-    int index = m_swatches.indexOf(swatch);
-    if (index >= 0) {
-      m_currentPalette->removeColor(index);
-      m_swatches.removeAt(index);
-      swatch->deleteLater();
-      updateLayout();
-      PaletteManager::instance().savePalettes();
-    }
+  QMenu menu(this);
+
+  // Add copy action (available for all swatches)
+  const QAction *copyAction = menu.addAction(tr("Copy HEX"));
+
+  // Add remove action only for editable palettes
+  const QAction *removeAction = nullptr;
+  if (m_currentPalette && !m_currentPalette->isReadOnly()) {
+    menu.addSeparator();
+    removeAction = menu.addAction(tr("Remove"));
+  }
+
+  const QAction *selected =
+      menu.exec(m_swatchView->viewport()->mapToGlobal(pos));
+  if (!selected)
+    return;
+
+  if (selected == copyAction) {
+    // Copy color code to clipboard
+    const QColor color = index.data(Qt::DecorationRole).value<QColor>();
+    QApplication::clipboard()->setText(color.name(QColor::HexArgb));
+  } else if (selected == removeAction) {
+    PaletteManager::instance().removeColor(m_currentPalette, index.row());
   }
 }
 
@@ -537,7 +696,11 @@ void PaletteWidget::updatePaletteCombo() {
       insertedCount++;
     }
 
-    m_paletteCombo->addItem(palette->name(), palette->id());
+    m_paletteCombo->addItem(previewIcon(palette), palette->name(),
+                            palette->handle());
+    m_paletteCombo->setItemData(insertedCount,
+                                tr("%n color(s)", "", palette->colorCount()),
+                                Qt::ToolTipRole);
 
     if (palette == m_currentPalette) {
       currentIndex = insertedCount;
@@ -557,13 +720,12 @@ void PaletteWidget::onPaletteSelected(int index) {
   if (index < 0)
     return;
 
-  QString paletteId = m_paletteCombo->itemData(index).toString();
-  Palette *palette = PaletteManager::instance().getPalette(paletteId);
+  const PaletteHandle handle = m_paletteCombo->itemData(index).toUInt();
+  Palette *palette = PaletteManager::instance().getPalette(handle);
 
   if (palette && palette != m_currentPalette) {
     PaletteManager::instance().setCurrentPalette(palette);
     setPalette(palette);
-    PaletteManager::instance().savePalettes();
   }
 }
 
@@ -579,7 +741,6 @@ void PaletteWidget::onNewPalette() {
     m_currentPalette = newPalette;
     updatePaletteCombo();
     refreshColors();
-    PaletteManager::instance().savePalettes();
     statusBar()->showMessage(tr("Created palette: %1").arg(name), 2000);
   }
 }
@@ -596,7 +757,6 @@ void PaletteWidget::onRenamePalette() {
   if (ok && !newName.isEmpty()) {
     PaletteManager::instance().renamePalette(m_currentPalette->id(), newName);
     updatePaletteCombo();
-    PaletteManager::instance().savePalettes();
   }
 }
 
@@ -622,7 +782,6 @@ void PaletteWidget::onDeletePalette() {
     m_currentPalette = PaletteManager::instance().currentPalette();
     updatePaletteCombo();
     refreshColors();
-    PaletteManager::instance().savePalettes();
   }
 }
 
@@ -689,15 +848,12 @@ void PaletteWidget::onGenerateFromImage() {
       return;
 
     Palette *newPalette = PaletteManager::instance().createPalette(paletteName);
-    for (const QColor &color : colors) {
-      newPalette->addColor(color);
-    }
+    PaletteManager::instance().setColors(newPalette, colors);
 
     PaletteManager::instance().setCurrentPalette(newPalette);
     m_currentPalette = newPalette;
     updatePaletteCombo();
     refreshColors();
-    PaletteManager::instance().savePalettes();
 
     if (statusBar()) {
       statusBar()->showMessage(
@@ -0,0 +1,163 @@
+#include "../include/Profiler.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+namespace {
+
+constexpr const char *TRACE_VARIABLE = "COLORSMITH_TRACE";
+
+// Most recent samples kept, about 2 MiB
+constexpr quint64 CAPACITY = 1 << 16;
+
+// Written by any thread and read while writers may be running, so every
+// field is atomic. A slot is read only if its sequence was the same before
+// and after copying it.
+struct Slot {
+  // 0 while being written, otherwise the sample's ticket + 1
+  std::atomic<quint64> sequence{0};
+  std::atomic<const char *> name{nullptr};
+  std::atomic<qint64> start{0};
+  std::atomic<qint64> duration{0};
+  std::atomic<int> thread{0};
+};
+
+struct Sample {
+  const char *name;
+  qint64 start;
+  qint64 duration;
+  int thread;
+};
+
+struct Trace {
+  QString path;
+  QElapsedTimer clock;
+  std::atomic<quint64> next{0};
+  std::unique_ptr<Slot[]> slots;
+};
+
+Trace &trace() {
+  static Trace t;
+  return t;
+}
+
+// Small stable numbers read better in the trace viewer than thread handles
+int currentThread() {
+  static std::atomic<int> threads{0};
+  thread_local const int id = ++threads;
+  return id;
+}
+
+QVector<Sample> collectSamples() {
+  Trace &t = trace();
+  const quint64 end = t.next.load(std::memory_order_acquire);
+  const quint64 first = end > CAPACITY ? end - CAPACITY : 0;
+
+  QVector<Sample> samples;
+  samples.reserve(int(end - first));
+  for (quint64 ticket = first; ticket < end; ++ticket) {
+    const Slot &slot = t.slots[ticket % CAPACITY];
+    const quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != ticket + 1)
+      continue;
+
+    const Sample sample{slot.name.load(std::memory_order_relaxed),
+                        slot.start.load(std::memory_order_relaxed),
+                        slot.duration.load(std::memory_order_relaxed),
+                        slot.thread.load(std::memory_order_relaxed)};
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+      continue;
+    samples.append(sample);
+  }
+  return samples;
+}
+
+} // namespace
+
+bool Profiler::s_enabled = false;
+
+void Profiler::startFromEnvironment() {
+  const QString path = qEnvironmentVariable(TRACE_VARIABLE);
+  if (path.isEmpty())
+    return;
+
+  Trace &t = trace();
+  t.path = path;
+  t.slots.reset(new Slot[CAPACITY]);
+  t.clock.start();
+  s_enabled = true;
+}
+
+bool Profiler::finish() {
+  if (!s_enabled)
+    return true;
+
+  const QString &path = trace().path;
+  if (!writeChromeTrace(path))
+    return false;
+  qInfo().noquote() << "Trace written to" << path;
+  return true;
+}
+
+qint64 Profiler::now() { return trace().clock.nsecsElapsed(); }
+
+void Profiler::record(const char *name, qint64 start, qint64 duration) {
+  if (!s_enabled)
+    return;
+
+  Trace &t = trace();
+  const quint64 ticket = t.next.fetch_add(1, std::memory_order_relaxed);
+  Slot &slot = t.slots[ticket % CAPACITY];
+
+  // Readers must see the slot as incomplete before any field changes
+  slot.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.start.store(start, std::memory_order_relaxed);
+  slot.duration.store(duration, std::memory_order_relaxed);
+  slot.thread.store(currentThread(), std::memory_order_relaxed);
+  slot.sequence.store(ticket + 1, std::memory_order_release);
+}
+
+bool Profiler::writeChromeTrace(const QString &path) {
+  if (!s_enabled)
+    return false;
+
+  // Complete ("X") events; the format counts in microseconds
+  QJsonArray events;
+  for (const Sample &sample : collectSamples()) {
+    QJsonObject event;
+    event["name"] = QString::fromLatin1(sample.name);
+    event["cat"] = "colorsmith";
+    event["ph"] = "X";
+    event["ts"] = sample.start / 1000.0;
+    event["dur"] = sample.duration / 1000.0;
+    event["pid"] = 1;
+    event["tid"] = sample.thread;
+    events.append(event);
+  }
+
+  QJsonObject root;
+  root["traceEvents"] = events;
+  root["displayTimeUnit"] = "ms";
+
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qWarning() << "Failed to open" << path << "for writing:" << file.errorString();
+    return false;
+  }
+
+  file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+  if (!file.commit()) {
+    qWarning() << "Failed to write" << path << ":" << file.errorString();
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,296 @@
+#include "../include/RecentColorsStore.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSet>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr char MAGIC[4] = {'C', 'S', 'R', 'C'};
+constexpr quint16 FORMAT_VERSION = 1;
+constexpr int HEADER_SIZE = 16; // magic, version, reserved, capacity, reserved
+constexpr int RECORD_SIZE = 16; // 4 x half float color, use stamp
+
+void encodeRecord(const PackedColor &color, quint64 stamp, char *out) {
+  quint16 halves[4];
+  std::memcpy(halves, &color, sizeof(halves));
+  for (int i = 0; i < 4; ++i) {
+    qToLittleEndian<quint16>(halves[i], out + i * 2);
+  }
+  qToLittleEndian<quint64>(stamp, out + 8);
+}
+
+void decodeRecord(const char *in, PackedColor *color, quint64 *stamp) {
+  quint16 halves[4];
+  for (int i = 0; i < 4; ++i) {
+    halves[i] = qFromLittleEndian<quint16>(in + i * 2);
+  }
+  std::memcpy(color, halves, sizeof(halves));
+  *stamp = qFromLittleEndian<quint64>(in + 8);
+}
+
+} // namespace
+
+bool RecentColorsStore::open(const QString &path, int capacity,
+                             const QString &legacyJsonPath) {
+  close();
+  reset(qBound(1, capacity, MAX_CAPACITY));
+
+  // State is rebuilt while m_file is closed, so nothing is written back yet
+  bool needsRewrite = true;
+
+  if (QFile file(path); file.open(QIODevice::ReadOnly)) {
+    needsRewrite = !load(file.readAll());
+  } else if (!legacyJsonPath.isEmpty()) {
+    loadJson(legacyJsonPath);
+  }
+
+  QDir().mkpath(QFileInfo(path).absolutePath());
+
+  m_file.setFileName(path);
+  if (!m_file.open(QIODevice::ReadWrite)) {
+    qWarning() << "Failed to open recent colors" << path << ":"
+               << m_file.errorString();
+    return false;
+  }
+
+  return needsRewrite ? writeAll() : true;
+}
+
+bool RecentColorsStore::load(const QByteArray &data) {
+  if (data.size() < HEADER_SIZE ||
+      std::memcmp(data.constData(), MAGIC, sizeof(MAGIC)) != 0 ||
+      qFromLittleEndian<quint16>(data.constData() + 4) != FORMAT_VERSION)
+    return false;
+
+  const int storedCapacity =
+      static_cast<int>(qFromLittleEndian<quint32>(data.constData() + 8));
+  const int records = static_cast<int>(
+      qMin<qsizetype>(storedCapacity, (data.size() - HEADER_SIZE) / RECORD_SIZE));
+
+  struct Record {
+    int slot;
+    PackedColor color;
+    quint64 stamp;
+  };
+  QVector<Record> loaded;
+  loaded.reserve(records);
+  for (int i = 0; i < records; ++i) {
+    Record record{i, {}, 0};
+    decodeRecord(data.constData() + HEADER_SIZE + i * RECORD_SIZE,
+                 &record.color, &record.stamp);
+    if (record.stamp != 0) {
+      loaded.append(record);
+    }
+  }
+
+  // Oldest first, so pushing to the front leaves the newest at the head
+  std::sort(loaded.begin(), loaded.end(),
+            [](const Record &a, const Record &b) { return a.stamp < b.stamp; });
+
+  // Slots fill from the start and are only reused after that, so the used
+  // records of an intact file of the same capacity are exactly a prefix
+  bool inPlace = storedCapacity == capacity() && records == storedCapacity;
+  QSet<quint64> keys;
+  for (const Record &record : loaded) {
+    const quint64 key = ColorLogic::packedKey(record.color);
+    inPlace = inPlace && record.slot < loaded.size() && !keys.contains(key);
+    keys.insert(key);
+  }
+
+  if (!inPlace) {
+    // Different capacity or damaged file: keep the most recent colors and
+    // let the caller rewrite the file
+    for (const Record &record : loaded) {
+      touch(record.color);
+    }
+    return false;
+  }
+
+  for (const Record &record : loaded) {
+    Slot &slot = m_slots[record.slot];
+    slot.color = record.color;
+    slot.stamp = record.stamp;
+    m_slotByKey.insert(ColorLogic::packedKey(record.color), record.slot);
+    pushFront(record.slot);
+    m_nextStamp = record.stamp + 1;
+  }
+  m_count = loaded.size();
+  renumberOrders();
+  return true;
+}
+
+void RecentColorsStore::close() {
+  if (m_file.isOpen()) {
+    m_file.close();
+  }
+}
+
+void RecentColorsStore::reset(int capacity) {
+  m_slots = QVector<Slot>(capacity);
+  m_slotByKey.clear();
+  m_slotByKey.reserve(capacity);
+  m_head = -1;
+  m_tail = -1;
+  m_count = 0;
+  m_nextStamp = 1;
+  m_orderTree = QVector<int>(2 * capacity + 1, 0);
+  m_nextOrder = 0;
+}
+
+void RecentColorsStore::unlink(int slot) {
+  Slot &s = m_slots[slot];
+  if (s.prev >= 0)
+    m_slots[s.prev].next = s.next;
+  else
+    m_head = s.next;
+  if (s.next >= 0)
+    m_slots[s.next].prev = s.prev;
+  else
+    m_tail = s.prev;
+  s.prev = s.next = -1;
+}
+
+void RecentColorsStore::pushFront(int slot) {
+  Slot &s = m_slots[slot];
+  s.prev = -1;
+  s.next = m_head;
+  if (m_head >= 0)
+    m_slots[m_head].prev = slot;
+  m_head = slot;
+  if (m_tail < 0)
+    m_tail = slot;
+}
+
+int RecentColorsStore::acquireSlot() {
+  // Unused slots are filled in order before anything is evicted
+  if (m_count < m_slots.size())
+    return m_count++;
+
+  const int slot = m_tail;
+  unlink(slot);
+  addOrder(m_slots[slot].order, -1);
+  m_slotByKey.remove(ColorLogic::packedKey(m_slots[slot].color));
+  return slot;
+}
+
+void RecentColorsStore::addOrder(int order, int delta) {
+  for (int i = order + 1; i < m_orderTree.size(); i += i & -i) {
+    m_orderTree[i] += delta;
+  }
+}
+
+int RecentColorsStore::countOrdersUpTo(int order) const {
+  int count = 0;
+  for (int i = order + 1; i > 0; i -= i & -i) {
+    count += m_orderTree[i];
+  }
+  return count;
+}
+
+void RecentColorsStore::renumberOrders() {
+  std::fill(m_orderTree.begin(), m_orderTree.end(), 0);
+  m_nextOrder = 0;
+  for (int slot = m_tail; slot >= 0; slot = m_slots[slot].prev) {
+    m_slots[slot].order = m_nextOrder;
+    addOrder(m_nextOrder++, 1);
+  }
+}
+
+int RecentColorsStore::touch(const PackedColor &color) {
+  const quint64 key = ColorLogic::packedKey(color);
+
+  int slot = m_slotByKey.value(key, -1);
+  int previous = -1;
+
+  if (slot < 0) {
+    slot = acquireSlot();
+    m_slots[slot].color = color;
+    m_slotByKey.insert(key, slot);
+  } else {
+    // Every live color with a higher order number was picked more recently
+    previous = m_count - countOrdersUpTo(m_slots[slot].order);
+    unlink(slot);
+    addOrder(m_slots[slot].order, -1);
+  }
+
+  // The slot is unlinked here, so renumbering leaves it out
+  if (m_nextOrder + 1 >= m_orderTree.size()) {
+    renumberOrders();
+  }
+  m_slots[slot].order = m_nextOrder++;
+  addOrder(m_slots[slot].order, 1);
+
+  m_slots[slot].stamp = m_nextStamp++;
+  pushFront(slot);
+  writeRecord(slot);
+  return previous;
+}
+
+QVector<PackedColor> RecentColorsStore::colors() const {
+  QVector<PackedColor> result;
+  result.reserve(m_count);
+  for (int slot = m_head; slot >= 0; slot = m_slots[slot].next) {
+    result.append(m_slots[slot].color);
+  }
+  return result;
+}
+
+bool RecentColorsStore::writeAll() {
+  if (!m_file.isOpen())
+    return false;
+
+  QByteArray data(HEADER_SIZE + m_slots.size() * RECORD_SIZE, '\0');
+  std::memcpy(data.data(), MAGIC, sizeof(MAGIC));
+  qToLittleEndian<quint16>(FORMAT_VERSION, data.data() + 4);
+  qToLittleEndian<quint32>(quint32(m_slots.size()), data.data() + 8);
+
+  for (int i = 0; i < m_slots.size(); ++i) {
+    encodeRecord(m_slots[i].color, m_slots[i].stamp,
+                 data.data() + HEADER_SIZE + i * RECORD_SIZE);
+  }
+
+  m_file.seek(0);
+  m_file.resize(0);
+  const bool ok = m_file.write(data) == data.size() && m_file.flush();
+  if (!ok) {
+    qWarning() << "Failed to write recent colors:" << m_file.errorString();
+  }
+  return ok;
+}
+
+void RecentColorsStore::writeRecord(int slot) {
+  if (!m_file.isOpen())
+    return;
+
+  char record[RECORD_SIZE];
+  encodeRecord(m_slots[slot].color, m_slots[slot].stamp, record);
+
+  m_file.seek(HEADER_SIZE + qint64(slot) * RECORD_SIZE);
+  m_file.write(record, RECORD_SIZE);
+  m_file.flush();
+}
+
+void RecentColorsStore::loadJson(const QString &path) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+    return;
+
+  const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+  file.close();
+
+  // The JSON list is most recent first; replay it backwards
+  const QJsonArray colorsArray = doc.array();
+  for (qsizetype i = colorsArray.size() - 1; i >= 0; --i) {
+    const QColor color =
+        ColorLogic::storageStringToColor(colorsArray[i].toString());
+    if (color.isValid()) {
+      touch(ColorLogic::toPacked(color));
+    }
+  }
+}
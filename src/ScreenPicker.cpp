@@ -32,12 +32,24 @@ const QDBusArgument &operator>>(const QDBusArgument &argument, ColorStruct &mySt
 
 ScreenPicker::ScreenPicker(QObject *parent) : QObject(parent)
 {
+}
+
+void ScreenPicker::registerTypes()
+{
+    // Registering with D-Bus is not free, and most sessions never pick
+    static bool registered = false;
+    if (registered)
+        return;
+    registered = true;
+
     qRegisterMetaType<ColorStruct>("ColorStruct");
     qDBusRegisterMetaType<ColorStruct>();
 }
 
 void ScreenPicker::pickColor()
 {
+    registerTypes();
+
     QDBusMessage message = QDBusMessage::createMethodCall(
         "org.freedesktop.portal.Desktop",
         "/org/freedesktop/portal/desktop",
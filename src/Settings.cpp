@@ -45,6 +45,32 @@ void Manager::setCurrentPaletteId(const QString& id) {
     m_settings.setValue(Keys::CURRENT_PALETTE_ID, id);
 }
 
+int Manager::getRecentColorsCapacity(int defaultCapacity) const {
+    return m_settings.value(Keys::RECENT_COLORS_CAPACITY,
+                            defaultCapacity).toInt();
+}
+
+void Manager::setRecentColorsCapacity(int capacity) {
+    m_settings.setValue(Keys::RECENT_COLORS_CAPACITY, capacity);
+}
+
+int Manager::getPlaneCacheBudget(int defaultKib) const {
+    return m_settings.value(Keys::PLANE_CACHE_BUDGET,
+                            defaultKib).toInt();
+}
+
+void Manager::setPlaneCacheBudget(int kib) {
+    m_settings.setValue(Keys::PLANE_CACHE_BUDGET, kib);
+}
+
+QString Manager::getPlaneMode() const {
+    return m_settings.value(Keys::PLANE_MODE, "Hsv").toString();
+}
+
+void Manager::setPlaneMode(const QString& mode) {
+    m_settings.setValue(Keys::PLANE_MODE, mode);
+}
+
 
 QByteArray Manager::getWindowGeometry() const {
     return m_settings.value(Keys::WINDOW_GEOMETRY).toByteArray();
@@ -1,17 +1,62 @@
+#include "../include/CommandLineTool.h"
 #include "../include/MainWindow.h"
+#include "../include/Profiler.h"
 #include "../include/version.h"
 #include <QApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QTimer>
 
 int main(int argc, char *argv[]) {
+    // Subcommands such as "colorsmith export" run headless
+    if (CommandLineTool::isCommand(argc, argv)) {
+        return CommandLineTool::run(argc, argv);
+    }
+
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
+    // COLORSMITH_TRACE=<file> records a trace of the hot paths until exit
+    Profiler::startFromEnvironment();
+
+    // COLORSMITH_STARTUP_TIMING=1 reports each startup phase and the time
+    // until the first frame
+    const bool reportStartup = qEnvironmentVariableIsSet("COLORSMITH_STARTUP_TIMING");
+    qint64 phaseStart = 0;
+    auto endPhase = [&](const char *phase) {
+        if (!reportStartup)
+            return;
+        const qint64 now = startupTimer.elapsed();
+        qInfo().noquote() << phase << now - phaseStart << "ms";
+        phaseStart = now;
+    };
+
     QApplication app(argc, argv);
 
     QApplication::setApplicationName(COLORSMITH_APP_NAME);
     QApplication::setOrganizationName(COLORSMITH_ORGANIZATION_NAME);
     QApplication::setOrganizationDomain(COLORSMITH_ORGANIZATION_DOMAIN);
     QApplication::setApplicationVersion(COLORSMITH_VERSION_STRING);
+    endPhase("Application:");
 
     MainWindow window;
+    endPhase("Main window:");
+
     window.show();
+    endPhase("Show:");
+
+    // The deferred work runs right after the first frame; a zero timer queued
+    // from the signal reports once it is done. Together the two lines give
+    // the time to first paint with and without the deferral.
+    if (reportStartup) {
+        QObject::connect(&window, &MainWindow::firstFramePresented, &window, [&]() {
+            endPhase("First frame:");
+            qInfo().noquote() << "Time to first paint:" << startupTimer.elapsed() << "ms";
+            QTimer::singleShot(0, &window, [&]() { endPhase("Deferred loading:"); });
+        });
+    }
 
-    return app.exec();
+    const int result = app.exec();
+    Profiler::finish();
+    return result;
 }
@@ -1,9 +1,114 @@
 #include "../include/qthsvrectpicker.h"
+#include "../include/ColorMath.h"
+#include "../include/ColorRaster.h"
+#include "../include/ColorSpace.h"
+#include "../include/Profiler.h"
 
 #include <QPainter>
 #include <QImage>
+#include <QCache>
+#include <QContextMenuEvent>
+#include <QFutureWatcher>
+#include <QMenu>
 #include <QResizeEvent>
 #include <QStyleOptionFrame>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtMath>
+#include <cmath>
+
+namespace {
+
+// Planes up to this many pixels are rendered on the GUI thread
+constexpr int DIRECT_PIXELS = 512 * 512;
+// Larger ones first show a preview at 1/PREVIEW_SCALE of the width and
+// height while the full plane renders on the thread pool
+constexpr int PREVIEW_SCALE = 4;
+
+// Values on each side of the current one rendered ahead while idle
+constexpr int PREFETCH_RADIUS = 8;
+constexpr int PREFETCH_DELAY_MS = 300;
+
+// OKLCH chroma at full saturation; every sRGB color lies below it
+constexpr float MAX_OKLCH_CHROMA = 0.33f;
+// CIELAB a and b both span -LAB_AB_RANGE..LAB_AB_RANGE
+constexpr float LAB_AB_RANGE = 128.0f;
+
+// Everything a rendered plane depends on
+struct PlaneKey
+{
+    QtHsvRectPicker::PlaneMode mode;
+    QSize size;
+    int value;
+    int minHue;
+    int maxHue;
+    int minSat;
+    int maxSat;
+    int dprPercent;
+    QRgb mask;
+};
+
+bool operator==(const PlaneKey &a, const PlaneKey &b)
+{
+    return a.mode == b.mode && a.size == b.size && a.value == b.value &&
+           a.minHue == b.minHue && a.maxHue == b.maxHue && a.minSat == b.minSat &&
+           a.maxSat == b.maxSat && a.dprPercent == b.dprPercent && a.mask == b.mask;
+}
+
+size_t qHash(const PlaneKey &key, size_t seed = 0)
+{
+    return qHashMulti(seed, int(key.mode), key.size.width(), key.size.height(),
+                      key.value, key.minHue, key.maxHue, key.minSat, key.maxSat,
+                      key.dprPercent, key.mask);
+}
+
+// Cache cost in KiB, the unit of the budget
+int planeCost(const QSize &size)
+{
+    return qMax(1, size.width() * size.height() / 256);
+}
+
+// The hue modes need a ramp as wide as key.size; the others ignore it
+QImage renderPlaneImage(const PlaneKey &key, const ColorRaster::HueRamp &ramp)
+{
+    QImage img(key.size, QImage::Format_RGB32);
+    img.setDevicePixelRatio(key.dprPercent / 100.0);
+    const float satTop = key.maxSat / 255.0f;
+    const float satBottom = key.minSat / 255.0f;
+    const float value = key.value / 255.0f;
+
+    switch (key.mode) {
+    case QtHsvRectPicker::Hsv:
+        ColorRaster::hsvPlane(&img, ramp, satTop, satBottom, value);
+        break;
+    case QtHsvRectPicker::Hsl:
+        ColorRaster::hslPlane(&img, ramp, satTop, satBottom, value);
+        break;
+    case QtHsvRectPicker::Oklch:
+        ColorRaster::oklchPlane(&img, key.maxHue, key.minHue, satTop * MAX_OKLCH_CHROMA,
+                                satBottom * MAX_OKLCH_CHROMA, value, key.mask);
+        break;
+    case QtHsvRectPicker::Lab:
+        ColorRaster::labPlane(&img, -LAB_AB_RANGE, LAB_AB_RANGE, LAB_AB_RANGE,
+                              -LAB_AB_RANGE, value * 100.0f, key.mask);
+        break;
+    }
+    return img;
+}
+
+// Invalid for colors outside sRGB, which the perceptual planes mask
+QColor fromLinearRgb(const ColorSpace::Rgb &rgb)
+{
+    for (float c : {rgb.r, rgb.g, rgb.b}) {
+        if (c < -ColorMath::GAMUT_EPSILON || c > 1.0f + ColorMath::GAMUT_EPSILON)
+            return QColor();
+    }
+    return QColor::fromRgbF(ColorSpace::linearToSrgb(qBound(0.0f, rgb.r, 1.0f)),
+                            ColorSpace::linearToSrgb(qBound(0.0f, rgb.g, 1.0f)),
+                            ColorSpace::linearToSrgb(qBound(0.0f, rgb.b, 1.0f)));
+}
+
+} // namespace
 
 class QtHsvRectPickerPrivate
 {
@@ -13,12 +118,33 @@ public:
     int satFromY(int) const;
     int satToY(int) const;
     int hueToX(int) const;
+    QColor colorAt(const QPoint &pt) const;
+    QPoint positionOf(const QColor &c) const;
+    int valueOf(const QColor &c) const;
+    QSize deviceSize() const;
     void buildPixmap();
+    void updateRamp(ColorRaster::HueRamp *ramp, int width);
+    PlaneKey planeKey(int value) const;
+    QFuture<QImage> renderPlane(const PlaneKey &key);
+    void cachePlane(const PlaneKey &key, const QPixmap &plane);
+    void startFullPlane();
+    void fullPlaneReady();
+    void prefetchNext();
     int minSat;
     int maxSat;
     int minHue;
     int maxHue;
     int cVal;
+    QtHsvRectPicker::PlaneMode mode;
+    ColorRaster::HueRamp hueRamp;
+    ColorRaster::HueRamp previewRamp;
+    QCache<PlaneKey, QPixmap> planeCache;
+    QFutureWatcher<QImage> *planeWatcher;
+    PlaneKey planeWatcherKey;
+    bool planeStale;
+    QFutureWatcher<QImage> *prefetchWatcher;
+    PlaneKey prefetchWatcherKey;
+    QTimer *prefetchTimer;
     QPoint pos;
     QPixmap pixmap;
     QSize size;
@@ -27,6 +153,7 @@ public:
 };
 
 QtHsvRectPickerPrivate::QtHsvRectPickerPrivate(QtHsvRectPicker *q) :
+    planeCache(QtHsvRectPicker::DEFAULT_CACHE_BUDGET),
     q_ptr(q)
 {
     minSat = 0;
@@ -34,52 +161,191 @@ QtHsvRectPickerPrivate::QtHsvRectPickerPrivate(QtHsvRectPicker *q) :
     minHue = 0;
     maxHue = 359;
     cVal = 200;
+    mode = QtHsvRectPicker::Hsv;
     pos = QPoint(0, 0);
+    planeStale = false;
+    planeWatcher = new QFutureWatcher<QImage>(q);
+    QObject::connect(planeWatcher, &QFutureWatcher<QImage>::finished, q,
+                     [this]() { fullPlaneReady(); });
+
+    prefetchWatcher = new QFutureWatcher<QImage>(q);
+    QObject::connect(prefetchWatcher, &QFutureWatcher<QImage>::finished, q, [this]() {
+        cachePlane(prefetchWatcherKey, QPixmap::fromImage(prefetchWatcher->result()));
+        prefetchNext();
+    });
+
+    prefetchTimer = new QTimer(q);
+    prefetchTimer->setSingleShot(true);
+    prefetchTimer->setInterval(PREFETCH_DELAY_MS);
+    QObject::connect(prefetchTimer, &QTimer::timeout, q, [this]() { prefetchNext(); });
 }
 
-#if 0
 /*!
  * \internal
+ *
+ * Planes are served from the cache when possible. Otherwise small planes
+ * are rendered directly, and larger ones get a coarse preview right away
+ * and the full plane from the thread pool; while a render is running,
+ * further requests only mark its result stale, so a fast drag never
+ * queues more than one.
  */
 void QtHsvRectPickerPrivate::buildPixmap()
 {
-    int cy = q_ptr->contentsRect().height();
-    int cx = q_ptr->contentsRect().width();
+    const Profiler::Scope scope("QtHsvRectPicker::buildPixmap");
+    size = deviceSize();
+    if (planeWatcher->isRunning())
+        planeStale = true;
 
-    QImage img(cx, cy, QImage::Format_RGB32);
-    for (int y = 0; y < cy; y++)
-    {
-        for (int x = 0; x < cx; x++) {
-            QColor c;
-            c.setHsv(hueFromX(x), satFromY(y), cVal);
-            img.setPixel(x, y, c.rgb());
-        }
+    // Prefetching waits until requests stop coming in
+    prefetchTimer->start();
+
+    const PlaneKey key = planeKey(cVal);
+    if (const QPixmap *cached = planeCache.object(key)) {
+        pixmap = *cached;
+        return;
     }
-    pixmap = QPixmap::fromImage(img);
-    size = pixmap.size();
+
+    if (size.width() * size.height() <= DIRECT_PIXELS) {
+        updateRamp(&hueRamp, size.width());
+        pixmap = QPixmap::fromImage(renderPlaneImage(key, hueRamp));
+        cachePlane(key, pixmap);
+        return;
+    }
+
+    PlaneKey preview = key;
+    preview.size = (size / PREVIEW_SCALE).expandedTo(QSize(1, 1));
+    updateRamp(&previewRamp, preview.size.width());
+    pixmap = QPixmap::fromImage(renderPlaneImage(preview, previewRamp));
+
+    if (!planeWatcher->isRunning())
+        startFullPlane();
 }
-#endif
 
+/*!
+ * \internal
+ *
+ * Planes are rendered at device resolution, so they stay sharp on hi-DPI
+ * screens without being scaled at paint time.
+ */
+QSize QtHsvRectPickerPrivate::deviceSize() const
+{
+    const QSize logical = q_ptr->contentsRect().size();
+    const qreal dpr = q_ptr->devicePixelRatioF();
+    return QSize(qRound(logical.width() * dpr), qRound(logical.height() * dpr));
+}
 
-void QtHsvRectPickerPrivate::buildPixmap()
+/*!
+ * \internal
+ *
+ * The hue ramp only depends on the width and hue range, so a value change
+ * just re-runs the row kernel.
+ */
+void QtHsvRectPickerPrivate::updateRamp(ColorRaster::HueRamp *ramp, int width)
+{
+    if (ramp->width() != width)
+        *ramp = ColorRaster::hueRamp(width, maxHue, minHue);
+}
+
+/*!
+ * \internal
+ */
+PlaneKey QtHsvRectPickerPrivate::planeKey(int value) const
+{
+    return {mode, size, value, minHue, maxHue, minSat, maxSat,
+            qRound(q_ptr->devicePixelRatioF() * 100),
+            q_ptr->palette().color(QPalette::Window).rgb()};
+}
+
+/*!
+ * \internal
+ *
+ * Renders the full plane for \a key, which must describe the current size
+ * and ranges, on the thread pool.
+ */
+QFuture<QImage> QtHsvRectPickerPrivate::renderPlane(const PlaneKey &key)
+{
+    updateRamp(&hueRamp, key.size.width());
+
+    // The ramp is implicitly shared; the worker only reads its copy
+    const ColorRaster::HueRamp ramp = hueRamp;
+    return QtConcurrent::run([ramp, key]() {
+        const Profiler::Scope scope("QtHsvRectPicker::renderPlane");
+        return renderPlaneImage(key, ramp);
+    });
+}
+
+/*!
+ * \internal
+ */
+void QtHsvRectPickerPrivate::cachePlane(const PlaneKey &key, const QPixmap &plane)
+{
+    // Planes larger than the whole budget are dropped by the cache itself
+    planeCache.insert(key, new QPixmap(plane), planeCost(key.size));
+}
+
+/*!
+ * \internal
+ */
+void QtHsvRectPickerPrivate::startFullPlane()
+{
+    planeStale = false;
+    planeWatcherKey = planeKey(cVal);
+    planeWatcher->setFuture(renderPlane(planeWatcherKey));
+}
+
+/*!
+ * \internal
+ */
+void QtHsvRectPickerPrivate::fullPlaneReady()
+{
+    const QPixmap plane = QPixmap::fromImage(planeWatcher->result());
+    cachePlane(planeWatcherKey, plane);
+
+    if (planeStale) {
+        planeStale = false;
+        // Nothing to do unless a preview of the latest state is showing
+        if (pixmap.size() == size)
+            return;
+        if (const QPixmap *cached = planeCache.object(planeKey(cVal))) {
+            pixmap = *cached;
+            q_ptr->update();
+        } else {
+            startFullPlane();
+        }
+        return;
+    }
+
+    pixmap = plane;
+    q_ptr->update();
+    prefetchNext();
+}
+
+/*!
+ * \internal
+ *
+ * Renders the nearest uncached values around the current one, one at a
+ * time, until the user becomes active again. At most half the budget is
+ * spent on planes nobody asked for yet.
+ */
+void QtHsvRectPickerPrivate::prefetchNext()
 {
-    int cx = q_ptr->contentsRect().width();
-    int cy = q_ptr->contentsRect().height();
-
-    int hueDiff = (maxHue - minHue);
-    int satDiff = (maxSat - minSat);
-    QColor c;
-    QImage img(cx, cy, QImage::Format_RGB32);
-    for (int y = 0; y < cy; y++)
-    {
-        QRgb* line = reinterpret_cast<QRgb*>(img.scanLine(y));
-        for (int x = 0; x < cx; x++) {
-            c.setHsv(maxHue - ((x * hueDiff) / cx), maxSat - ((y * satDiff) / cy), cVal);
-            line[x] = c.rgb();
+    if (prefetchTimer->isActive() || planeWatcher->isRunning() ||
+        prefetchWatcher->isRunning() || size.isEmpty() || !q_ptr->isVisible())
+        return;
+
+    const int radius = qMin(PREFETCH_RADIUS, planeCache.maxCost() / (4 * planeCost(size)));
+    for (int step = 1; step <= radius; ++step) {
+        for (int value : {cVal + step, cVal - step}) {
+            if (value < 0 || value > 255)
+                continue;
+            const PlaneKey key = planeKey(value);
+            if (planeCache.contains(key))
+                continue;
+            prefetchWatcherKey = key;
+            prefetchWatcher->setFuture(renderPlane(key));
+            return;
         }
     }
-    pixmap = QPixmap::fromImage(img);
-    size = pixmap.size();
 }
 
 /*!
@@ -121,6 +387,102 @@ int QtHsvRectPickerPrivate::hueToX(int h) const
 
 
 
+/*!
+ * \internal
+ *
+ * Returns the color under \a pt, relative to the contents rectangle, or
+ * an invalid color outside the plane or the sRGB gamut.
+ */
+QColor QtHsvRectPickerPrivate::colorAt(const QPoint &pt) const
+{
+    switch (mode) {
+    case QtHsvRectPicker::Hsv:
+    case QtHsvRectPicker::Hsl: {
+        int h = hueFromX(pt.x());
+        int s = satFromY(pt.y());
+        if (h<0 || s<0 || h>359 || s>255)
+            return QColor();
+        return mode == QtHsvRectPicker::Hsv ? QColor::fromHsv(h, s, cVal)
+                                            : QColor::fromHsl(h, s, cVal);
+    }
+    case QtHsvRectPicker::Oklch:
+    case QtHsvRectPicker::Lab:
+        break;
+    }
+
+    const QRect rect = q_ptr->contentsRect();
+    if (rect.isEmpty())
+        return QColor();
+    const float fx = float(pt.x()) / rect.width();
+    const float fy = float(pt.y()) / rect.height();
+    if (fx < 0 || fx > 1 || fy < 0 || fy > 1)
+        return QColor();
+
+    if (mode == QtHsvRectPicker::Oklch) {
+        const float hue = qDegreesToRadians(maxHue + (minHue - maxHue) * fx);
+        const float chroma = MAX_OKLCH_CHROMA * (maxSat + (minSat - maxSat) * fy) / 255.0f;
+        return fromLinearRgb(ColorSpace::oklabToLinearRgb(
+            {cVal / 255.0f, chroma * std::cos(hue), chroma * std::sin(hue)}));
+    }
+    return fromLinearRgb(ColorSpace::labToLinearRgb(
+        {cVal / 255.0f * 100.0f, LAB_AB_RANGE * (2 * fx - 1), LAB_AB_RANGE * (1 - 2 * fy)}));
+}
+
+/*!
+ * \internal
+ *
+ * Returns where \a c lies on the plane, relative to the contents rectangle.
+ */
+QPoint QtHsvRectPickerPrivate::positionOf(const QColor &c) const
+{
+    const QRect rect = q_ptr->contentsRect();
+
+    switch (mode) {
+    case QtHsvRectPicker::Hsv:
+        return QPoint(hueToX(c.hsvHue()), satToY(c.hsvSaturation()));
+    case QtHsvRectPicker::Hsl:
+        return QPoint(hueToX(c.hslHue()), satToY(c.hslSaturation()));
+    case QtHsvRectPicker::Oklch: {
+        const ColorSpace::Lab lab = ColorSpace::toOklab(c);
+        float hue = qRadiansToDegrees(std::atan2(lab.b, lab.a));
+        if (hue < 0)
+            hue += 360.0f;
+        const float sat = 255.0f * std::hypot(lab.a, lab.b) / MAX_OKLCH_CHROMA;
+        const float fx = (maxHue - hue) / qMax(1, maxHue - minHue);
+        const float fy = (maxSat - sat) / qMax(1, maxSat - minSat);
+        return QPoint(qRound(fx * rect.width()), qRound(fy * rect.height()));
+    }
+    case QtHsvRectPicker::Lab: {
+        const ColorSpace::Lab lab = ColorSpace::toLab(c);
+        const float fx = (lab.a / LAB_AB_RANGE + 1) / 2;
+        const float fy = (1 - lab.b / LAB_AB_RANGE) / 2;
+        return QPoint(qRound(fx * rect.width()), qRound(fy * rect.height()));
+    }
+    }
+    return QPoint();
+}
+
+/*!
+ * \internal
+ *
+ * Returns the component of \a c the plane keeps fixed, scaled to 0-255.
+ */
+int QtHsvRectPickerPrivate::valueOf(const QColor &c) const
+{
+    switch (mode) {
+    case QtHsvRectPicker::Hsv:
+        return c.value();
+    case QtHsvRectPicker::Hsl:
+        return c.lightness();
+    case QtHsvRectPicker::Oklch:
+        return qBound(0, qRound(ColorSpace::toOklab(c).L * 255.0f), 255);
+    case QtHsvRectPicker::Lab:
+        return qBound(0, qRound(ColorSpace::toLab(c).L * 2.55f), 255);
+    }
+    return c.value();
+}
+
+
 /*!
  *  \class QtHsvRectPicker
  *  \inmodule wwWidgets
@@ -139,6 +501,16 @@ int QtHsvRectPickerPrivate::hueToX(int h) const
  *  The range of allowed values for this property is 0-255. The default value is 220.
  */
 
+/*!
+ *  \property   QtHsvRectPicker::planeMode
+ *  \brief      This property holds the color model the plane shows.
+ *
+ *  HSV and HSL planes show hue against saturation, OKLCH hue against
+ *  chroma, and CIELAB a against b. The value property holds the remaining
+ *  component. Colors the perceptual planes cannot show in sRGB are masked
+ *  with the window color. The default is Hsv.
+ */
+
 /*!
  *  \property   QtHsvRectPicker::color
  *  \brief      This property holds the currently chosen color.
@@ -219,6 +591,28 @@ void QtHsvRectPicker::setValue(int v)
     update();
 }
 
+/*!
+ *  \brief Returns the memory budget of the plane cache in KiB
+ */
+int QtHsvRectPicker::cacheBudget() const
+{
+    const QtHsvRectPickerPrivate *d = d_ptr;
+    return d->planeCache.maxCost();
+}
+
+/*!
+ *  \brief Sets the memory budget of the plane cache to \a kib KiB
+ *
+ *  Rendered planes are kept per value, size and range, so returning to a
+ *  brightness does not render it again. Zero disables caching and
+ *  prefetching.
+ */
+void QtHsvRectPicker::setCacheBudget(int kib)
+{
+    QtHsvRectPickerPrivate *d = d_ptr;
+    d->planeCache.setMaxCost(qMax(0, kib));
+}
+
 /*!
  * \internal
  */
@@ -246,14 +640,28 @@ QSize QtHsvRectPicker::minimumSizeHint() const {
  */
 void QtHsvRectPicker::paintEvent(QPaintEvent *)
 {
+    const Profiler::Scope scope("QtHsvRectPicker::paintEvent");
     QtHsvRectPickerPrivate *d = d_ptr;
+
+    // Moved to a screen with another pixel ratio
+    if (d->size != d->deviceSize())
+        d->buildPixmap();
+
     QPainter p(this);
     drawFrame(&p);
     QRect rct = contentsRect();
     QStyleOptionFrame opt;
     opt.initFrom(this);
     if (opt.state & QStyle::State_Enabled) {
-        p.drawPixmap(rct.topLeft(), d->pixmap);
+        if (d->pixmap.size() == d->size) {
+            p.drawPixmap(rct.topLeft(), d->pixmap);
+        } else {
+            // Preview while the full plane is rendering
+            p.save();
+            p.setRenderHint(QPainter::SmoothPixmapTransform);
+            p.drawPixmap(rct, d->pixmap);
+            p.restore();
+        }
         drawCrosshair(&p, d->pos);
     } else {
         QIcon i(d->pixmap);
@@ -271,13 +679,12 @@ void QtHsvRectPicker::mousePressEvent(QMouseEvent * e)
     QtHsvRectPickerPrivate *d = d_ptr;
     if (e->button() == Qt::LeftButton) {
         QPoint pt = e->pos();
-        int h = d->hueFromX(pt.x()-contentsRect().x());
-        int s = d->satFromY(pt.y()-contentsRect().y());
-        if (h<0 || s<0 || h>359 || s>255)
+        const QColor c = d->colorAt(pt - contentsRect().topLeft());
+        if (!c.isValid())
             return;
 
         d->pos = pt;
-        d->color = QColor::fromHsv(h, s, d->cVal);
+        d->color = c;
         emit colorChanged(d->color);
 
         update();
@@ -295,13 +702,12 @@ void QtHsvRectPicker::mouseMoveEvent(QMouseEvent * e)
         QPoint pt = e->pos();
         if (!contentsRect().contains(pt))
             return;
-        int h = d->hueFromX(pt.x()-contentsRect().x());
-        int s = d->satFromY(pt.y()-contentsRect().y());
-        if (h<0 || s<0 || h>359 || s>255)
+        const QColor c = d->colorAt(pt - contentsRect().topLeft());
+        if (!c.isValid())
             return;
 
         d->pos = pt;
-        d->color = QColor::fromHsv(h, s, d->cVal);
+        d->color = c;
         emit colorChanged(d->color);
 
         update();
@@ -377,6 +783,8 @@ void QtHsvRectPicker::setHueRange(int mi, int ma)
     if (miC || maC) emit hueRangeChanged(mi, ma);
     else return;
 
+    d->hueRamp = ColorRaster::HueRamp();
+    d->previewRamp = ColorRaster::HueRamp();
     updateGeometry();
     d->buildPixmap();
     update();
@@ -423,25 +831,32 @@ void QtHsvRectPicker::setColor(const QColor &c, const bool changeBrightness) {
     if (d->color == c)
         return;
 
-    c.getHsv(&h, &s, &v);
     if (changeBrightness) {
+        v = d->valueOf(c);
         if (d->cVal != v)
             setValue(v);
     }
 
-    int Hspan = d->maxHue - d->minHue;
-    int Sspan = d->maxSat - d->minSat;
-    if (s < (d->minSat) || s>(d->maxSat)) {
-        int ss = qMax(0, s-Sspan/2);
-        setSatRange(ss, ss+Sspan);
-    }
-    if (h < (d->minHue) || h>(d->maxHue)) {
-        int hh = qMax(0, h-Hspan/2);
-        setHueRange(hh, hh+Hspan);
+    // Bring the color into the visible ranges of the hue planes
+    if (d->mode == Hsv || d->mode == Hsl) {
+        if (d->mode == Hsv)
+            c.getHsv(&h, &s, &v);
+        else
+            c.getHsl(&h, &s, &v);
+
+        int Hspan = d->maxHue - d->minHue;
+        int Sspan = d->maxSat - d->minSat;
+        if (s < (d->minSat) || s>(d->maxSat)) {
+            int ss = qMax(0, s-Sspan/2);
+            setSatRange(ss, ss+Sspan);
+        }
+        if (h < (d->minHue) || h>(d->maxHue)) {
+            int hh = qMax(0, h-Hspan/2);
+            setHueRange(hh, hh+Hspan);
+        }
     }
 
-    d->pos.setX(d->hueToX(h));
-    d->pos.setY(d->satToY(s));
+    d->pos = d->positionOf(c);
     d->color = c;
     emit colorChanged(c);
 
@@ -459,19 +874,64 @@ void QtHsvRectPicker::resizeEvent(QResizeEvent *re)
 
     QFrame::resizeEvent(re);
 
-    QSize s = re->size();
-    float xs = s.width() * 1.0 / (d->maxHue - d->minHue); // pixels per hue
-    float x = d->color.hue() * xs;
+    if (d->color.isValid())
+        d->pos = d->positionOf(d->color);
 
-    float ys = s.height() * 1.0 / (d->maxSat - d->minSat); // pixels per sat
-    float y = d->color.saturation() * ys;
+    d->buildPixmap();
 
-    d->pos.setX(static_cast<int>(s.width() - x));
-    d->pos.setY(static_cast<int>(s.height() - y));
+    update();
+}
 
-    d->buildPixmap();
+/*!
+ *  \brief Shows the plane in \a mode; the value and color are kept
+ */
+void QtHsvRectPicker::setPlaneMode(PlaneMode mode)
+{
+    QtHsvRectPickerPrivate *d = d_ptr;
+    if (d->mode == mode)
+        return;
 
+    d->mode = mode;
+    if (d->color.isValid())
+        d->pos = d->positionOf(d->color);
+    d->buildPixmap();
     update();
+    emit planeModeChanged(mode);
+}
+
+QtHsvRectPicker::PlaneMode QtHsvRectPicker::planeMode() const
+{
+    const QtHsvRectPickerPrivate *d = d_ptr;
+    return d->mode;
+}
+
+/*!
+ * \internal
+ */
+void QtHsvRectPicker::contextMenuEvent(QContextMenuEvent *e)
+{
+    QtHsvRectPickerPrivate *d = d_ptr;
+
+    static const struct {
+        PlaneMode mode;
+        const char *text;
+    } modes[] = {
+        {Hsv, QT_TR_NOOP("HSV")},
+        {Hsl, QT_TR_NOOP("HSL")},
+        {Oklch, QT_TR_NOOP("OKLCH")},
+        {Lab, QT_TR_NOOP("CIELAB")},
+    };
+
+    QMenu menu(this);
+    for (const auto &entry : modes) {
+        QAction *action = menu.addAction(tr(entry.text));
+        action->setCheckable(true);
+        action->setChecked(d->mode == entry.mode);
+        action->setData(int(entry.mode));
+    }
+
+    if (QAction *chosen = menu.exec(e->globalPos()))
+        setPlaneMode(PlaneMode(chosen->data().toInt()));
 }
 
 QColor QtHsvRectPicker::color() const
@@ -0,0 +1,148 @@
+#include "../include/Checkerboard.h"
+#include "../include/PaletteWidget.h"
+#include <QImage>
+#include <QPainter>
+#include <QStandardItemModel>
+#include <QtTest>
+
+namespace {
+
+// Palette view layout: 40 px swatches, 8 px apart, in a 960 px wide view
+constexpr int SWATCH = SwatchDelegate::SWATCH_SIZE;
+constexpr int STEP = SWATCH + 8;
+constexpr int COLUMNS = 20;
+
+// Checkerboard as the widgets drew it before Checkerboard existed: white,
+// then one fillRect per gray cell on every paint
+void paintCellByCell(QPainter *painter, const QRect &rect, int checkerSize) {
+  painter->fillRect(rect, Qt::white);
+  for (int y = 0; y < rect.height(); y += checkerSize) {
+    for (int x = 0; x < rect.width(); x += checkerSize) {
+      if ((x / checkerSize + y / checkerSize) % 2 == 0) {
+        painter->fillRect(rect.x() + x, rect.y() + y, checkerSize, checkerSize,
+                          QColor(204, 204, 204));
+      }
+    }
+  }
+}
+
+// SwatchDelegate::paint before it used Checkerboard::paint
+void paintSwatchCellByCell(QPainter *painter, const QStyleOptionViewItem &option,
+                           const QModelIndex &index) {
+  const QRect rect = option.rect;
+  const QColor color = index.data(Qt::DecorationRole).value<QColor>();
+
+  painter->save();
+  paintCellByCell(painter, rect, 5);
+  painter->fillRect(rect, color);
+  const bool hovered = option.state & QStyle::State_MouseOver;
+  painter->setPen(
+      QPen(hovered ? QColor(60, 60, 60) : QColor(136, 136, 136), 1));
+  painter->drawRect(rect.adjusted(0, 0, -1, -1));
+  painter->restore();
+}
+
+// Half-transparent colors, so the checkerboard shows through every swatch
+QStandardItemModel *swatchModel(int count, QObject *parent) {
+  auto *model = new QStandardItemModel(count, 1, parent);
+  for (int i = 0; i < count; ++i) {
+    model->setData(model->index(i, 0),
+                   QColor::fromHsv(i * 360 / count, 200, 220, 128),
+                   Qt::DecorationRole);
+  }
+  return model;
+}
+
+QRect swatchRect(int i) {
+  return QRect((i % COLUMNS) * STEP, (i / COLUMNS) * STEP, SWATCH, SWATCH);
+}
+
+QImage gridImage(int count) {
+  const int rows = (count + COLUMNS - 1) / COLUMNS;
+  QImage image(COLUMNS * STEP, rows * STEP, QImage::Format_ARGB32_Premultiplied);
+  image.fill(Qt::transparent);
+  return image;
+}
+
+} // namespace
+
+class TestCheckerboard : public QObject {
+  Q_OBJECT
+
+private slots:
+  void matchesCellByCell_data();
+  void matchesCellByCell();
+
+  // A full palette grid painted through the swatch delegate, with the
+  // checkerboard drawn cell by cell and as one tiled fillRect
+  void benchmarkPaletteGrid_data();
+  void benchmarkPaletteGrid();
+};
+
+void TestCheckerboard::matchesCellByCell_data() {
+  QTest::addColumn<int>("cellSize");
+  QTest::addColumn<QRect>("rect");
+
+  // The old loop let the last cell spill over the edge, so only sizes that
+  // are whole cells can be compared
+  QTest::newRow("swatch") << 5 << QRect(0, 0, SWATCH, SWATCH);
+  QTest::newRow("swatch, offset") << 5 << QRect(STEP + 3, 7, SWATCH, SWATCH);
+  QTest::newRow("preview") << 10 << QRect(11, 5, 120, 60);
+  QTest::newRow("popup") << 15 << QRect(2, 9, 90, 45);
+}
+
+void TestCheckerboard::matchesCellByCell() {
+  QFETCH(int, cellSize);
+  QFETCH(QRect, rect);
+
+  QImage expected(160, 80, QImage::Format_ARGB32_Premultiplied);
+  expected.fill(Qt::transparent);
+  QImage actual = expected;
+  {
+    QPainter painter(&expected);
+    paintCellByCell(&painter, rect, cellSize);
+  }
+  {
+    QPainter painter(&actual);
+    Checkerboard::paint(&painter, rect, cellSize);
+  }
+  QCOMPARE(actual, expected);
+}
+
+void TestCheckerboard::benchmarkPaletteGrid_data() {
+  QTest::addColumn<bool>("tiled");
+  QTest::addColumn<int>("count");
+
+  QTest::newRow("cell by cell, 100") << false << 100;
+  QTest::newRow("tiled, 100") << true << 100;
+  QTest::newRow("cell by cell, 1000") << false << 1000;
+  QTest::newRow("tiled, 1000") << true << 1000;
+}
+
+void TestCheckerboard::benchmarkPaletteGrid() {
+  QFETCH(bool, tiled);
+  QFETCH(int, count);
+
+  SwatchDelegate delegate;
+  QStandardItemModel *model = swatchModel(count, &delegate);
+  QImage image = gridImage(count);
+  QPainter painter(&image);
+
+  QStyleOptionViewItem option;
+  option.state = QStyle::State_Enabled;
+
+  QBENCHMARK {
+    for (int i = 0; i < count; ++i) {
+      option.rect = swatchRect(i);
+      const QModelIndex index = model->index(i, 0);
+      if (tiled) {
+        delegate.paint(&painter, option, index);
+      } else {
+        paintSwatchCellByCell(&painter, option, index);
+      }
+    }
+  }
+}
+
+QTEST_MAIN(TestCheckerboard)
+#include "tst_checkerboard.moc"
@@ -0,0 +1,274 @@
+#include "../include/ColorDifference.h"
+#include <QRandomGenerator>
+#include <QtTest>
+#include <vector>
+
+namespace {
+
+using Lab = ColorDifference::Lab;
+
+// Spread over the CIELAB gamut and a little beyond it
+QVector<Lab> randomLab(QRandomGenerator *rng, int count) {
+  QVector<Lab> colors;
+  colors.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    colors.append({float(rng->bounded(100.0)), float(rng->bounded(256.0) - 128.0),
+                   float(rng->bounded(256.0) - 128.0)});
+  }
+  return colors;
+}
+
+// Float rounding between the SIMD kernels and the single-pair formulas
+bool fuzzyEqual(float actual, float expected) {
+  return qAbs(actual - expected) <= 1e-4f * qMax(1.0f, expected);
+}
+
+} // namespace
+
+Q_DECLARE_METATYPE(ColorDifference::Metric)
+
+class TestColorDifference : public QObject {
+  Q_OBJECT
+
+private slots:
+  void ciede2000Reference_data();
+  void ciede2000Reference();
+  void knownDistances();
+
+  void rowsMatchSinglePairs_data();
+  void rowsMatchSinglePairs();
+  void matrixMatchesRows_data();
+  void matrixMatchesRows();
+
+  void paletteDistance();
+  void removeNearDuplicates();
+
+  void benchmarkMatrix_data();
+  void benchmarkMatrix();
+};
+
+void TestColorDifference::ciede2000Reference_data() {
+  QTest::addColumn<float>("L1");
+  QTest::addColumn<float>("a1");
+  QTest::addColumn<float>("b1");
+  QTest::addColumn<float>("L2");
+  QTest::addColumn<float>("a2");
+  QTest::addColumn<float>("b2");
+  QTest::addColumn<double>("expected");
+  // Pairs 10 and 14 are exactly 180 degrees apart in hue, where the mean hue
+  // flips by 180; in float either side of the boundary is a correct answer
+  QTest::addColumn<double>("boundary");
+
+  // Sharma, Wu and Dalal, "The CIEDE2000 Color-Difference Formula:
+  // Implementation Notes, Supplementary Test Data, and Mathematical
+  // Observations", Table 1
+  const struct {
+    float L1, a1, b1, L2, a2, b2;
+    double expected;
+    double boundary;
+  } pairs[] = {
+      {50.0f, 2.6772f, -79.7751f, 50.0f, 0.0f, -82.7485f, 2.0425, 0},
+      {50.0f, 3.1571f, -77.2803f, 50.0f, 0.0f, -82.7485f, 2.8615, 0},
+      {50.0f, 2.8361f, -74.0200f, 50.0f, 0.0f, -82.7485f, 3.4412, 0},
+      {50.0f, -1.3802f, -84.2814f, 50.0f, 0.0f, -82.7485f, 1.0000, 0},
+      {50.0f, -1.1848f, -84.8006f, 50.0f, 0.0f, -82.7485f, 1.0000, 0},
+      {50.0f, -0.9009f, -85.5211f, 50.0f, 0.0f, -82.7485f, 1.0000, 0},
+      {50.0f, 0.0f, 0.0f, 50.0f, -1.0f, 2.0f, 2.3669, 0},
+      {50.0f, -1.0f, 2.0f, 50.0f, 0.0f, 0.0f, 2.3669, 0},
+      {50.0f, 2.4900f, -0.0010f, 50.0f, -2.4900f, 0.0009f, 7.1792, 0},
+      {50.0f, 2.4900f, -0.0010f, 50.0f, -2.4900f, 0.0010f, 7.1792, 7.2195},
+      {50.0f, 2.4900f, -0.0010f, 50.0f, -2.4900f, 0.0011f, 7.2195, 0},
+      {50.0f, 2.4900f, -0.0010f, 50.0f, -2.4900f, 0.0012f, 7.2195, 0},
+      {50.0f, -0.0010f, 2.4900f, 50.0f, 0.0009f, -2.4900f, 4.8045, 0},
+      {50.0f, -0.0010f, 2.4900f, 50.0f, 0.0010f, -2.4900f, 4.8045, 4.7461},
+      {50.0f, -0.0010f, 2.4900f, 50.0f, 0.0011f, -2.4900f, 4.7461, 0},
+      {50.0f, 2.5f, 0.0f, 50.0f, 0.0f, -2.5f, 4.3065, 0},
+      {50.0f, 2.5f, 0.0f, 73.0f, 25.0f, -18.0f, 27.1492, 0},
+      {50.0f, 2.5f, 0.0f, 61.0f, -5.0f, 29.0f, 22.8977, 0},
+      {50.0f, 2.5f, 0.0f, 56.0f, -27.0f, -3.0f, 31.9030, 0},
+      {50.0f, 2.5f, 0.0f, 58.0f, 24.0f, 15.0f, 19.4535, 0},
+      {50.0f, 2.5f, 0.0f, 50.0f, 3.1736f, 0.5854f, 1.0000, 0},
+      {50.0f, 2.5f, 0.0f, 50.0f, 3.2972f, 0.0f, 1.0000, 0},
+      {50.0f, 2.5f, 0.0f, 50.0f, 1.8634f, 0.5757f, 1.0000, 0},
+      {50.0f, 2.5f, 0.0f, 50.0f, 3.2592f, 0.3350f, 1.0000, 0},
+      {60.2574f, -34.0099f, 36.2677f, 60.4626f, -34.1751f, 39.4387f, 1.2644, 0},
+      {63.0109f, -31.0961f, -5.8663f, 62.8187f, -29.7946f, -4.0864f, 1.2630, 0},
+      {61.2901f, 3.7196f, -5.3901f, 61.4292f, 2.2480f, -4.9620f, 1.8731, 0},
+      {35.0831f, -44.1164f, 3.7933f, 35.0232f, -40.0716f, 1.5901f, 1.8645, 0},
+      {22.7233f, 20.0904f, -46.6940f, 23.0331f, 14.9730f, -42.5619f, 2.0373, 0},
+      {36.4612f, 47.8580f, 18.3852f, 36.2715f, 50.5065f, 21.2231f, 1.4146, 0},
+      {90.8027f, -2.0831f, 1.4410f, 91.1528f, -1.6435f, 0.0447f, 1.4441, 0},
+      {90.9257f, -0.5406f, -0.9208f, 88.6381f, -0.8985f, -0.7239f, 1.5381, 0},
+      {6.7747f, -0.2908f, -2.4247f, 5.8714f, -0.0985f, -2.2286f, 0.6377, 0},
+      {2.0776f, 0.0795f, -1.1350f, 0.9033f, -0.0636f, -0.5514f, 0.9082, 0},
+  };
+
+  int row = 0;
+  for (const auto &pair : pairs) {
+    QTest::addRow("pair %d", ++row)
+        << pair.L1 << pair.a1 << pair.b1 << pair.L2 << pair.a2 << pair.b2
+        << pair.expected << pair.boundary;
+  }
+}
+
+void TestColorDifference::ciede2000Reference() {
+  QFETCH(float, L1);
+  QFETCH(float, a1);
+  QFETCH(float, b1);
+  QFETCH(float, L2);
+  QFETCH(float, a2);
+  QFETCH(float, b2);
+  QFETCH(double, expected);
+  QFETCH(double, boundary);
+
+  const Lab first{L1, a1, b1};
+  const Lab second{L2, a2, b2};
+
+  // The table is rounded to four places, and the formula is symmetric
+  for (float actual :
+       {ColorDifference::deltaE(first, second, ColorDifference::CIEDE2000),
+        ColorDifference::deltaE(second, first, ColorDifference::CIEDE2000)}) {
+    const bool matches = qAbs(actual - expected) < 1e-3 ||
+                         (boundary > 0 && qAbs(actual - boundary) < 1e-3);
+    if (!matches) {
+      qWarning() << "Delta E" << actual << "expected" << expected;
+    }
+    QVERIFY(matches);
+  }
+}
+
+void TestColorDifference::knownDistances() {
+  const Lab gray{50.0f, 0.0f, 0.0f};
+  const Lab tinted{50.0f, 3.0f, 4.0f};
+  QCOMPARE(ColorDifference::deltaE(gray, tinted, ColorDifference::CIE76), 5.0f);
+
+  // With no chroma on either side CIE94 is the lightness difference
+  const Lab darker{40.0f, 0.0f, 0.0f};
+  QCOMPARE(ColorDifference::deltaE(gray, darker, ColorDifference::CIE94), 10.0f);
+
+  for (ColorDifference::Metric metric :
+       {ColorDifference::CIE76, ColorDifference::CIE94,
+        ColorDifference::CIEDE2000}) {
+    QCOMPARE(ColorDifference::deltaE(QColor(Qt::red), QColor(Qt::red), metric),
+             0.0f);
+  }
+}
+
+void TestColorDifference::rowsMatchSinglePairs_data() {
+  QTest::addColumn<ColorDifference::Metric>("metric");
+
+  QTest::newRow("CIE76") << ColorDifference::CIE76;
+  QTest::newRow("CIE94") << ColorDifference::CIE94;
+  QTest::newRow("CIEDE2000") << ColorDifference::CIEDE2000;
+}
+
+void TestColorDifference::rowsMatchSinglePairs() {
+  QFETCH(ColorDifference::Metric, metric);
+
+  // Not a multiple of four, so the SSE2 blocks and the scalar tail both run
+  QRandomGenerator rng(1);
+  const QVector<Lab> samples = randomLab(&rng, 103);
+
+  for (const Lab &reference : randomLab(&rng, 20)) {
+    const QVector<float> row =
+        ColorDifference::distances(reference, samples, metric);
+    QCOMPARE(row.size(), samples.size());
+    for (int i = 0; i < samples.size(); ++i) {
+      const float expected = ColorDifference::deltaE(reference, samples[i], metric);
+      if (!fuzzyEqual(row[i], expected)) {
+        qWarning() << "Column" << i << "is" << row[i] << "expected" << expected;
+      }
+      QVERIFY(fuzzyEqual(row[i], expected));
+    }
+  }
+}
+
+void TestColorDifference::matrixMatchesRows_data() {
+  QTest::addColumn<ColorDifference::Metric>("metric");
+  QTest::addColumn<int>("rows");
+  QTest::addColumn<int>("columns");
+
+  QTest::newRow("CIE76 serial") << ColorDifference::CIE76 << 30 << 41;
+  QTest::newRow("CIE76 parallel") << ColorDifference::CIE76 << 301 << 299;
+  QTest::newRow("CIE94 parallel") << ColorDifference::CIE94 << 301 << 299;
+  QTest::newRow("CIEDE2000 parallel") << ColorDifference::CIEDE2000 << 301 << 299;
+  QTest::newRow("no rows") << ColorDifference::CIE76 << 0 << 10;
+  QTest::newRow("no columns") << ColorDifference::CIE76 << 10 << 0;
+}
+
+void TestColorDifference::matrixMatchesRows() {
+  QFETCH(ColorDifference::Metric, metric);
+  QFETCH(int, rows);
+  QFETCH(int, columns);
+
+  QRandomGenerator rng(2);
+  const QVector<Lab> first = randomLab(&rng, rows);
+  const QVector<Lab> second = randomLab(&rng, columns);
+
+  // Row-major, whichever thread computed the band
+  const QVector<float> matrix =
+      ColorDifference::distanceMatrix(first, second, metric);
+  QCOMPARE(int(matrix.size()), rows * columns);
+  for (int r = 0; r < rows; ++r) {
+    const QVector<float> row =
+        ColorDifference::distances(first[r], second, metric);
+    for (int c = 0; c < columns; ++c) {
+      QCOMPARE(matrix[r * columns + c], row[c]);
+    }
+  }
+}
+
+void TestColorDifference::paletteDistance() {
+  const QVector<QColor> warm = {Qt::red, QColor(255, 128, 0), Qt::yellow};
+  QCOMPARE(ColorDifference::paletteDistance(warm, warm), 0.0f);
+  QCOMPARE(ColorDifference::paletteDistance(warm, {}), 0.0f);
+
+  // Each color counts the distance to its nearest match in the other palette
+  const QVector<QColor> red = {Qt::red};
+  const QVector<QColor> redBlue = {Qt::red, Qt::blue};
+  const float redToBlue = ColorDifference::deltaE(QColor(Qt::red), QColor(Qt::blue));
+  QVERIFY(qAbs(ColorDifference::paletteDistance(red, redBlue) - redToBlue / 3.0f) <
+          1e-4f);
+  QCOMPARE(ColorDifference::paletteDistance(red, redBlue),
+           ColorDifference::paletteDistance(redBlue, red));
+}
+
+void TestColorDifference::removeNearDuplicates() {
+  const QVector<QColor> colors = {Qt::red,   QColor(254, 1, 0), Qt::blue,
+                                  Qt::red,   QColor(0, 0, 253), Qt::white};
+
+  // The first of each cluster is kept, in palette order
+  QCOMPARE(ColorDifference::removeNearDuplicates(colors, 2.0f),
+           QVector<QColor>({Qt::red, Qt::blue, Qt::white}));
+
+  // Only colors strictly closer than the threshold go
+  QCOMPARE(ColorDifference::removeNearDuplicates(colors, 0.0f), colors);
+
+  QVERIFY(ColorDifference::removeNearDuplicates({}, 2.0f).isEmpty());
+}
+
+void TestColorDifference::benchmarkMatrix_data() {
+  QTest::addColumn<ColorDifference::Metric>("metric");
+
+  QTest::newRow("CIE76") << ColorDifference::CIE76;
+  QTest::newRow("CIE94") << ColorDifference::CIE94;
+  QTest::newRow("CIEDE2000") << ColorDifference::CIEDE2000;
+}
+
+void TestColorDifference::benchmarkMatrix() {
+  QFETCH(ColorDifference::Metric, metric);
+
+  // 10k x 10k, written into one preallocated 400 MB buffer
+  constexpr int size = 10000;
+  QRandomGenerator rng(3);
+  const QVector<Lab> rows = randomLab(&rng, size);
+  const QVector<Lab> columns = randomLab(&rng, size);
+  std::vector<float> result(size_t(size) * size);
+
+  QBENCHMARK {
+    ColorDifference::distanceMatrix(rows, columns, metric, result.data());
+  }
+}
+
+QTEST_GUILESS_MAIN(TestColorDifference)
+#include "tst_colordifference.moc"
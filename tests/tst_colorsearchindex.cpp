@@ -0,0 +1,289 @@
+#include "../include/ColorSearchIndex.h"
+#include <QRandomGenerator>
+#include <QSet>
+#include <QtTest>
+#include <algorithm>
+#include <memory>
+
+namespace {
+
+// Palette handles are the position in the list plus one
+using Palettes = QVector<QVector<PackedColor>>;
+
+PackedColor randomColor(QRandomGenerator *rng) {
+  return ColorLogic::packedFromRgbF(float(rng->generateDouble()),
+                                    float(rng->generateDouble()),
+                                    float(rng->generateDouble()));
+}
+
+Palettes randomPalettes(QRandomGenerator *rng, int count, int colors) {
+  Palettes palettes(count);
+  for (QVector<PackedColor> &palette : palettes) {
+    palette.reserve(colors);
+    for (int i = 0; i < colors; ++i) {
+      palette.append(randomColor(rng));
+    }
+  }
+  return palettes;
+}
+
+void indexAll(ColorSearchIndex *index, const Palettes &palettes) {
+  for (int p = 0; p < palettes.size(); ++p) {
+    index->setPaletteColors(PaletteHandle(p + 1), palettes[p]);
+  }
+}
+
+float distance(const ColorDifference::Lab &query, const PackedColor &color) {
+  return ColorDifference::deltaE(
+      query,
+      ColorDifference::toSpace(ColorLogic::fromPacked(color),
+                               ColorDifference::OKLab),
+      ColorDifference::CIE76);
+}
+
+// Every distance to the query, nearest first
+QVector<float> bruteForce(const Palettes &palettes, const QColor &query) {
+  const ColorDifference::Lab q =
+      ColorDifference::toSpace(query, ColorDifference::OKLab);
+  QVector<float> distances;
+  for (const QVector<PackedColor> &palette : palettes) {
+    for (const PackedColor &color : palette) {
+      distances.append(distance(q, color));
+    }
+  }
+  std::sort(distances.begin(), distances.end());
+  return distances;
+}
+
+// The index holds exactly the colors of palettes, each under its own
+// palette and position
+void verifyIndex(const ColorSearchIndex &index, const Palettes &palettes) {
+  int total = 0;
+  for (const QVector<PackedColor> &palette : palettes) {
+    total += int(palette.size());
+  }
+  QCOMPARE(index.size(), total);
+
+  // Wide enough to take in the whole grid
+  const QColor probe(128, 128, 128);
+  const ColorDifference::Lab q =
+      ColorDifference::toSpace(probe, ColorDifference::OKLab);
+  const QVector<ColorSearchIndex::Match> matches =
+      index.withinRadius(probe, 1000.0f);
+  QCOMPARE(int(matches.size()), total);
+
+  QSet<quint64> seen;
+  for (const ColorSearchIndex::Match &match : matches) {
+    const int p = int(match.palette) - 1;
+    QVERIFY(p >= 0 && p < palettes.size());
+    QVERIFY(match.index >= 0 && match.index < palettes[p].size());
+
+    const quint64 key = (quint64(match.palette) << 32) | quint32(match.index);
+    QVERIFY(!seen.contains(key));
+    seen.insert(key);
+
+    QVERIFY(qAbs(match.distance - distance(q, palettes[p][match.index])) < 1e-3f);
+  }
+}
+
+} // namespace
+
+class TestColorSearchIndex : public QObject {
+  Q_OBJECT
+
+private slots:
+  void nearestMatchesBruteForce();
+  void withinRadiusMatchesBruteForce();
+  void emptyAndInvalidQueries();
+  void removePalette();
+  void incrementalEditsMatchPalettes();
+
+  // The target is under 1 ms per query with a million swatches indexed
+  void benchmarkNearest();
+  void benchmarkWithinRadius();
+  void benchmarkInsertColor();
+
+private:
+  ColorSearchIndex &largeIndex();
+
+  std::unique_ptr<ColorSearchIndex> m_largeIndex;
+  Palettes m_largePalettes;
+};
+
+void TestColorSearchIndex::nearestMatchesBruteForce() {
+  QRandomGenerator rng(1);
+  const Palettes palettes = randomPalettes(&rng, 3, 300);
+  ColorSearchIndex index;
+  indexAll(&index, palettes);
+
+  for (int q = 0; q < 20; ++q) {
+    const QColor query = ColorLogic::fromPacked(randomColor(&rng));
+    const QVector<float> expected = bruteForce(palettes, query);
+
+    for (int k : {1, 7, 50}) {
+      const QVector<ColorSearchIndex::Match> matches = index.nearest(query, k);
+      QCOMPARE(int(matches.size()), k);
+      for (int i = 0; i < k; ++i) {
+        QVERIFY(qAbs(matches[i].distance - expected[i]) < 1e-3f);
+      }
+    }
+  }
+
+  // Asking for more than there is returns everything
+  QCOMPARE(int(index.nearest(Qt::red, 10000).size()), index.size());
+}
+
+void TestColorSearchIndex::withinRadiusMatchesBruteForce() {
+  QRandomGenerator rng(2);
+  const Palettes palettes = randomPalettes(&rng, 3, 300);
+  ColorSearchIndex index;
+  indexAll(&index, palettes);
+
+  for (int q = 0; q < 20; ++q) {
+    const QColor query = ColorLogic::fromPacked(randomColor(&rng));
+    const QVector<float> expected = bruteForce(palettes, query);
+
+    for (float radius : {2.0f, 8.0f, 25.0f}) {
+      const QVector<ColorSearchIndex::Match> matches =
+          index.withinRadius(query, radius);
+      const auto inside =
+          std::upper_bound(expected.begin(), expected.end(), radius) -
+          expected.begin();
+      QCOMPARE(matches.size(), qsizetype(inside));
+      for (int i = 0; i < matches.size(); ++i) {
+        QVERIFY(qAbs(matches[i].distance - expected[i]) < 1e-3f);
+      }
+    }
+  }
+}
+
+void TestColorSearchIndex::emptyAndInvalidQueries() {
+  ColorSearchIndex index;
+  QVERIFY(index.nearest(Qt::red, 5).isEmpty());
+  QVERIFY(index.withinRadius(Qt::red, 10.0f).isEmpty());
+
+  index.setPaletteColors(1, {ColorLogic::toPacked(Qt::red)});
+  QVERIFY(index.nearest(QColor(), 5).isEmpty());
+  QVERIFY(index.nearest(Qt::red, 0).isEmpty());
+  QVERIFY(index.withinRadius(Qt::red, -1.0f).isEmpty());
+
+  const QVector<ColorSearchIndex::Match> exact = index.withinRadius(Qt::red, 0.0f);
+  QCOMPARE(int(exact.size()), 1);
+  QCOMPARE(exact[0].palette, PaletteHandle(1));
+  QCOMPARE(exact[0].index, 0);
+}
+
+void TestColorSearchIndex::removePalette() {
+  QRandomGenerator rng(3);
+  Palettes palettes = randomPalettes(&rng, 3, 100);
+  ColorSearchIndex index;
+  indexAll(&index, palettes);
+
+  index.removePalette(2);
+  palettes[1].clear();
+  verifyIndex(index, palettes);
+
+  // Replacing is the same as removing and adding
+  palettes[0] = randomPalettes(&rng, 1, 40).first();
+  index.setPaletteColors(1, palettes[0]);
+  verifyIndex(index, palettes);
+
+  index.clear();
+  QCOMPARE(index.size(), 0);
+}
+
+void TestColorSearchIndex::incrementalEditsMatchPalettes() {
+  QRandomGenerator rng(4);
+  Palettes palettes = randomPalettes(&rng, 3, 20);
+  ColorSearchIndex index;
+  indexAll(&index, palettes);
+
+  // Random single-color edits applied to both, as PaletteManager does
+  for (int step = 1; step <= 600; ++step) {
+    const int p = rng.bounded(int(palettes.size()));
+    const PaletteHandle handle = PaletteHandle(p + 1);
+    QVector<PackedColor> &palette = palettes[p];
+    const int op = palette.isEmpty() ? 0 : rng.bounded(3);
+
+    if (op == 0) {
+      const int at = rng.bounded(int(palette.size()) + 1);
+      const int count = 1 + rng.bounded(3);
+      for (int i = 0; i < count; ++i) {
+        palette.insert(at + i, randomColor(&rng));
+      }
+      index.insertColors(handle, palette, at, count);
+    } else if (op == 1) {
+      const int at = rng.bounded(int(palette.size()));
+      const int count = qMin(1 + rng.bounded(2), int(palette.size()) - at);
+      palette.remove(at, count);
+      index.removeColors(handle, at, count);
+    } else {
+      const int from = rng.bounded(int(palette.size()));
+      const int to = rng.bounded(int(palette.size()));
+      palette.move(from, to);
+      index.moveColor(handle, from, to);
+    }
+
+    if (step % 50 == 0) {
+      verifyIndex(index, palettes);
+      if (QTest::currentTestFailed()) {
+        qWarning() << "Index out of step after" << step << "edits";
+        return;
+      }
+    }
+  }
+
+  // Emptied palettes can be filled again
+  const int count = int(palettes[0].size());
+  palettes[0].clear();
+  index.removeColors(1, 0, count);
+  verifyIndex(index, palettes);
+  palettes[0].append(randomColor(&rng));
+  index.insertColors(1, palettes[0], 0, 1);
+  verifyIndex(index, palettes);
+}
+
+ColorSearchIndex &TestColorSearchIndex::largeIndex() {
+  if (!m_largeIndex) {
+    QRandomGenerator rng(5);
+    m_largePalettes = randomPalettes(&rng, 1000, 1000);
+    m_largeIndex = std::make_unique<ColorSearchIndex>();
+    indexAll(m_largeIndex.get(), m_largePalettes);
+  }
+  return *m_largeIndex;
+}
+
+void TestColorSearchIndex::benchmarkNearest() {
+  const ColorSearchIndex &index = largeIndex();
+  QCOMPARE(index.size(), 1000 * 1000);
+
+  const QColor query(200, 120, 40);
+  QBENCHMARK {
+    index.nearest(query, 10);
+  }
+}
+
+void TestColorSearchIndex::benchmarkWithinRadius() {
+  const ColorSearchIndex &index = largeIndex();
+
+  const QColor query(200, 120, 40);
+  QBENCHMARK {
+    index.withinRadius(query, 2.0f);
+  }
+}
+
+void TestColorSearchIndex::benchmarkInsertColor() {
+  ColorSearchIndex &index = largeIndex();
+
+  // Adding a color to, and removing it from, one 1000-color palette
+  QVector<PackedColor> palette = m_largePalettes.first();
+  palette.insert(500, ColorLogic::toPacked(Qt::red));
+  QBENCHMARK {
+    index.insertColors(1, palette, 500, 1);
+    index.removeColors(1, 500, 1);
+  }
+  QCOMPARE(index.size(), 1000 * 1000);
+}
+
+QTEST_GUILESS_MAIN(TestColorSearchIndex)
+#include "tst_colorsearchindex.moc"
@@ -0,0 +1,437 @@
+#include "../include/PaletteImporter.h"
+#include <QBuffer>
+#include <QtEndian>
+#include <QtTest>
+#include <cstring>
+
+namespace {
+
+bool importBytes(const QByteArray &data, PaletteImporter::Format format,
+                 PaletteImporter::Result *result) {
+  QBuffer buffer;
+  buffer.setData(data);
+  buffer.open(QIODevice::ReadOnly);
+  return PaletteImporter::import(&buffer, format, result);
+}
+
+QStringList colorNames(const QVector<PackedColor> &colors) {
+  QStringList names;
+  for (const PackedColor &color : colors) {
+    names.append(ColorLogic::fromPacked(color).name());
+  }
+  return names;
+}
+
+void appendBigEndian16(QByteArray *data, quint16 value) {
+  char bytes[2];
+  qToBigEndian(value, bytes);
+  data->append(bytes, sizeof(bytes));
+}
+
+void appendBigEndian32(QByteArray *data, quint32 value) {
+  char bytes[4];
+  qToBigEndian(value, bytes);
+  data->append(bytes, sizeof(bytes));
+}
+
+// UTF-16 unit count including the terminator, then the big-endian units
+void appendName16(QByteArray *data, const QString &name, bool wideCount) {
+  if (wideCount) {
+    appendBigEndian32(data, quint32(name.size() + 1));
+  } else {
+    appendBigEndian16(data, quint16(name.size() + 1));
+  }
+  for (QChar c : name) {
+    appendBigEndian16(data, c.unicode());
+  }
+  appendBigEndian16(data, 0);
+}
+
+QByteArray aseHeader(quint32 blocks) {
+  QByteArray data("ASEF");
+  appendBigEndian16(&data, 1);
+  appendBigEndian16(&data, 0);
+  appendBigEndian32(&data, blocks);
+  return data;
+}
+
+QByteArray aseBlock(quint16 type, const QByteArray &body) {
+  QByteArray data;
+  appendBigEndian16(&data, type);
+  appendBigEndian32(&data, quint32(body.size()));
+  return data + body;
+}
+
+QByteArray aseColor(const QString &name, const char (&model)[5],
+                    std::initializer_list<float> values) {
+  QByteArray body;
+  appendName16(&body, name, false);
+  body.append(model, 4);
+  for (float value : values) {
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    appendBigEndian32(&body, bits);
+  }
+  appendBigEndian16(&body, 2); // normal, not a global or spot color
+  return aseBlock(0x0001, body);
+}
+
+// Red, green and blue, one block each
+QByteArray aseSample() {
+  return aseHeader(3) + aseColor("R", "RGB ", {1.0f, 0.0f, 0.0f}) +
+         aseColor("G", "RGB ", {0.0f, 1.0f, 0.0f}) +
+         aseColor("B", "RGB ", {0.0f, 0.0f, 1.0f});
+}
+
+QByteArray acoEntry(quint16 space, quint16 w, quint16 x, quint16 y,
+                    quint16 z = 0) {
+  QByteArray data;
+  for (quint16 value : {space, w, x, y, z}) {
+    appendBigEndian16(&data, value);
+  }
+  return data;
+}
+
+QByteArray acoHeader(quint16 version, quint16 count) {
+  QByteArray data;
+  appendBigEndian16(&data, version);
+  appendBigEndian16(&data, count);
+  return data;
+}
+
+QByteArray acoNamedEntry(const QByteArray &entry, const QString &name) {
+  QByteArray data = entry;
+  appendName16(&data, name, true);
+  return data;
+}
+
+// Version 2: red and blue, named
+QByteArray acoSample() {
+  return acoHeader(2, 2) +
+         acoNamedEntry(acoEntry(0, 0xffff, 0, 0), "Red") +
+         acoNamedEntry(acoEntry(0, 0, 0, 0xffff), "Blue");
+}
+
+// A declaration padded with spaces before its value to size bytes
+QByteArray paddedDeclaration(const QByteArray &name, const QByteArray &value,
+                             int size) {
+  const QByteArray head = name + ':';
+  return head + QByteArray(size - head.size() - value.size(), ' ') + value;
+}
+
+// Large enough for several progress reports
+QByteArray largeCss() {
+  QByteArray data;
+  for (int i = 0; i < 80000; ++i) {
+    data += "--c: #ff0000;\n";
+  }
+  return data;
+}
+
+} // namespace
+
+class TestPaletteImporter : public QObject {
+  Q_OBJECT
+
+private slots:
+  void detectFormat();
+  void plainTextNeedsHash();
+  void gpl();
+
+  void ase();
+  void truncatedAse_data();
+  void truncatedAse();
+  void oversizedAseBlock();
+
+  void aco();
+  void truncatedAco_data();
+  void truncatedAco();
+  void oversizedAcoName();
+
+  void css_data();
+  void css();
+  void progress();
+  void cancelFromProgress();
+};
+
+void TestPaletteImporter::detectFormat() {
+  QBuffer buffer;
+  buffer.setData(aseSample());
+  buffer.open(QIODevice::ReadOnly);
+  // The magic wins over the extension, and peeking does not consume it
+  QCOMPARE(int(PaletteImporter::detectFormat(&buffer, "colors.txt")),
+           int(PaletteImporter::Ase));
+  QCOMPARE(buffer.pos(), qint64(0));
+
+  QBuffer empty;
+  empty.open(QIODevice::ReadOnly);
+  QCOMPARE(int(PaletteImporter::detectFormat(&empty, "swatches.ACO")),
+           int(PaletteImporter::Aco));
+  QCOMPARE(int(PaletteImporter::detectFormat(&empty, "theme.scss")),
+           int(PaletteImporter::Css));
+  QCOMPARE(int(PaletteImporter::detectFormat(&empty, "colors.txt")),
+           int(PaletteImporter::PlainText));
+}
+
+void TestPaletteImporter::plainTextNeedsHash() {
+  PaletteImporter::Result result;
+  QVERIFY(importBytes("bed\n#bed\nface\n  red  \r\n\n#abcd\ncafe\n",
+                      PaletteImporter::PlainText, &result));
+  QCOMPARE(colorNames(result.colors), QStringList({"#bbeedd", "#ff0000"}));
+  QCOMPARE(result.skipped, 4);
+}
+
+void TestPaletteImporter::gpl() {
+  PaletteImporter::Result result;
+  QVERIFY(importBytes("GIMP Palette\nName: Primaries\nColumns: 3\n# comment\n"
+                      "255   0   0\tRed\n  0 255   0 Green\n300 0 0\n",
+                      PaletteImporter::Gpl, &result));
+  QCOMPARE(result.name, QStringLiteral("Primaries"));
+  QCOMPARE(colorNames(result.colors), QStringList({"#ff0000", "#00ff00"}));
+  QCOMPARE(result.skipped, 1);
+
+  QVERIFY(!importBytes("255 0 0\n", PaletteImporter::Gpl, &result));
+}
+
+void TestPaletteImporter::ase() {
+  // Groups only carry a name; unknown models are counted as skipped
+  const QByteArray data =
+      aseHeader(6) + aseBlock(0xc001, QByteArray(4, '\0')) +
+      aseColor("Red", "RGB ", {1.0f, 0.0f, 0.0f}) +
+      aseColor("Black", "CMYK", {0.0f, 0.0f, 0.0f, 1.0f}) +
+      aseColor("Gray", "Gray", {0.5f}) +
+      aseColor("Odd", "XYZ ", {0.1f, 0.2f, 0.3f}) + aseBlock(0xc002, {});
+
+  PaletteImporter::Result result;
+  QVERIFY(importBytes(data, PaletteImporter::Ase, &result));
+  QCOMPARE(result.colors.size(), qsizetype(3));
+  QCOMPARE(colorNames(result.colors.first(2)),
+           QStringList({"#ff0000", "#000000"}));
+  const QColor gray = ColorLogic::fromPacked(result.colors[2]);
+  QVERIFY(gray.red() == gray.green() && gray.green() == gray.blue());
+  QVERIFY(qAbs(gray.red() - 128) <= 1);
+  QCOMPARE(result.skipped, 1);
+}
+
+void TestPaletteImporter::truncatedAse_data() {
+  QTest::addColumn<int>("size"); // bytes left of aseSample()
+  QTest::addColumn<bool>("ok");
+  QTest::addColumn<int>("colors");
+
+  const int header = int(aseHeader(0).size());
+  const int block = int(aseColor("R", "RGB ", {1.0f, 0.0f, 0.0f}).size());
+  const int size = int(aseSample().size());
+
+  QTest::newRow("empty") << 0 << false << 0;
+  QTest::newRow("inside header") << 8 << false << 0;
+  QTest::newRow("header only") << header << true << 0;
+  QTest::newRow("inside block header") << header + 3 << true << 0;
+  QTest::newRow("inside first color") << header + 10 << true << 0;
+  QTest::newRow("after first color") << header + block << true << 1;
+  QTest::newRow("last byte") << size - 1 << true << 2;
+  QTest::newRow("complete") << size << true << 3;
+}
+
+void TestPaletteImporter::truncatedAse() {
+  QFETCH(int, size);
+  QFETCH(bool, ok);
+  QFETCH(int, colors);
+
+  // Complete colors before the cut are kept
+  PaletteImporter::Result result;
+  QCOMPARE(importBytes(aseSample().left(size), PaletteImporter::Ase, &result),
+           ok);
+  QCOMPARE(int(result.colors.size()), colors);
+}
+
+void TestPaletteImporter::oversizedAseBlock() {
+  // A color block claiming ~4 GiB, and more blocks than the file holds
+  QByteArray data = aseHeader(0xffffffff) +
+                    aseColor("R", "RGB ", {1.0f, 0.0f, 0.0f});
+  appendBigEndian16(&data, 0x0001);
+  appendBigEndian32(&data, 0xfffffff0);
+  data.append("tail");
+
+  PaletteImporter::Result result;
+  QVERIFY(importBytes(data, PaletteImporter::Ase, &result));
+  QCOMPARE(colorNames(result.colors), QStringList({"#ff0000"}));
+  QCOMPARE(result.skipped, 1);
+}
+
+void TestPaletteImporter::aco() {
+  // Version 1, followed by the version 2 copy that is not read
+  const QByteArray data =
+      acoHeader(1, 4) + acoEntry(0, 0xffff, 0, 0) +
+      acoEntry(8, 10000, 0, 0) + acoEntry(2, 0xffff, 0xffff, 0xffff, 0xffff) +
+      acoEntry(3, 1, 2, 3) + acoSample();
+
+  PaletteImporter::Result result;
+  QVERIFY(importBytes(data, PaletteImporter::Aco, &result));
+  // Full gray ink and no CMYK ink; the unknown space is skipped
+  QCOMPARE(colorNames(result.colors),
+           QStringList({"#ff0000", "#000000", "#ffffff"}));
+  QCOMPARE(result.skipped, 1);
+
+  QVERIFY(importBytes(acoSample(), PaletteImporter::Aco, &result));
+  QCOMPARE(colorNames(result.colors), QStringList({"#ff0000", "#0000ff"}));
+
+  QVERIFY(!importBytes(acoHeader(3, 0), PaletteImporter::Aco, &result));
+}
+
+void TestPaletteImporter::truncatedAco_data() {
+  QTest::addColumn<int>("size"); // bytes left of acoSample()
+  QTest::addColumn<bool>("ok");
+  QTest::addColumn<int>("colors");
+
+  const int header = int(acoHeader(2, 0).size());
+  const int entry = int(acoEntry(0, 0, 0, 0).size());
+  const int first = int(acoNamedEntry(acoEntry(0, 0xffff, 0, 0), "Red").size());
+  const int size = int(acoSample().size());
+
+  QTest::newRow("empty") << 0 << false << 0;
+  QTest::newRow("inside header") << 3 << false << 0;
+  QTest::newRow("header only") << header << true << 0;
+  QTest::newRow("inside entry") << header + 6 << true << 0;
+  QTest::newRow("inside name length") << header + entry + 2 << true << 0;
+  QTest::newRow("inside name") << header + entry + 6 << true << 0;
+  QTest::newRow("after first color") << header + first << true << 1;
+  QTest::newRow("last byte") << size - 1 << true << 1;
+  QTest::newRow("complete") << size << true << 2;
+}
+
+void TestPaletteImporter::truncatedAco() {
+  QFETCH(int, size);
+  QFETCH(bool, ok);
+  QFETCH(int, colors);
+
+  PaletteImporter::Result result;
+  QCOMPARE(importBytes(acoSample().left(size), PaletteImporter::Aco, &result),
+           ok);
+  QCOMPARE(int(result.colors.size()), colors);
+}
+
+void TestPaletteImporter::oversizedAcoName() {
+  QByteArray data = acoHeader(2, 2) + acoEntry(0, 0xffff, 0, 0);
+  appendBigEndian32(&data, 0x7fffffff);
+  data += acoEntry(0, 0, 0, 0xffff);
+
+  PaletteImporter::Result result;
+  QVERIFY(importBytes(data, PaletteImporter::Aco, &result));
+  QVERIFY(result.colors.isEmpty());
+}
+
+void TestPaletteImporter::css_data() {
+  QTest::addColumn<QByteArray>("data");
+  QTest::addColumn<QStringList>("colors");
+
+  // Declarations are split at ';', '{' and '}', so selectors never match
+  QTest::newRow("custom properties")
+      << QByteArray(":root {\n  --red: #f00;\n  --green: #00ff00;\n}\n"
+                    ".x { color: #0000ff; }")
+      << QStringList({"#ff0000", "#00ff00"});
+  QTest::newRow("scss variables")
+      << QByteArray("$red: #ff0000;\n$blue: color(srgb 0 0 1);\n$name: rebeccapurple;")
+      << QStringList({"#ff0000", "#0000ff", "#663399"});
+  QTest::newRow("not colors")
+      << QByteArray("--gap: 4px; --font: Inter; $size: 12pt; --empty: ;")
+      << QStringList();
+
+  QTest::newRow("important")
+      << QByteArray("--a: #ff0000 !important; $b: #00ff00!default;")
+      << QStringList({"#ff0000", "#00ff00"});
+
+  QTest::newRow("block comments")
+      << QByteArray("/* --x: #ffffff; */ --a: #ff0000;\n"
+                    "--b: /* note; } */ #00ff00;/**/--c: #0000ff;")
+      << QStringList({"#ff0000", "#00ff00", "#0000ff"});
+  QTest::newRow("unterminated block comment")
+      << QByteArray("--a: #ff0000; /* --b: #00ff00;") << QStringList({"#ff0000"});
+
+  QTest::newRow("line comment")
+      << QByteArray("// --x: #ffffff; --y: #000000;\n  --a: #ff0000;\n"
+                    "--b: #00ff00; // --z: #0000ff;\n")
+      << QStringList({"#ff0000", "#00ff00"});
+  // Only where a declaration starts; elsewhere // is part of the value
+  QTest::newRow("slashes inside declaration")
+      << QByteArray("--image: url(http://example.com/a.png); --a: #ff0000;")
+      << QStringList({"#ff0000"});
+
+  QTest::newRow("quoted")
+      << QByteArray("--font: \"a;b{c}\\\"; /* --x: #fff\"; --a: #ff0000;"
+                    "--q: '// --y: #000;'; --b: #00ff00;")
+      << QStringList({"#ff0000", "#00ff00"});
+
+  QTest::newRow("no final semicolon")
+      << QByteArray("$a: #ff0000;\n$b: #00ff00\n") << QStringList({"#ff0000", "#00ff00"});
+  QTest::newRow("unterminated quote")
+      << QByteArray("--a: #ff0000; --b: \"#00ff00") << QStringList({"#ff0000"});
+
+  // Declarations up to 4096 bytes are read; longer ones are skipped whole
+  QTest::newRow("longest declaration")
+      << paddedDeclaration("--a", "#ff0000", 4096) + ";--b: #00ff00;"
+      << QStringList({"#ff0000", "#00ff00"});
+  QTest::newRow("declaration too long")
+      << paddedDeclaration("--a", "#ff0000", 4097) + ";--b: #00ff00;"
+      << QStringList({"#00ff00"});
+  QTest::newRow("last declaration too long")
+      << "--b: #00ff00;" + paddedDeclaration("--a", "#ff0000", 100000)
+      << QStringList({"#00ff00"});
+}
+
+void TestPaletteImporter::css() {
+  QFETCH(QByteArray, data);
+  QFETCH(QStringList, colors);
+
+  PaletteImporter::Result result;
+  QVERIFY(importBytes(data, PaletteImporter::Css, &result));
+  QCOMPARE(colorNames(result.colors), colors);
+}
+
+void TestPaletteImporter::progress() {
+  const QByteArray data = largeCss();
+  QBuffer buffer;
+  buffer.setData(data);
+  buffer.open(QIODevice::ReadOnly);
+
+  QVector<qint64> reported;
+  qint64 total = -1;
+  PaletteImporter::Result result;
+  QVERIFY(PaletteImporter::import(&buffer, PaletteImporter::Css, &result,
+                                  [&](qint64 done, qint64 size) {
+                                    reported.append(done);
+                                    total = size;
+                                    return true;
+                                  }));
+  QCOMPARE(int(result.colors.size()), 80000);
+
+  // Every 256 KiB at most, never past the end
+  QCOMPARE(total, qint64(data.size()));
+  QVERIFY(reported.size() >= 3);
+  QVERIFY(reported.size() <= data.size() / (256 * 1024));
+  for (int i = 1; i < reported.size(); ++i) {
+    QVERIFY(reported[i] - reported[i - 1] >= 256 * 1024);
+  }
+  QVERIFY(reported.last() <= data.size());
+}
+
+void TestPaletteImporter::cancelFromProgress() {
+  const QByteArray data = largeCss();
+  QBuffer buffer;
+  buffer.setData(data);
+  buffer.open(QIODevice::ReadOnly);
+
+  int calls = 0;
+  PaletteImporter::Result result;
+  QVERIFY(!PaletteImporter::import(&buffer, PaletteImporter::Css, &result,
+                                   [&](qint64, qint64) {
+                                     ++calls;
+                                     return false;
+                                   }));
+  // Reading stops at the first report
+  QCOMPARE(calls, 1);
+  QVERIFY(buffer.pos() < data.size());
+  QVERIFY(result.colors.size() < 80000);
+}
+
+QTEST_GUILESS_MAIN(TestPaletteImporter)
+#include "tst_paletteimporter.moc"
@@ -0,0 +1,205 @@
+#include "../include/PaletteJournal.h"
+#include <QTemporaryDir>
+#include <QtTest>
+#include <memory>
+
+namespace {
+
+PaletteJournal::Entry addColorEntry(quint64 sequence, const QColor &color) {
+  PaletteJournal::Entry entry;
+  entry.sequence = sequence;
+  entry.operation = PaletteJournal::AddColor;
+  entry.paletteId = QStringLiteral("palette");
+  entry.index = 0;
+  entry.colors.append(ColorLogic::toPacked(color));
+  return entry;
+}
+
+QVector<quint64> sequences(const QVector<PaletteJournal::Entry> &entries) {
+  QVector<quint64> result;
+  for (const PaletteJournal::Entry &entry : entries) {
+    result.append(entry.sequence);
+  }
+  return result;
+}
+
+// Writes bytes behind the journal's back, as a crash mid-write would leave
+bool appendRaw(const QString &path, const QByteArray &data) {
+  QFile file(path);
+  return file.open(QIODevice::WriteOnly | QIODevice::Append) &&
+         file.write(data) == data.size();
+}
+
+} // namespace
+
+class TestPaletteJournal : public QObject {
+  Q_OBJECT
+
+private slots:
+  void init();
+
+  void roundTrip();
+  void partialLineIsSkipped();
+  void replayAcrossRotation();
+  void rotateFoldsIntoPendingRotation();
+  void foldEndsCutLine();
+  void clearDropsEverything();
+
+private:
+  QString journalPath() const { return m_dir->filePath("palettes.journal"); }
+
+  std::unique_ptr<QTemporaryDir> m_dir;
+};
+
+void TestPaletteJournal::init() {
+  m_dir = std::make_unique<QTemporaryDir>();
+  QVERIFY(m_dir->isValid());
+}
+
+void TestPaletteJournal::roundTrip() {
+  QVector<PaletteJournal::Entry> written;
+
+  PaletteJournal::Entry create;
+  create.operation = PaletteJournal::CreatePalette;
+  create.name = QStringLiteral("Sunset");
+  written.append(create);
+
+  written.append(addColorEntry(0, QColor(255, 128, 0)));
+
+  PaletteJournal::Entry move;
+  move.operation = PaletteJournal::MoveColor;
+  move.index = 3;
+  move.toIndex = 1;
+  written.append(move);
+
+  PaletteJournal::Entry remove;
+  remove.operation = PaletteJournal::RemoveColor;
+  remove.index = 2;
+  written.append(remove);
+
+  // Finer than 8 bits, so it is stored as color(srgb ...)
+  PaletteJournal::Entry set;
+  set.operation = PaletteJournal::SetColors;
+  set.colors = {ColorLogic::packedFromRgbF(0.1f, 0.2f, 0.3f),
+                ColorLogic::packedFromRgbF(1.0f, 1.0f, 1.0f, 0.5f)};
+  written.append(set);
+
+  PaletteJournal journal;
+  QVERIFY(journal.open(journalPath()));
+  for (PaletteJournal::Entry &entry : written) {
+    entry.sequence = journal.nextSequence();
+    entry.paletteId = QStringLiteral("palette");
+  }
+  QVERIFY(journal.append(written));
+  QVERIFY(journal.size() > 0);
+  journal.close();
+
+  const QVector<PaletteJournal::Entry> read =
+      PaletteJournal::readEntries(journalPath());
+  QCOMPARE(read.size(), written.size());
+  for (int i = 0; i < read.size(); ++i) {
+    QCOMPARE(read[i].sequence, written[i].sequence);
+    QCOMPARE(int(read[i].operation), int(written[i].operation));
+    QCOMPARE(read[i].paletteId, written[i].paletteId);
+    QCOMPARE(read[i].colors.size(), written[i].colors.size());
+    for (int c = 0; c < read[i].colors.size(); ++c) {
+      QCOMPARE(ColorLogic::packedKey(read[i].colors[c]),
+               ColorLogic::packedKey(written[i].colors[c]));
+    }
+  }
+  QCOMPARE(read[0].name, QStringLiteral("Sunset"));
+  QCOMPARE(read[2].index, 3);
+  QCOMPARE(read[2].toIndex, 1);
+  QCOMPARE(read[3].index, 2);
+}
+
+void TestPaletteJournal::partialLineIsSkipped() {
+  {
+    PaletteJournal journal;
+    QVERIFY(journal.open(journalPath()));
+    QVERIFY(journal.append({addColorEntry(1, Qt::red)}));
+  }
+  QVERIFY(appendRaw(journalPath(), R"({"seq":2,"op":"add","pal)"));
+
+  // The next session's first batch must not be glued onto the cut line
+  PaletteJournal journal;
+  QVERIFY(journal.open(journalPath()));
+  QVERIFY(journal.append({addColorEntry(3, Qt::blue)}));
+  journal.close();
+
+  QCOMPARE(sequences(PaletteJournal::readEntries(journalPath())),
+           QVector<quint64>({1, 3}));
+}
+
+void TestPaletteJournal::replayAcrossRotation() {
+  PaletteJournal journal;
+  QVERIFY(journal.open(journalPath()));
+  QVERIFY(journal.append({addColorEntry(1, Qt::red), addColorEntry(2, Qt::green)}));
+
+  QVERIFY(journal.rotate());
+  QVERIFY(journal.hasRotated());
+  QCOMPARE(journal.size(), qint64(0));
+
+  // Written while the snapshot is being taken
+  QVERIFY(journal.append({addColorEntry(3, Qt::blue)}));
+
+  // Rotated entries come first, so sequences still only grow
+  QCOMPARE(sequences(PaletteJournal::readEntries(journalPath())),
+           QVector<quint64>({1, 2, 3}));
+
+  // Snapshot committed
+  journal.removeRotated();
+  QVERIFY(!journal.hasRotated());
+  QCOMPARE(sequences(PaletteJournal::readEntries(journalPath())),
+           QVector<quint64>({3}));
+}
+
+void TestPaletteJournal::rotateFoldsIntoPendingRotation() {
+  PaletteJournal journal;
+  QVERIFY(journal.open(journalPath()));
+  QVERIFY(journal.append({addColorEntry(1, Qt::red)}));
+  QVERIFY(journal.rotate());
+  QVERIFY(journal.append({addColorEntry(2, Qt::green)}));
+
+  // The first snapshot failed; the next rotation keeps both batches
+  QVERIFY(journal.rotate());
+  QCOMPARE(journal.size(), qint64(0));
+  QVERIFY(journal.append({addColorEntry(3, Qt::blue)}));
+  journal.close();
+
+  QCOMPARE(sequences(PaletteJournal::readEntries(journalPath())),
+           QVector<quint64>({1, 2, 3}));
+  QCOMPARE(sequences(PaletteJournal::readEntries(journalPath() + ".old")),
+           QVector<quint64>({1, 2}));
+}
+
+void TestPaletteJournal::foldEndsCutLine() {
+  PaletteJournal journal;
+  QVERIFY(journal.open(journalPath()));
+  QVERIFY(journal.append({addColorEntry(1, Qt::red)}));
+  QVERIFY(journal.rotate());
+  QVERIFY(appendRaw(journalPath() + ".old", R"({"seq":9,"op":)"));
+  QVERIFY(journal.append({addColorEntry(2, Qt::green)}));
+
+  QVERIFY(journal.rotate());
+  journal.close();
+
+  QCOMPARE(sequences(PaletteJournal::readEntries(journalPath())),
+           QVector<quint64>({1, 2}));
+}
+
+void TestPaletteJournal::clearDropsEverything() {
+  PaletteJournal journal;
+  QVERIFY(journal.open(journalPath()));
+  QVERIFY(journal.append({addColorEntry(1, Qt::red)}));
+  QVERIFY(journal.rotate());
+  QVERIFY(journal.append({addColorEntry(2, Qt::green)}));
+
+  journal.clear();
+  QVERIFY(!journal.hasRotated());
+  QCOMPARE(journal.size(), qint64(0));
+  QVERIFY(PaletteJournal::readEntries(journalPath()).isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestPaletteJournal)
+#include "tst_palettejournal.moc"
@@ -0,0 +1,244 @@
+#include "../include/PaletteLibrary.h"
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <QtTest>
+#include <memory>
+
+namespace {
+
+// Field offsets from the layout described in PaletteLibrary.h
+constexpr int HEADER_SIZE = 56;
+constexpr int H_VERSION = 4;
+constexpr int H_PALETTE_COUNT = 8;
+constexpr int H_STRINGS_SIZE = 20;
+constexpr int H_PREVIEW_SIZE = 52;
+constexpr int D_NAME_LENGTH = 12;
+constexpr int D_COLOR_COUNT = 24;
+
+PaletteLibrary::Snapshot sampleSnapshot() {
+  PaletteLibrary::Snapshot snapshot;
+  snapshot.currentPaletteId = QStringLiteral("warm");
+  snapshot.journalSequence = 42;
+
+  snapshot.palettes.append({QStringLiteral("empty"), QStringLiteral("Empty"), {}});
+  snapshot.palettes.append({QStringLiteral("single"), QStringLiteral("Caf\u00e9 \u2615"),
+                            {ColorLogic::packedFromRgbF(0.2f, 0.4f, 0.6f)}});
+
+  PaletteLibrary::PaletteData warm{QStringLiteral("warm"),
+                                   QStringLiteral("Warm"), {}};
+  for (int i = 0; i < 20; ++i) {
+    warm.colors.append(
+        ColorLogic::packedFromRgbF(i / 19.0f, 0.5f, 1.0f - i / 19.0f, 0.75f));
+  }
+  // Outside sRGB, which the packed format keeps
+  warm.colors.append(ColorLogic::packedFromRgbF(1.25f, -0.1f, 0.0f));
+  snapshot.palettes.append(warm);
+  return snapshot;
+}
+
+QVector<quint64> keys(const QVector<PackedColor> &colors) {
+  QVector<quint64> result;
+  for (const PackedColor &color : colors) {
+    result.append(ColorLogic::packedKey(color));
+  }
+  return result;
+}
+
+QByteArray readAll(const QString &path) {
+  QFile file(path);
+  return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+bool writeAll(const QString &path, const QByteArray &data) {
+  QFile file(path);
+  return file.open(QIODevice::WriteOnly | QIODevice::Truncate) &&
+         file.write(data) == data.size();
+}
+
+// A large library: 200 palettes of 500 colors
+PaletteLibrary::Snapshot largeSnapshot() {
+  PaletteLibrary::Snapshot snapshot;
+  for (int p = 0; p < 200; ++p) {
+    PaletteLibrary::PaletteData palette;
+    palette.id = QStringLiteral("palette-%1").arg(p);
+    palette.name = QStringLiteral("Palette %1").arg(p);
+    palette.colors.reserve(500);
+    for (int i = 0; i < 500; ++i) {
+      palette.colors.append(ColorLogic::packedFromRgbF(
+          (p % 10) / 9.0f, i / 499.0f, ((p + i) % 7) / 6.0f));
+    }
+    snapshot.palettes.append(palette);
+  }
+  return snapshot;
+}
+
+} // namespace
+
+class TestPaletteLibrary : public QObject {
+  Q_OBJECT
+
+private slots:
+  void init();
+
+  void roundTrip();
+  void emptyLibrary();
+  void rejectsTruncated_data();
+  void rejectsTruncated();
+  void rejectsCorrupt_data();
+  void rejectsCorrupt();
+
+  // What startup reads before the first frame: all of palettes.json before
+  // the binary library, the directory and previews since
+  void benchmarkReadJson();
+  void benchmarkOpenMetadata();
+
+private:
+  QString libraryPath() const { return m_dir->filePath("palettes.lib"); }
+
+  std::unique_ptr<QTemporaryDir> m_dir;
+};
+
+void TestPaletteLibrary::init() {
+  m_dir = std::make_unique<QTemporaryDir>();
+  QVERIFY(m_dir->isValid());
+}
+
+void TestPaletteLibrary::roundTrip() {
+  const PaletteLibrary::Snapshot snapshot = sampleSnapshot();
+  QVERIFY(PaletteLibrary::write(snapshot, libraryPath()));
+
+  PaletteLibrary library;
+  QVERIFY(library.open(libraryPath()));
+  QCOMPARE(library.currentPaletteId(), snapshot.currentPaletteId);
+  QCOMPARE(library.journalSequence(), snapshot.journalSequence);
+  QCOMPARE(library.paletteCount(), int(snapshot.palettes.size()));
+
+  for (int i = 0; i < library.paletteCount(); ++i) {
+    const PaletteLibrary::PaletteData &palette = snapshot.palettes[i];
+    QCOMPARE(library.paletteId(i), palette.id);
+    QCOMPARE(library.paletteName(i), palette.name);
+    QCOMPARE(library.colorCount(i), int(palette.colors.size()));
+    QCOMPARE(keys(library.colors(i)), keys(palette.colors));
+    QCOMPARE(keys(library.preview(i)),
+             keys(PaletteLibrary::samplePreview(palette.colors)));
+  }
+
+  // Out of range indices read as empty
+  QVERIFY(library.paletteId(library.paletteCount()).isEmpty());
+  QCOMPARE(library.colorCount(-1), 0);
+  QVERIFY(library.colors(library.paletteCount()).isEmpty());
+
+  library.close();
+  QVERIFY(!library.isOpen());
+}
+
+void TestPaletteLibrary::emptyLibrary() {
+  QVERIFY(PaletteLibrary::write(PaletteLibrary::Snapshot(), libraryPath()));
+
+  PaletteLibrary library;
+  QVERIFY(library.open(libraryPath()));
+  QCOMPARE(library.paletteCount(), 0);
+  QVERIFY(library.currentPaletteId().isEmpty());
+}
+
+void TestPaletteLibrary::rejectsTruncated_data() {
+  QTest::addColumn<int>("size"); // bytes left of the sample library
+
+  QTemporaryDir dir;
+  const QString path = dir.filePath("palettes.lib");
+  QVERIFY(PaletteLibrary::write(sampleSnapshot(), path));
+  const int size = int(QFileInfo(path).size());
+
+  QTest::newRow("empty") << 0;
+  QTest::newRow("inside header") << 20;
+  QTest::newRow("header only") << HEADER_SIZE;
+  QTest::newRow("half") << size / 2;
+  QTest::newRow("string table") << size - 8;
+  QTest::newRow("last byte") << size - 1;
+}
+
+void TestPaletteLibrary::rejectsTruncated() {
+  QFETCH(int, size);
+
+  QVERIFY(PaletteLibrary::write(sampleSnapshot(), libraryPath()));
+  QByteArray data = readAll(libraryPath());
+  QVERIFY(data.size() > size);
+  data.truncate(size);
+  QVERIFY(writeAll(libraryPath(), data));
+
+  PaletteLibrary library;
+  QVERIFY(!library.open(libraryPath()));
+  QVERIFY(!library.isOpen());
+  QCOMPARE(library.paletteCount(), 0);
+}
+
+void TestPaletteLibrary::rejectsCorrupt_data() {
+  QTest::addColumn<int>("offset");
+  QTest::addColumn<quint32>("value");
+  QTest::addColumn<int>("width"); // bytes written at offset
+
+  // The first directory entry follows the header
+  const int entry = HEADER_SIZE;
+
+  QTest::newRow("magic") << 0 << quint32(0x4c505358) << 4;
+  QTest::newRow("version 0") << H_VERSION << quint32(0) << 2;
+  QTest::newRow("future version")
+      << H_VERSION << quint32(PaletteLibrary::FORMAT_VERSION + 1) << 2;
+  QTest::newRow("palette count") << H_PALETTE_COUNT << quint32(100000) << 4;
+  QTest::newRow("string table size") << H_STRINGS_SIZE << quint32(0xfffffff0) << 4;
+  QTest::newRow("preview size") << H_PREVIEW_SIZE << quint32(4) << 4;
+  QTest::newRow("name past strings")
+      << entry + D_NAME_LENGTH << quint32(0x10000) << 4;
+  QTest::newRow("colors past end")
+      << entry + D_COLOR_COUNT << quint32(0x10000000) << 4;
+}
+
+void TestPaletteLibrary::rejectsCorrupt() {
+  QFETCH(int, offset);
+  QFETCH(quint32, value);
+  QFETCH(int, width);
+
+  QVERIFY(PaletteLibrary::write(sampleSnapshot(), libraryPath()));
+  QByteArray data = readAll(libraryPath());
+  QVERIFY(data.size() > offset + width);
+
+  if (width == 2) {
+    qToLittleEndian<quint16>(quint16(value), data.data() + offset);
+  } else {
+    qToLittleEndian<quint32>(value, data.data() + offset);
+  }
+  QVERIFY(writeAll(libraryPath(), data));
+
+  PaletteLibrary library;
+  QVERIFY(!library.open(libraryPath()));
+  QVERIFY(!library.isOpen());
+}
+
+void TestPaletteLibrary::benchmarkReadJson() {
+  const QString path = m_dir->filePath("palettes.json");
+  QVERIFY(PaletteLibrary::writeJson(largeSnapshot(), path));
+
+  QBENCHMARK {
+    PaletteLibrary::Snapshot snapshot;
+    QVERIFY(PaletteLibrary::readJson(path, &snapshot));
+  }
+}
+
+void TestPaletteLibrary::benchmarkOpenMetadata() {
+  QVERIFY(PaletteLibrary::write(largeSnapshot(), libraryPath()));
+
+  QBENCHMARK {
+    PaletteLibrary library;
+    QVERIFY(library.open(libraryPath()));
+    for (int i = 0; i < library.paletteCount(); ++i) {
+      library.paletteId(i);
+      library.paletteName(i);
+      library.colorCount(i);
+      library.preview(i);
+    }
+  }
+}
+
+QTEST_GUILESS_MAIN(TestPaletteLibrary)
+#include "tst_palettelibrary.moc"
@@ -0,0 +1,107 @@
+#include "../include/PaletteManager.h"
+#include <QDir>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QtTest>
+
+namespace {
+
+QVector<quint64> keys(const QVector<PackedColor> &colors) {
+  QVector<quint64> result;
+  for (const PackedColor &color : colors) {
+    result.append(ColorLogic::packedKey(color));
+  }
+  return result;
+}
+
+} // namespace
+
+// PaletteManager is a process-wide singleton, so the slots share one
+// instance, loaded once from a library written by initTestCase()
+class TestPaletteManager : public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void cleanupTestCase();
+
+  void deletingCurrentLoadsReplacement();
+  void recentPaletteFollowsPicks();
+
+private:
+  QString m_dataPath;
+  QVector<PackedColor> m_secondColors;
+};
+
+void TestPaletteManager::initTestCase() {
+  QStandardPaths::setTestModeEnabled(true);
+  m_dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+  QDir(m_dataPath).removeRecursively();
+  QVERIFY(QDir().mkpath(m_dataPath));
+
+  // Only the current palette is loaded at startup; the rest stay in the
+  // mapped library until they are selected
+  m_secondColors = {ColorLogic::toPacked(Qt::green),
+                    ColorLogic::toPacked(Qt::blue)};
+  PaletteLibrary::Snapshot snapshot;
+  snapshot.currentPaletteId = QStringLiteral("first");
+  snapshot.palettes.append({QStringLiteral("first"), QStringLiteral("First"),
+                            {ColorLogic::toPacked(Qt::red)}});
+  snapshot.palettes.append(
+      {QStringLiteral("second"), QStringLiteral("Second"), m_secondColors});
+  QVERIFY(PaletteLibrary::write(snapshot, m_dataPath + "/palettes.lib"));
+
+  PaletteManager &manager = PaletteManager::instance();
+  manager.loadPalettes();
+  Palette *first = manager.getPalette(QStringLiteral("first"));
+  QVERIFY(first);
+  QCOMPARE(manager.currentPalette(), first);
+  QTRY_VERIFY(first->isLoaded());
+}
+
+void TestPaletteManager::cleanupTestCase() {
+  PaletteManager::instance().savePalettes();
+  QDir(m_dataPath).removeRecursively();
+}
+
+void TestPaletteManager::deletingCurrentLoadsReplacement() {
+  PaletteManager &manager = PaletteManager::instance();
+  Palette *second = manager.getPalette(QStringLiteral("second"));
+  QVERIFY(second);
+  QVERIFY(!second->isLoaded());
+
+  QSignalSpy currentChanged(&manager, &PaletteManager::currentPaletteChanged);
+  QSignalSpy colorsChanged(&manager, &PaletteManager::paletteColorsChanged);
+  QVERIFY(manager.deletePalette(QStringLiteral("first")));
+  QCOMPARE(manager.currentPalette(), second);
+  QCOMPARE(currentChanged.count(), 1);
+
+  // The colors arrive from the load pool, announced like any other load
+  QTRY_VERIFY(second->isLoaded());
+  QCOMPARE(keys(second->packedColors()), keys(m_secondColors));
+  QCOMPARE(colorsChanged.count(), 1);
+  QCOMPARE(colorsChanged.first().first().value<Palette *>(), second);
+}
+
+void TestPaletteManager::recentPaletteFollowsPicks() {
+  PaletteManager &manager = PaletteManager::instance();
+  Palette *recent = manager.recentPalette();
+  QVERIFY(recent);
+  QVERIFY(recent->packedColors().isEmpty());
+
+  // Repeats move from where the store last had them; the front stays put
+  QSignalSpy moved(&manager, &PaletteManager::colorMoved);
+  for (Qt::GlobalColor color :
+       {Qt::red, Qt::green, Qt::blue, Qt::green, Qt::red, Qt::red}) {
+    manager.addToRecentColors(color);
+  }
+  QCOMPARE(keys(recent->packedColors()),
+           keys({ColorLogic::toPacked(Qt::red), ColorLogic::toPacked(Qt::green),
+                 ColorLogic::toPacked(Qt::blue)}));
+  QCOMPARE(moved.count(), 2);
+  QCOMPARE(moved[0][1].toInt(), 1);
+  QCOMPARE(moved[1][1].toInt(), 2);
+}
+
+QTEST_GUILESS_MAIN(TestPaletteManager)
+#include "tst_palettemanager.moc"
@@ -0,0 +1,105 @@
+#include "../include/RecentColorsStore.h"
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <memory>
+
+namespace {
+
+QVector<quint64> keys(const QVector<PackedColor> &colors) {
+  QVector<quint64> result;
+  for (const PackedColor &color : colors) {
+    result.append(ColorLogic::packedKey(color));
+  }
+  return result;
+}
+
+PackedColor gray(int level) {
+  return ColorLogic::toPacked(QColor(level, level, level));
+}
+
+// The same picks applied to a plain most-recent-first list
+int touchReference(QVector<quint64> *order, int capacity, const PackedColor &color) {
+  const quint64 key = ColorLogic::packedKey(color);
+  const int previous = int(order->indexOf(key));
+  if (previous >= 0) {
+    order->remove(previous);
+  }
+  order->prepend(key);
+  if (order->size() > capacity) {
+    order->removeLast();
+  }
+  return previous;
+}
+
+} // namespace
+
+class TestRecentColorsStore : public QObject {
+  Q_OBJECT
+
+private slots:
+  void init();
+
+  void touchReportsPreviousPosition_data();
+  void touchReportsPreviousPosition();
+  void reopenKeepsOrder();
+
+private:
+  QString storePath() const { return m_dir->filePath("recent-colors.bin"); }
+
+  std::unique_ptr<QTemporaryDir> m_dir;
+};
+
+void TestRecentColorsStore::init() {
+  m_dir = std::make_unique<QTemporaryDir>();
+  QVERIFY(m_dir->isValid());
+}
+
+void TestRecentColorsStore::touchReportsPreviousPosition_data() {
+  QTest::addColumn<int>("capacity");
+
+  QTest::newRow("1") << 1;
+  QTest::newRow("3") << 3;
+  QTest::newRow("default") << int(RecentColorsStore::DEFAULT_CAPACITY);
+}
+
+void TestRecentColorsStore::touchReportsPreviousPosition() {
+  QFETCH(int, capacity);
+
+  RecentColorsStore store;
+  QVERIFY(store.open(storePath(), capacity));
+
+  // Twice as many colors as fit, so repeats, inserts and evictions mix, and
+  // enough picks for the order numbers to be renumbered many times
+  QRandomGenerator rng(1);
+  QVector<quint64> expected;
+  for (int step = 0; step < 5000; ++step) {
+    const PackedColor color = gray(rng.bounded(2 * capacity));
+    const int previous = touchReference(&expected, capacity, color);
+    QCOMPARE(store.touch(color), previous);
+  }
+  QCOMPARE(keys(store.colors()), expected);
+}
+
+void TestRecentColorsStore::reopenKeepsOrder() {
+  QVector<quint64> expected;
+  {
+    RecentColorsStore store;
+    QVERIFY(store.open(storePath(), 8));
+    for (int level : {10, 20, 30, 40, 20, 50}) {
+      touchReference(&expected, 8, gray(level));
+      store.touch(gray(level));
+    }
+  }
+
+  // Positions are rebuilt from the stamps on load
+  RecentColorsStore store;
+  QVERIFY(store.open(storePath(), 8));
+  QCOMPARE(keys(store.colors()), expected);
+  QCOMPARE(store.touch(gray(30)), int(expected.indexOf(ColorLogic::packedKey(gray(30)))));
+  QCOMPARE(store.touch(gray(30)), 0);
+  QCOMPARE(store.touch(gray(60)), -1);
+}
+
+QTEST_GUILESS_MAIN(TestRecentColorsStore)
+#include "tst_recentcolorsstore.moc"